@@ -0,0 +1,65 @@
+// SPDX-FileCopyrightText: 2024 David Andrs <andrsd@gmail.com>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace gmshparsercpp {
+
+/// Read-only view of a whole file in memory
+///
+/// The file is memory-mapped when the platform supports it. Otherwise (or if mapping fails) the
+/// file contents are read into an internal buffer, so callers always see one contiguous block of
+/// memory.
+class MappedFile {
+public:
+    /// Open and map a file
+    ///
+    /// @param file_name The file name
+    explicit MappedFile(const std::string & file_name);
+    MappedFile(const MappedFile &) = delete;
+    MappedFile & operator=(const MappedFile &) = delete;
+    ~MappedFile();
+
+    /// Query if the file was opened successfully
+    ///
+    /// @return `true` if the file contents are available, `false` otherwise
+    bool is_open() const;
+
+    /// Get the start of the file contents
+    ///
+    /// @return Pointer to the first byte of the file
+    const char * begin() const;
+
+    /// Get the end of the file contents
+    ///
+    /// @return Pointer one past the last byte of the file
+    const char * end() const;
+
+    /// Get the file size
+    ///
+    /// @return Size of the file in bytes
+    std::size_t size() const;
+
+    /// Release the mapping (or the buffer)
+    void close();
+
+private:
+    /// Read the whole file into `buffer`
+    bool read(const std::string & file_name);
+
+    /// Start of the file contents
+    const char * data;
+    /// Size of the file contents
+    std::size_t length;
+    /// Flag indicating if `data` points to a memory mapping
+    bool mapped;
+    /// Flag indicating if the file was opened
+    bool opened;
+    /// Storage used when the file could not be mapped
+    std::vector<char> buffer;
+};
+
+} // namespace gmshparsercpp
@@ -3,11 +3,12 @@
 
 #pragma once
 
+#include <functional>
 #include <string>
-#include <fstream>
 #include <vector>
 #include "gmshparsercpp/Enums.h"
 #include "gmshparsercpp/Exception.h"
+#include "gmshparsercpp/MappedFile.h"
 #include "gmshparsercpp/MshLexer.h"
 
 namespace gmshparsercpp {
@@ -105,14 +106,39 @@ public:
         bool parametric;
         /// Node tags
         std::vector<int> tags;
-        /// Coordinates
-        std::vector<Point> coordinates;
-        /// Parametric coordinates
-        std::vector<Point> par_coords;
+        /// Coordinates stored as `x0, y0, z0, x1, y1, z1, ...`
+        std::vector<double> coordinates;
+        /// Parametric coordinates stored as `u0, v0, w0, u1, v1, w1, ...` (unused components are
+        /// zero)
+        std::vector<double> par_coords;
 
         Node() : dimension(-1), entity_tag(-1), parametric(false) {}
+
+        /// Get number of nodes in this block
+        std::size_t
+        size() const
+        {
+            return this->tags.size();
+        }
+
+        /// Get coordinates of the i-th node
+        Point
+        get_coordinates(std::size_t i) const
+        {
+            const double * c = this->coordinates.data() + 3 * i;
+            return Point(c[0], c[1], c[2]);
+        }
+
+        /// Get parametric coordinates of the i-th node
+        Point
+        get_par_coords(std::size_t i) const
+        {
+            const double * c = this->par_coords.data() + 3 * i;
+            return Point(c[0], c[1], c[2]);
+        }
     };
 
+    /// Single element (compatibility view into an `ElementBlock`)
     struct Element {
         /// Element tag
         int tag;
@@ -129,10 +155,43 @@ public:
         int tag;
         /// Element type
         ElementType element_type;
-        /// Elements
-        std::vector<Element> elements;
+        /// Number of nodes per element
+        int nodes_per_element;
+        /// Element tags
+        std::vector<int> element_tags;
+        /// Node tags of all elements, `nodes_per_element` entries per element
+        std::vector<int> connectivity;
+
+        ElementBlock() : dimension(-1), tag(-1), element_type(NONE), nodes_per_element(0) {}
+
+        /// Get number of elements in this block
+        std::size_t
+        size() const
+        {
+            return this->element_tags.size();
+        }
+
+        /// Get node tags of the i-th element
+        ///
+        /// @return Pointer to `nodes_per_element` node tags
+        const int *
+        get_node_tags(std::size_t i) const
+        {
+            return this->connectivity.data() + i * this->nodes_per_element;
+        }
 
-        ElementBlock() : dimension(-1), tag(-1), element_type(NONE) {}
+        /// Get the i-th element
+        ///
+        /// NOTE: this copies the node tags, prefer `get_node_tags` in performance sensitive code
+        Element
+        get_element(std::size_t i) const
+        {
+            Element el;
+            el.tag = this->element_tags[i];
+            auto tags = get_node_tags(i);
+            el.node_tags.assign(tags, tags + this->nodes_per_element);
+            return el;
+        }
     };
 
     /// Construct MSH file
@@ -182,11 +241,45 @@ public:
     /// @return List of nodes
     const std::vector<Node> & get_nodes() const;
 
+    /// Get the smallest node tag
+    ///
+    /// @return The smallest node tag (0 if there are no nodes)
+    int get_min_node_tag() const;
+
+    /// Get the largest node tag
+    ///
+    /// Node tags are bounded by this value, so it can be used to size dense lookup tables.
+    ///
+    /// @return The largest node tag (0 if there are no nodes)
+    int get_max_node_tag() const;
+
     /// Get element blocks
     ///
     /// @return List of element blocks
     const std::vector<ElementBlock> & get_element_blocks() const;
 
+    /// Set the number of threads used for parsing
+    ///
+    /// Entity blocks of ASCII v4 files are split into chunks of lines that are parsed
+    /// concurrently. Binary files and v2 files are always parsed by the calling thread.
+    ///
+    /// @param n Number of threads (1 means no extra threads are spawned)
+    void set_num_threads(int n);
+
+    /// Callback reporting parsing progress
+    ///
+    /// @param bytes_read Number of bytes of the file processed so far
+    /// @param file_size Size of the file in bytes
+    using ProgressCallback = std::function<void(std::size_t bytes_read, std::size_t file_size)>;
+
+    /// Set the callback reporting parsing progress
+    ///
+    /// The callback is always invoked from the thread that calls `parse`, about every percent
+    /// of the file.
+    ///
+    /// @param callback Callback to invoke
+    void set_progress_callback(ProgressCallback callback);
+
     /// Parse the file
     void parse();
 
@@ -206,6 +299,24 @@ public:
     static int get_element_dimension(ElementType element_type);
 
 protected:
+    /// Part of an entity block that can be parsed independently
+    struct ParseJob {
+        enum EKind { NodeTags, NodeCoordinates, Elements };
+
+        /// What is parsed
+        EKind kind;
+        /// Index into `nodes` or `element_blocks`
+        std::size_t block;
+        /// Index of the first node/element in the block
+        std::size_t first;
+        /// Number of nodes/elements
+        std::size_t count;
+        /// Start of the text to parse
+        const char * begin;
+        /// End of the text to parse
+        const char * end;
+    };
+
     void process_section(const MshLexer::Token & token);
     void process_mesh_format_section();
     void process_physical_names_section();
@@ -219,12 +330,15 @@ protected:
     std::vector<int> process_array_of_ints();
     void skip_section();
     void read_end_section_marker(const std::string & section_name);
-    ElementBlock & get_element_block_by_tag_create(int tag);
+    void add_parse_jobs(ParseJob::EKind kind, std::size_t block, std::size_t n_lines);
+    void run_parse_jobs();
+    std::size_t get_element_block_create(int tag, ElementType element_type);
+    void report_progress(std::size_t bytes_read);
 
     /// File name
     std::string file_name;
-    /// Input stream
-    std::ifstream file;
+    /// File contents
+    MappedFile file;
     /// Lexer for lexicographic analysis
     MshLexer lexer;
     /// File format version
@@ -233,6 +347,14 @@ protected:
     bool binary;
     /// Endianness for binary files
     int endianness;
+    /// Number of threads used for parsing
+    int num_threads;
+    /// Pending jobs for parallel parsing
+    std::vector<ParseJob> parse_jobs;
+    /// Progress callback
+    ProgressCallback progress_callback;
+    /// Number of bytes processed when progress was last reported
+    std::size_t last_progress;
     /// Physical names
     std::vector<PhysicalName> physical_names;
     /// Point entities
@@ -245,6 +367,10 @@ protected:
     std::vector<MultiDEntity> volume_entities;
     /// Nodes
     std::vector<Node> nodes;
+    /// Smallest node tag
+    int min_node_tag;
+    /// Largest node tag
+    int max_node_tag;
     /// Element blocks
     std::vector<ElementBlock> element_blocks;
 };
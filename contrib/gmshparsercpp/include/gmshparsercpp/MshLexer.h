@@ -3,11 +3,34 @@
 
 #pragma once
 
-#include <fstream>
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 #include "gmshparsercpp/Exception.h"
 
 namespace gmshparsercpp {
 
+namespace detail {
+
+/// Reverse the byte order of a value
+template <typename T>
+inline T
+byte_swap(T val)
+{
+    char bytes[sizeof(T)];
+    std::memcpy(bytes, &val, sizeof(T));
+    for (std::size_t i = 0; i < sizeof(T) / 2; i++)
+        std::swap(bytes[i], bytes[sizeof(T) - 1 - i]);
+    std::memcpy(&val, bytes, sizeof(T));
+    return val;
+}
+
+} // namespace detail
+
 class MshLexer {
 public:
     struct Token {
@@ -15,8 +38,8 @@ public:
 
         ///
         EType type;
-        ///
-        std::string str;
+        /// Token text (points into the lexer input buffer)
+        std::string_view str;
         /// Line number
         int line_no;
 
@@ -28,26 +51,70 @@ public:
         }
     };
 
-    explicit MshLexer(std::ifstream * in);
+    /// Construct a lexer over a block of memory
+    ///
+    /// @param begin Start of the input
+    /// @param end One past the end of the input
+    MshLexer(const char * begin, const char * end);
 
     void set_binary(bool state);
 
-    /// Look at the next token awaiting in the input stream
+    /// Set if binary values need their bytes swapped (file endianness differs from ours)
+    void set_swap_bytes(bool state);
+
+    /// Get the current position in the input
+    const char * position() const;
+
+    /// Look at the next token awaiting in the input
     Token peek();
 
-    /// Read a token from the input stream
+    /// Read a token from the input
     Token read();
 
-    /// Read binary blob from the input stream
+    /// Skip lines of ASCII input
+    ///
+    /// If the input is in the middle of a line, the rest of that line is skipped first. Any token
+    /// obtained by `peek` is discarded.
+    ///
+    /// @param n Number of lines to skip
+    /// @param stride Record the start of every `stride`-th line
+    /// @param marks Receives the start of the first line, the start of every `stride`-th line and
+    ///        the position right after the last skipped line
+    void skip_lines(std::size_t n, std::size_t stride, std::vector<const char *> & marks);
+
+    /// Read binary blob from the input
     template <typename T>
     T
     read_blob()
     {
+        if (sizeof(T) > (std::size_t) (this->end - this->pos))
+            throw Exception("Reached end of file");
         T val;
-        this->in->read((char *) &val, sizeof(T));
+        std::memcpy(&val, this->pos, sizeof(T));
+        this->pos += sizeof(T);
+        if (this->swap_bytes)
+            val = detail::byte_swap(val);
         return val;
     }
 
+    /// Read an array of binary values from the input with a single copy
+    ///
+    /// @param out Destination array
+    /// @param n Number of values to read
+    template <typename T>
+    void
+    read_blob(T * out, std::size_t n)
+    {
+        auto n_bytes = n * sizeof(T);
+        if (n_bytes > (std::size_t) (this->end - this->pos))
+            throw Exception("Reached end of file");
+        std::memcpy(out, this->pos, n_bytes);
+        this->pos += n_bytes;
+        if (this->swap_bytes)
+            for (std::size_t i = 0; i < n; i++)
+                out[i] = detail::byte_swap(out[i]);
+    }
+
     template <typename T>
     T
     get()
@@ -58,30 +125,82 @@ public:
             return read().as<T>();
     }
 
+    /// Read `n` values into `out`
+    ///
+    /// Binary input is copied in bulk, ASCII input is converted token by token
+    template <typename T>
+    void
+    get(T * out, std::size_t n)
+    {
+        if (this->binary)
+            read_blob(out, n);
+        else
+            for (std::size_t i = 0; i < n; i++)
+                out[i] = read().as<T>();
+    }
+
 private:
-    /// Read a token from an input stream
+    /// Read a token from the input
     Token read_token();
-    /// Look at a character from an input stream without reading it
+    /// Look at a character from the input without reading it
     int peek_char();
-    /// Read a character from an input stream
+    /// Read a character from the input
     char read_char();
 
-    /// Input stream
-    std::ifstream * in;
+    /// Start of the input
+    const char * begin;
+    /// End of the input
+    const char * end;
+    /// Current position in the input
+    const char * pos;
     /// Flag indicating if we have a token cached
     bool have_token;
     /// Cached token
     Token curr;
     ///
     bool binary;
+    /// Swap bytes of binary values
+    bool swap_bytes;
 };
 
+namespace detail {
+
+/// Convert a token text into a number without any allocations
+template <typename T>
+inline T
+to_number(std::string_view str)
+{
+    T val;
+    auto last = str.data() + str.size();
+    auto [ptr, ec] = std::from_chars(str.data(), last, val);
+    if (ec != std::errc() || ptr != last)
+        throw Exception("Unable to convert '{}' into a number", str);
+    return val;
+}
+
+#if !defined(__cpp_lib_to_chars)
+/// Standard libraries without floating-point `from_chars` fall back to `strtod`
+template <>
+inline double
+to_number(std::string_view str)
+{
+    std::string s(str);
+    char * last;
+    auto val = std::strtod(s.c_str(), &last);
+    if (last != s.c_str() + s.size())
+        throw Exception("Unable to convert '{}' into a number", str);
+    return val;
+}
+#endif
+
+} // namespace detail
+
 template <>
 inline int
 MshLexer::Token::as() const
 {
     if (this->type == Number)
-        return std::stoi(this->str);
+        return detail::to_number<int>(this->str);
     else
         throw Exception("Token is not a number");
 }
@@ -91,7 +210,7 @@ inline size_t
 MshLexer::Token::as() const
 {
     if (this->type == Number)
-        return std::stol(this->str);
+        return detail::to_number<size_t>(this->str);
     else
         throw Exception("Token is not a number");
 }
@@ -101,7 +220,7 @@ inline double
 MshLexer::Token::as() const
 {
     if (this->type == Number)
-        return std::stod(this->str);
+        return detail::to_number<double>(this->str);
     else
         throw Exception("Token is not a number");
 }
@@ -111,7 +230,7 @@ inline std::string
 MshLexer::Token::as() const
 {
     if (this->type == String)
-        return this->str;
+        return std::string(this->str);
     else
         throw Exception("Token is not a string");
 }
@@ -0,0 +1,112 @@
+// SPDX-FileCopyrightText: 2024 David Andrs <andrsd@gmail.com>
+// SPDX-License-Identifier: MIT
+
+#include "gmshparsercpp/MappedFile.h"
+#include <fstream>
+#if defined(__unix__) || defined(__APPLE__)
+    #define GMSHPARSERCPP_HAVE_MMAP
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace gmshparsercpp {
+
+MappedFile::MappedFile(const std::string & file_name) :
+    data(nullptr),
+    length(0),
+    mapped(false),
+    opened(false)
+{
+#ifdef GMSHPARSERCPP_HAVE_MMAP
+    int fd = ::open(file_name.c_str(), O_RDONLY);
+    if (fd < 0)
+        return;
+
+    struct stat st;
+    if (::fstat(fd, &st) == 0) {
+        this->length = st.st_size;
+        if (this->length == 0)
+            this->opened = true;
+        else {
+            void * addr = ::mmap(nullptr, this->length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (addr != MAP_FAILED) {
+                ::madvise(addr, this->length, MADV_SEQUENTIAL);
+                this->data = static_cast<const char *>(addr);
+                this->mapped = true;
+                this->opened = true;
+            }
+        }
+    }
+    ::close(fd);
+#endif
+
+    if (!this->opened)
+        this->opened = read(file_name);
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+bool
+MappedFile::read(const std::string & file_name)
+{
+    std::ifstream in(file_name, std::ios::binary | std::ios::ate);
+    if (!in.is_open())
+        return false;
+
+    auto sz = in.tellg();
+    if (sz < 0)
+        return false;
+    this->buffer.resize(sz);
+    in.seekg(0);
+    if (!in.read(this->buffer.data(), this->buffer.size()))
+        return false;
+    this->data = this->buffer.data();
+    this->length = this->buffer.size();
+    return true;
+}
+
+bool
+MappedFile::is_open() const
+{
+    return this->opened;
+}
+
+const char *
+MappedFile::begin() const
+{
+    return this->data;
+}
+
+const char *
+MappedFile::end() const
+{
+    return this->data + this->length;
+}
+
+std::size_t
+MappedFile::size() const
+{
+    return this->length;
+}
+
+void
+MappedFile::close()
+{
+#ifdef GMSHPARSERCPP_HAVE_MMAP
+    if (this->mapped)
+        ::munmap(const_cast<char *>(this->data), this->length);
+#endif
+    this->buffer.clear();
+    this->buffer.shrink_to_fit();
+    this->data = nullptr;
+    this->length = 0;
+    this->mapped = false;
+    this->opened = false;
+}
+
+} // namespace gmshparsercpp
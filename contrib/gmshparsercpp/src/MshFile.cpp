@@ -3,17 +3,88 @@
 
 #include "gmshparsercpp/MshFile.h"
 #include "fmt/printf.h"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <map>
+#include <thread>
 #include <system_error>
 
 namespace gmshparsercpp {
 
+namespace {
+
+/// Number of lines of ASCII input parsed by one job
+const std::size_t LINES_PER_PARSE_JOB = 16384;
+
+void
+read_node_tags(MshLexer & lexer,
+               MshFile::Node & node,
+               std::size_t first,
+               std::size_t n,
+               std::vector<size_t> & tags)
+{
+    tags.resize(n);
+    lexer.get(tags.data(), tags.size());
+    std::copy(tags.begin(), tags.end(), node.tags.begin() + first);
+}
+
+void
+read_node_coordinates(MshLexer & lexer,
+                      MshFile::Node & node,
+                      std::size_t first,
+                      std::size_t n,
+                      std::vector<double> & coords)
+{
+    if (node.parametric) {
+        // each node is stored as x, y, z followed by `dimension` parametric coordinates
+        auto n_par_coords = std::max(node.dimension, 0);
+        auto n_values = 3 + n_par_coords;
+        coords.resize(n_values * n);
+        lexer.get(coords.data(), coords.size());
+        for (std::size_t j = 0; j < n; j++) {
+            const double * vals = coords.data() + n_values * j;
+            std::copy(vals, vals + 3, node.coordinates.data() + 3 * (first + j));
+            std::copy(vals + 3, vals + n_values, node.par_coords.data() + 3 * (first + j));
+        }
+    }
+    else
+        lexer.get(node.coordinates.data() + 3 * first, 3 * n);
+}
+
+void
+read_elements(MshLexer & lexer,
+              MshFile::ElementBlock & blk,
+              std::size_t first,
+              std::size_t n,
+              std::vector<size_t> & data)
+{
+    // each element is stored as its tag followed by its node tags
+    auto stride = 1 + blk.nodes_per_element;
+    data.resize(stride * n);
+    lexer.get(data.data(), data.size());
+
+    int * conn = blk.connectivity.data() + blk.nodes_per_element * first;
+    for (size_t j = 0; j < n; j++) {
+        const size_t * vals = data.data() + stride * j;
+        blk.element_tags[first + j] = vals[0];
+        conn = std::copy(vals + 1, vals + stride, conn);
+    }
+}
+
+} // namespace
+
 MshFile::MshFile(const std::string & file_name) :
     file_name(file_name),
     file(this->file_name),
-    lexer(&this->file),
+    lexer(this->file.begin(), this->file.end()),
     version(0.),
     binary(false),
-    endianness(0)
+    endianness(0),
+    num_threads(1),
+    last_progress(0),
+    min_node_tag(0),
+    max_node_tag(0)
 {
     if (!this->file.is_open())
         throw Exception("Unable to open file '{}'.", this->file_name);
@@ -72,25 +143,64 @@ MshFile::get_nodes() const
     return this->nodes;
 }
 
+int
+MshFile::get_min_node_tag() const
+{
+    return this->min_node_tag;
+}
+
+int
+MshFile::get_max_node_tag() const
+{
+    return this->max_node_tag;
+}
+
 const std::vector<MshFile::ElementBlock> &
 MshFile::get_element_blocks() const
 {
     return this->element_blocks;
 }
 
+void
+MshFile::set_num_threads(int n)
+{
+    this->num_threads = std::max(n, 1);
+}
+
+void
+MshFile::set_progress_callback(ProgressCallback callback)
+{
+    this->progress_callback = callback;
+}
+
+void
+MshFile::report_progress(std::size_t bytes_read)
+{
+    if (!this->progress_callback)
+        return;
+    auto file_size = this->file.size();
+    if (bytes_read == file_size || bytes_read >= this->last_progress + file_size / 100) {
+        this->last_progress = bytes_read;
+        this->progress_callback(bytes_read, file_size);
+    }
+}
+
 void
 MshFile::parse()
 {
+    this->last_progress = 0;
     MshLexer::Token token = this->lexer.peek();
     do {
         if (token.type == MshLexer::Token::Section) {
             token = this->lexer.read();
             process_section(token);
+            report_progress(this->lexer.position() - this->file.begin());
         }
         else
             throw Exception("Expected start of section marker not found.");
         token = this->lexer.peek();
     } while (token.type != MshLexer::Token::EndOfFile);
+    report_progress(this->file.size());
 }
 
 void
@@ -155,6 +265,7 @@ MshFile::process_mesh_format_section()
     read_end_section_marker("$EndMeshFormat");
 
     this->lexer.set_binary(this->binary);
+    this->lexer.set_swap_bytes(this->binary && this->endianness != 1);
 }
 
 void
@@ -249,19 +360,26 @@ void
 MshFile::process_nodes_section_v2()
 {
     auto num_nodes = this->lexer.read().as<size_t>();
-    for (auto i = 0; i < num_nodes; i++) {
-        Node node;
-        node.dimension = 0;
-        node.entity_tag = this->lexer.get<int>();
 
-        Point pt;
-        pt.x = this->lexer.get<double>();
-        pt.y = this->lexer.get<double>();
-        pt.z = this->lexer.get<double>();
-        node.coordinates.push_back(pt);
-        node.tags.push_back(node.entity_tag);
-        this->nodes.push_back(node);
+    // v2 files have no entities, so all nodes go into a single block
+    Node node;
+    node.dimension = 0;
+    node.entity_tag = 0;
+    node.tags.resize(num_nodes);
+    node.coordinates.resize(3 * num_nodes);
+    for (size_t i = 0; i < num_nodes; i++) {
+        node.tags[i] = this->lexer.get<int>();
+        double * c = node.coordinates.data() + 3 * i;
+        c[0] = this->lexer.get<double>();
+        c[1] = this->lexer.get<double>();
+        c[2] = this->lexer.get<double>();
     }
+    if (num_nodes > 0) {
+        auto [min_it, max_it] = std::minmax_element(node.tags.begin(), node.tags.end());
+        this->min_node_tag = *min_it;
+        this->max_node_tag = *max_it;
+    }
+    this->nodes.push_back(std::move(node));
 }
 
 void
@@ -269,38 +387,38 @@ MshFile::process_nodes_section_v4()
 {
     auto num_entity_blocks = this->lexer.get<size_t>();
     auto num_nodes = this->lexer.get<size_t>();
-    auto min_node_tag = this->lexer.get<size_t>();
-    auto max_node_tag = this->lexer.get<size_t>();
-
+    this->min_node_tag = this->lexer.get<size_t>();
+    this->max_node_tag = this->lexer.get<size_t>();
+
+    bool parallel = this->num_threads > 1 && !this->binary;
+    // scratch space reused by all entity blocks
+    std::vector<size_t> tags;
+    std::vector<double> coords;
+    this->nodes.reserve(this->nodes.size() + num_entity_blocks);
     for (int i = 0; i < num_entity_blocks; i++) {
         Node node;
         node.dimension = this->lexer.get<int>();
         node.entity_tag = this->lexer.get<int>();
         node.parametric = this->lexer.get<int>() == 1;
         auto num_nodes_in_block = this->lexer.get<size_t>();
-        for (std::size_t i = 0; i < num_nodes_in_block; i++) {
-            auto tag = this->lexer.get<size_t>();
-            node.tags.push_back(tag);
+        node.tags.resize(num_nodes_in_block);
+        node.coordinates.resize(3 * num_nodes_in_block);
+        if (node.parametric)
+            node.par_coords.assign(3 * num_nodes_in_block, 0.);
+        this->nodes.push_back(std::move(node));
+
+        auto idx = this->nodes.size() - 1;
+        if (parallel) {
+            add_parse_jobs(ParseJob::NodeTags, idx, num_nodes_in_block);
+            add_parse_jobs(ParseJob::NodeCoordinates, idx, num_nodes_in_block);
         }
-        for (std::size_t i = 0; i < num_nodes_in_block; i++) {
-            Point pt;
-            pt.x = this->lexer.get<double>();
-            pt.y = this->lexer.get<double>();
-            pt.z = this->lexer.get<double>();
-            node.coordinates.push_back(pt);
-            if (node.parametric) {
-                Point par_pr;
-                if (node.dimension >= 1)
-                    par_pr.x = this->lexer.get<double>();
-                if (node.dimension >= 2)
-                    par_pr.y = this->lexer.get<double>();
-                if (node.dimension == 3)
-                    par_pr.z = this->lexer.get<double>();
-                node.par_coords.push_back(par_pr);
-            }
+        else {
+            read_node_tags(this->lexer, this->nodes[idx], 0, num_nodes_in_block, tags);
+            read_node_coordinates(this->lexer, this->nodes[idx], 0, num_nodes_in_block, coords);
+            report_progress(this->lexer.position() - this->file.begin());
         }
-        this->nodes.push_back(node);
     }
+    run_parse_jobs();
 }
 
 void
@@ -318,51 +436,48 @@ void
 MshFile::process_elements_section_v2()
 {
     auto num_elements = this->lexer.read().as<size_t>();
+    // v2 elements are grouped into blocks by their physical tag and element type
+    std::map<std::pair<int, int>, size_t> block_index;
+    auto get_block = [&](int phys, ElementType el_type) -> ElementBlock & {
+        auto key = std::make_pair(phys, (int) el_type);
+        auto it = block_index.find(key);
+        if (it == block_index.end())
+            it = block_index.emplace(key, get_element_block_create(phys, el_type)).first;
+        return this->element_blocks[it->second];
+    };
+
     if (this->binary) {
-        for (auto i = 0; i < num_elements; i++) {
+        // elements are grouped under headers: (type, number of elements, number of tags)
+        std::vector<int> data;
+        for (size_t i = 0; i < num_elements;) {
             auto el_type = static_cast<ElementType>(this->lexer.get<int>());
-            auto dim = get_element_dimension(el_type);
             auto n_els = this->lexer.get<int>();
-            auto two = this->lexer.get<int>();
+            auto n_tags = this->lexer.get<int>();
+            auto n_elem_nodes = get_nodes_per_element(el_type);
+            auto stride = 1 + n_tags + n_elem_nodes;
+            data.resize((size_t) stride * n_els);
+            this->lexer.get(data.data(), data.size());
             for (auto k = 0; k < n_els; k++) {
-                Element el;
-
-                el.tag = this->lexer.get<int>();
-                auto phys = this->lexer.get<int>();
-                auto ent = this->lexer.get<int>();
-                auto n_elem_nodes = get_nodes_per_element(el_type);
-                for (auto j = 0; j < n_elem_nodes; j++) {
-                    auto nid = this->lexer.get<int>();
-                    el.node_tags.push_back(nid);
-                }
-                auto & blk = get_element_block_by_tag_create(phys);
-                blk.tag = phys;
-                blk.dimension = dim;
-                blk.element_type = el_type;
-                blk.elements.push_back(el);
+                const int * vals = data.data() + (size_t) stride * k;
+                auto phys = n_tags > 0 ? vals[1] : 0;
+                auto & blk = get_block(phys, el_type);
+                blk.element_tags.push_back(vals[0]);
+                blk.connectivity.insert(blk.connectivity.end(), vals + 1 + n_tags, vals + stride);
             }
+            i += n_els;
         }
     }
     else {
-        for (auto i = 0; i < num_elements; i++) {
-            Element el;
-            el.tag = this->lexer.get<int>();
+        for (size_t i = 0; i < num_elements; i++) {
+            auto tag = this->lexer.get<int>();
             auto el_type = static_cast<ElementType>(this->lexer.get<int>());
             auto two = this->lexer.get<int>();
             auto phys = this->lexer.get<int>();
             auto ent = this->lexer.get<int>();
-            auto dim = get_element_dimension(el_type);
-            auto n_elem_nodes = get_nodes_per_element(el_type);
-            for (auto j = 0; j < n_elem_nodes; j++) {
-                auto nid = this->lexer.get<size_t>();
-                el.node_tags.push_back(nid);
-            }
-
-            auto & blk = get_element_block_by_tag_create(phys);
-            blk.tag = phys;
-            blk.dimension = dim;
-            blk.element_type = el_type;
-            blk.elements.push_back(el);
+            auto & blk = get_block(phys, el_type);
+            blk.element_tags.push_back(tag);
+            for (auto j = 0; j < blk.nodes_per_element; j++)
+                blk.connectivity.push_back(this->lexer.get<int>());
         }
     }
 }
@@ -372,27 +487,108 @@ MshFile::process_elements_section_v4()
 {
     auto num_entity_blocks = this->lexer.get<size_t>();
     auto num_elements = this->lexer.get<size_t>();
-    auto min_node_tag = this->lexer.get<size_t>();
-    auto max_node_tag = this->lexer.get<size_t>();
+    auto min_element_tag = this->lexer.get<size_t>();
+    auto max_element_tag = this->lexer.get<size_t>();
 
+    bool parallel = this->num_threads > 1 && !this->binary;
+    // scratch space reused by all entity blocks
+    std::vector<size_t> data;
+    this->element_blocks.reserve(this->element_blocks.size() + num_entity_blocks);
     for (int i = 0; i < num_entity_blocks; i++) {
         ElementBlock blk;
         blk.dimension = this->lexer.get<int>();
         blk.tag = this->lexer.get<int>();
         blk.element_type = static_cast<ElementType>(this->lexer.get<int>());
-        auto num_nodes_per_element = get_nodes_per_element(blk.element_type);
+        blk.nodes_per_element = get_nodes_per_element(blk.element_type);
         auto num_elements_in_block = this->lexer.get<size_t>();
-        for (size_t j = 0; j < num_elements_in_block; j++) {
-            Element el;
-            el.tag = this->lexer.get<size_t>();
-            for (int k = 0; k < num_nodes_per_element; k++) {
-                auto tag = this->lexer.get<size_t>();
-                el.node_tags.push_back(tag);
-            }
-            blk.elements.push_back(el);
+        blk.element_tags.resize(num_elements_in_block);
+        blk.connectivity.resize(blk.nodes_per_element * num_elements_in_block);
+        this->element_blocks.push_back(std::move(blk));
+
+        auto idx = this->element_blocks.size() - 1;
+        if (parallel)
+            add_parse_jobs(ParseJob::Elements, idx, num_elements_in_block);
+        else {
+            read_elements(this->lexer, this->element_blocks[idx], 0, num_elements_in_block, data);
+            report_progress(this->lexer.position() - this->file.begin());
         }
-        this->element_blocks.push_back(blk);
     }
+    run_parse_jobs();
+}
+
+void
+MshFile::add_parse_jobs(ParseJob::EKind kind, std::size_t block, std::size_t n_lines)
+{
+    std::vector<const char *> marks;
+    this->lexer.skip_lines(n_lines, LINES_PER_PARSE_JOB, marks);
+    for (std::size_t i = 0; i + 1 < marks.size(); i++) {
+        auto first = i * LINES_PER_PARSE_JOB;
+        auto count = std::min(LINES_PER_PARSE_JOB, n_lines - first);
+        this->parse_jobs.push_back({ kind, block, first, count, marks[i], marks[i + 1] });
+    }
+}
+
+void
+MshFile::run_parse_jobs()
+{
+    if (this->parse_jobs.empty())
+        return;
+
+    auto n_workers = std::min<std::size_t>(this->num_threads, this->parse_jobs.size());
+    std::atomic<std::size_t> next_job(0);
+    // bytes of the parsed jobs, reported by the calling thread only
+    std::size_t first_byte = this->parse_jobs.front().begin - this->file.begin();
+    std::atomic<std::size_t> bytes_done(0);
+    std::vector<std::exception_ptr> errors(n_workers);
+    auto worker = [&](std::size_t id) {
+        std::vector<size_t> tags;
+        std::vector<double> coords;
+        try {
+            for (auto j = next_job++; j < this->parse_jobs.size(); j = next_job++) {
+                const auto & job = this->parse_jobs[j];
+                MshLexer lexer(job.begin, job.end);
+                switch (job.kind) {
+                case ParseJob::NodeTags:
+                    read_node_tags(lexer, this->nodes[job.block], job.first, job.count, tags);
+                    break;
+                case ParseJob::NodeCoordinates:
+                    read_node_coordinates(lexer,
+                                          this->nodes[job.block],
+                                          job.first,
+                                          job.count,
+                                          coords);
+                    break;
+                case ParseJob::Elements:
+                    read_elements(lexer,
+                                  this->element_blocks[job.block],
+                                  job.first,
+                                  job.count,
+                                  tags);
+                    break;
+                }
+                bytes_done += job.end - job.begin;
+                if (id == 0)
+                    report_progress(first_byte + bytes_done);
+            }
+        }
+        catch (...) {
+            errors[id] = std::current_exception();
+            // make the other workers stop
+            next_job = this->parse_jobs.size();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (std::size_t i = 1; i < n_workers; i++)
+        threads.emplace_back(worker, i);
+    worker(0);
+    for (auto & t : threads)
+        t.join();
+    this->parse_jobs.clear();
+
+    for (auto & e : errors)
+        if (e)
+            std::rethrow_exception(e);
 }
 
 std::vector<int>
@@ -510,16 +706,21 @@ MshFile::get_element_dimension(ElementType element_type)
     }
 }
 
-MshFile::ElementBlock &
-MshFile::get_element_block_by_tag_create(int tag)
+std::size_t
+MshFile::get_element_block_create(int tag, ElementType element_type)
 {
-    for (auto & eblk : this->element_blocks) {
-        if (eblk.tag == tag)
-            return eblk;
+    for (std::size_t i = 0; i < this->element_blocks.size(); i++) {
+        auto & eblk = this->element_blocks[i];
+        if (eblk.tag == tag && eblk.element_type == element_type)
+            return i;
     }
     ElementBlock blk;
+    blk.dimension = get_element_dimension(element_type);
+    blk.tag = tag;
+    blk.element_type = element_type;
+    blk.nodes_per_element = get_nodes_per_element(element_type);
     this->element_blocks.push_back(blk);
-    return this->element_blocks.back();
+    return this->element_blocks.size() - 1;
 }
 
 void
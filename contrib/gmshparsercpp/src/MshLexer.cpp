@@ -2,11 +2,30 @@
 // SPDX-License-Identifier: MIT
 
 #include "gmshparsercpp/MshLexer.h"
-#include <iostream>
+#include <cstring>
 
 namespace gmshparsercpp {
 
-MshLexer::MshLexer(std::ifstream * in) : in(in), have_token(false), binary(false) {}
+namespace {
+
+inline bool
+is_space(int ch)
+{
+    return ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n';
+}
+
+} // namespace
+
+MshLexer::MshLexer(const char * begin, const char * end) :
+    begin(begin),
+    end(end),
+    pos(begin),
+    have_token(false),
+    curr({ Token::EndOfFile, std::string_view(), -1 }),
+    binary(false),
+    swap_bytes(false)
+{
+}
 
 void
 MshLexer::set_binary(bool state)
@@ -14,6 +33,12 @@ MshLexer::set_binary(bool state)
     this->binary = state;
 }
 
+void
+MshLexer::set_swap_bytes(bool state)
+{
+    this->swap_bytes = state;
+}
+
 MshLexer::Token
 MshLexer::read()
 {
@@ -22,6 +47,12 @@ MshLexer::read()
     return this->curr;
 }
 
+const char *
+MshLexer::position() const
+{
+    return this->pos;
+}
+
 MshLexer::Token
 MshLexer::peek()
 {
@@ -32,66 +63,78 @@ MshLexer::peek()
     return this->curr;
 }
 
+void
+MshLexer::skip_lines(std::size_t n, std::size_t stride, std::vector<const char *> & marks)
+{
+    auto next_line = [this](const char * p) {
+        auto eol = static_cast<const char *>(std::memchr(p, '\n', this->end - p));
+        if (eol == nullptr)
+            throw Exception("Reached end of file");
+        return eol + 1;
+    };
+
+    this->have_token = false;
+    if (this->pos > this->begin && this->pos[-1] != '\n')
+        this->pos = next_line(this->pos);
+    marks.push_back(this->pos);
+    for (std::size_t i = 1; i <= n; i++) {
+        this->pos = next_line(this->pos);
+        if (i % stride == 0 || i == n)
+            marks.push_back(this->pos);
+    }
+}
+
 MshLexer::Token
 MshLexer::read_token()
 {
     while (true) {
-        if (this->in->peek() == EOF) {
-            Token t = { Token::EndOfFile, "", -1 };
+        if (this->pos >= this->end) {
+            Token t = { Token::EndOfFile, std::string_view(), -1 };
             return t;
         }
 
-        std::string str_tok;
+        const char * start = this->pos;
         char ch = read_char();
         if (ch == '$') {
             // $SectionName
-            str_tok += ch;
             while (true) {
                 auto next = peek_char();
                 if ((next >= 'A' && next <= 'Z') || (next >= 'a' && next <= 'z')) {
-                    str_tok += read_char();
+                    read_char();
                 }
                 else {
+                    std::string_view str(start, this->pos - start);
                     // read the delimiting char
                     read_char();
-                    Token token = { Token::Section, str_tok, -1 };
+                    Token token = { Token::Section, str, -1 };
                     return token;
                 }
             }
         }
         else if (ch == '"') {
             // "string"
-            while (true) {
-                auto next = peek_char();
-                if (next == '"') {
-                    read_char();
-                    break;
-                }
-                else
-                    str_tok += read_char();
-            }
+            start = this->pos;
+            while (peek_char() != '"')
+                read_char();
+            std::string_view str(start, this->pos - start);
+            read_char();
 
-            Token token = { Token::String, str_tok, -1 };
+            Token token = { Token::String, str, -1 };
             return token;
         }
-        else if (ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n') {
+        else if (is_space(ch)) {
             // skip white spaces
             continue;
         }
         else {
             // numbers
-            str_tok += ch;
-            while (true) {
-                auto next = peek_char();
-                if (next == ' ' || next == '\t' || next == '\n' || next == '\r') {
-                    // read the delimiting char
-                    read_char();
-                    Token token = { Token::Number, str_tok, -1 };
-                    return token;
-                }
-                else
-                    str_tok += read_char();
-            }
+            while (!is_space(peek_char()))
+                read_char();
+            std::string_view str(start, this->pos - start);
+            // read the delimiting char
+            read_char();
+            Token token = { Token::Number, str, -1 };
+            return token;
         }
     }
 }
@@ -99,20 +142,17 @@ MshLexer::read_token()
 char
 MshLexer::read_char()
 {
-    char ch;
-    this->in->read(&ch, sizeof(ch));
-    if (ch == EOF)
+    if (this->pos >= this->end)
         throw Exception("Reached end of file");
-    return ch;
+    return *this->pos++;
 }
 
 int
 MshLexer::peek_char()
 {
-    auto ch = this->in->peek();
-    if (ch == EOF)
+    if (this->pos >= this->end)
         throw Exception("Reached end of file");
-    return ch;
+    return *this->pos;
 }
 
 } // namespace gmshparsercpp
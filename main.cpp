@@ -6,12 +6,16 @@
 #include <QApplication>
 #include <QCommandLineParser>
 #include "QVTKOpenGLNativeWidget.h"
+#include "vtkSMPTools.h"
 #include "common/loadfileevent.h"
 
 int
 main(int argc, char * argv[])
 {
     QSurfaceFormat::setDefaultFormat(QVTKOpenGLNativeWidget::defaultFormat());
+    // use all cores in VTK's parallel algorithms, unless the backend was chosen via environment
+    if (qEnvironmentVariableIsEmpty("VTK_SMP_BACKEND_IN_USE"))
+        vtkSMPTools::SetBackend("STDThread");
 
     QApplication app(argc, argv);
     QCoreApplication::setApplicationName(MESH_INSPECTOR_APP_NAME);
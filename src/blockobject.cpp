@@ -10,11 +10,9 @@
 #include "vtkFieldData.h"
 #include "vtkCellData.h"
 #include "vtkUnstructuredGrid.h"
-#include "vtkDoubleArray.h"
 #include "vtkAlgorithmOutput.h"
-#include "meshqualitytool.h"
 
-BlockObject::BlockObject(vtkAlgorithmOutput * alg_output, vtkCamera * camera) :
+BlockObject::BlockObject(vtkAlgorithmOutput * alg_output) :
     MeshObject(alg_output),
     grid(nullptr),
     silhouette(nullptr),
@@ -31,45 +29,21 @@ BlockObject::BlockObject(vtkAlgorithmOutput * alg_output, vtkCamera * camera) :
 
             auto unstr_grid = dynamic_cast<vtkUnstructuredGrid *>(blk);
             if (unstr_grid)
-                setUpCellQuality(unstr_grid);
+                this->grid = unstr_grid;
             else
                 std::cerr << "Unknown block type" << std::endl;
         }
-        modified();
-        update();
-    }
-    else if (do_class == "vtkUnstructuredGrid") {
-        auto unstr_grid = dynamic_cast<vtkUnstructuredGrid *>(this->data_object);
-        setUpCellQuality(unstr_grid);
-        modified();
-        update();
     }
+    else if (do_class == "vtkUnstructuredGrid")
+        this->grid = dynamic_cast<vtkUnstructuredGrid *>(this->data_object);
 
     this->actor->VisibilityOn();
 
     this->color = QColor::fromRgbF(1., 1., 1.);
-
-    this->setUpSilhouette(camera);
 }
 
 BlockObject::~BlockObject() {}
 
-void
-BlockObject::setUpCellQuality(vtkUnstructuredGrid * unstr_grid)
-{
-    this->grid = unstr_grid;
-    auto n_cells = unstr_grid->GetNumberOfCells();
-
-    auto cell_quality = vtkSmartPointer<vtkDoubleArray>::New();
-    cell_quality->SetNumberOfTuples(n_cells);
-    for (vtkIdType i = 0; i < n_cells; i++)
-        cell_quality->SetValue(i, (double) i);
-    cell_quality->SetName(MeshQualityTool::MESH_QUALITY_FIELD_NAME);
-
-    auto cell_data = unstr_grid->GetCellData();
-    cell_data->AddArray(cell_quality);
-}
-
 void
 BlockObject::modified()
 {
@@ -18,11 +18,17 @@ class vtkUnstructuredGrid;
 
 class BlockObject : public MeshObject {
 public:
-    BlockObject(vtkAlgorithmOutput * alg_output, vtkCamera * camera);
+    explicit BlockObject(vtkAlgorithmOutput * alg_output);
     ~BlockObject() override;
     void modified() override;
     void update() override;
 
+    /// Set up the silhouette rendered with a camera
+    ///
+    /// Must be called on the GUI thread before the block is added to the view, the camera is in
+    /// use by the renderer.
+    void setUpSilhouette(vtkCamera * camera);
+
     vtkActor * getSilhouetteActor();
     vtkProperty * getSilhouetteProperty();
     const QColor & getColor();
@@ -34,9 +40,6 @@ public:
     vtkUnstructuredGrid * getUnstructuredGrid() const;
 
 protected:
-    void setUpCellQuality(vtkUnstructuredGrid * unstr_grid);
-    void setUpSilhouette(vtkCamera * camera);
-
     vtkUnstructuredGrid * grid;
     vtkSmartPointer<vtkPolyDataSilhouette> silhouette;
     vtkSmartPointer<vtkPolyDataMapper> silhouette_mapper;
@@ -0,0 +1,146 @@
+// SPDX-FileCopyrightText: 2024 David Andrs <andrsd@gmail.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "cachereader.h"
+#include "vtkTrivialProducer.h"
+#include "vtkDataObject.h"
+#include "vtkDataObjectTree.h"
+#include "vtkDataObjectTreeIterator.h"
+
+namespace {
+
+/// Find a data object by its flat index (the index used by vtkExtractBlock)
+vtkDataObject *
+findByFlatIndex(vtkDataObject * root, int flat_index)
+{
+    auto * tree = vtkDataObjectTree::SafeDownCast(root);
+    if (tree == nullptr)
+        return flat_index == 0 ? root : nullptr;
+
+    auto it = vtkSmartPointer<vtkDataObjectTreeIterator>::Take(tree->NewTreeIterator());
+    it->VisitOnlyLeavesOff();
+    it->SkipEmptyNodesOff();
+    for (it->InitTraversal(); !it->IsDoneWithTraversal(); it->GoToNextItem())
+        if ((int) it->GetCurrentFlatIndex() == flat_index)
+            return it->GetCurrentDataObject();
+    return nullptr;
+}
+
+} // namespace
+
+CacheReader::CacheReader(const std::string & file_name,
+                         std::shared_ptr<MeshCache> cache,
+                         std::shared_ptr<Reader> fallback) :
+    Reader(file_name),
+    cache(cache),
+    fallback(fallback),
+    use_fallback(false)
+{
+}
+
+CacheReader::~CacheReader() {}
+
+void
+CacheReader::load()
+{
+    if (this->cache->read(this->contents) && this->contents.data != nullptr) {
+        this->producer = vtkSmartPointer<vtkTrivialProducer>::New();
+        this->producer->SetOutput(this->contents.data);
+        this->producer->Update();
+        reportProgress(1.);
+    }
+    else {
+        this->cache->remove();
+        this->use_fallback = true;
+        this->fallback->setProgressCallback(this->progress_callback);
+        this->fallback->setBlockLoadedCallback(this->block_loaded_callback);
+        this->fallback->load();
+    }
+}
+
+std::size_t
+CacheReader::getTotalNumberOfElements() const
+{
+    if (this->use_fallback)
+        return this->fallback->getTotalNumberOfElements();
+    else
+        return this->contents.total_elements;
+}
+
+std::size_t
+CacheReader::getTotalNumberOfNodes() const
+{
+    if (this->use_fallback)
+        return this->fallback->getTotalNumberOfNodes();
+    else
+        return this->contents.total_nodes;
+}
+
+int
+CacheReader::getDimensionality() const
+{
+    if (this->use_fallback)
+        return this->fallback->getDimensionality();
+    else
+        return this->contents.dimensionality;
+}
+
+vtkAlgorithmOutput *
+CacheReader::getVtkOutputPort()
+{
+    if (this->use_fallback)
+        return this->fallback->getVtkOutputPort();
+    else
+        return this->producer->GetOutputPort(0);
+}
+
+std::vector<Reader::BlockInformation>
+CacheReader::getBlocks()
+{
+    if (this->use_fallback)
+        return this->fallback->getBlocks();
+    else
+        return this->contents.blocks;
+}
+
+std::vector<Reader::BlockInformation>
+CacheReader::getSideSets()
+{
+    if (this->use_fallback)
+        return this->fallback->getSideSets();
+    else
+        return this->contents.side_sets;
+}
+
+std::vector<Reader::BlockInformation>
+CacheReader::getNodeSets()
+{
+    if (this->use_fallback)
+        return this->fallback->getNodeSets();
+    else
+        return this->contents.node_sets;
+}
+
+bool
+CacheReader::isObjectLoaded(const BlockInformation & info)
+{
+    if (this->use_fallback)
+        return this->fallback->isObjectLoaded(info);
+    else if (info.multiblock_index == -1)
+        return true;
+    else
+        return findByFlatIndex(this->contents.data, info.multiblock_index) != nullptr;
+}
+
+vtkAlgorithmOutput *
+CacheReader::loadObject(const BlockInformation & info)
+{
+    // objects missing in the cache entry are read from the mesh file
+    return this->fallback->loadObject(info);
+}
+
+bool
+CacheReader::isFallbackUsed() const
+{
+    return this->use_fallback;
+}
@@ -0,0 +1,48 @@
+// SPDX-FileCopyrightText: 2024 David Andrs <andrsd@gmail.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include "reader.h"
+#include "meshcache.h"
+#include "vtkSmartPointer.h"
+#include <memory>
+
+class vtkTrivialProducer;
+
+/// Reader that loads a mesh from the mesh cache
+///
+/// If the cache entry cannot be read, the entry is removed and the mesh is loaded by the fallback
+/// reader instead. The mesh can then be stored into the cache again, the reader forwards the
+/// output of the fallback reader.
+class CacheReader : public Reader {
+public:
+    CacheReader(const std::string & file_name,
+                std::shared_ptr<MeshCache> cache,
+                std::shared_ptr<Reader> fallback);
+    ~CacheReader() override;
+
+    void load() override;
+    std::size_t getTotalNumberOfElements() const override;
+    std::size_t getTotalNumberOfNodes() const override;
+    int getDimensionality() const override;
+
+    vtkAlgorithmOutput * getVtkOutputPort() override;
+    std::vector<Reader::BlockInformation> getBlocks() override;
+    std::vector<Reader::BlockInformation> getSideSets() override;
+    std::vector<Reader::BlockInformation> getNodeSets() override;
+
+    bool isObjectLoaded(const BlockInformation & info) override;
+    vtkAlgorithmOutput * loadObject(const BlockInformation & info) override;
+
+    /// Query if the mesh was loaded by the fallback reader (the cache entry was not valid)
+    bool isFallbackUsed() const;
+
+protected:
+    std::shared_ptr<MeshCache> cache;
+    std::shared_ptr<Reader> fallback;
+    /// `true` if the mesh was loaded by the fallback reader
+    bool use_fallback;
+    MeshCache::Contents contents;
+    vtkSmartPointer<vtkTrivialProducer> producer;
+};
@@ -0,0 +1,169 @@
+// SPDX-FileCopyrightText: 2024 David Andrs <andrsd@gmail.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "clipcutter.h"
+#include "sliceindex.h"
+#include <QThread>
+#include <QTimer>
+#include "vtkCompositeDataSet.h"
+#include "vtkCompositeDataGeometryFilter.h"
+#include "vtkExtractCells.h"
+#include "vtkGeometryFilter.h"
+#include "vtkPlaneCutter.h"
+#include "vtkPlane.h"
+#include "vtkPolyData.h"
+#include "vtkPolyDataAlgorithm.h"
+#include "vtkSMPTools.h"
+#include "vtkUnstructuredGrid.h"
+
+namespace {
+
+/// Time the plane has to stay still before it is cut, in milliseconds
+const int SETTLE_DELAY = 150;
+
+} // namespace
+
+ClipCutter::ClipCutter(PrepareCallback prepare, ResultCallback done) :
+    QObject(),
+    prepare(prepare),
+    done(done),
+    thread(new QThread()),
+    worker(new QObject()),
+    settle(new QTimer(this)),
+    busy(false),
+    pending(false),
+    generation(0)
+{
+    this->worker->moveToThread(this->thread);
+    this->settle->setSingleShot(true);
+    connect(this->settle, &QTimer::timeout, this, &ClipCutter::start);
+    this->thread->start();
+}
+
+ClipCutter::~ClipCutter()
+{
+    this->thread->quit();
+    this->thread->wait();
+    delete this->worker;
+    delete this->thread;
+}
+
+void
+ClipCutter::request()
+{
+    // the running cut is outdated now
+    this->generation++;
+    this->pending = true;
+    this->settle->start(SETTLE_DELAY);
+}
+
+void
+ClipCutter::cancel()
+{
+    this->pending = false;
+    this->generation++;
+    this->settle->stop();
+}
+
+void
+ClipCutter::clearIndices()
+{
+    // queued behind the running cut, which may still use them
+    QMetaObject::invokeMethod(
+        this->worker,
+        [this]() { this->indices.clear(); },
+        Qt::QueuedConnection);
+}
+
+void
+ClipCutter::start()
+{
+    if (this->busy || !this->pending)
+        return;
+
+    this->pending = false;
+    Request request;
+    if (!this->prepare(request))
+        return;
+
+    this->busy = true;
+    auto generation = this->generation;
+    QMetaObject::invokeMethod(
+        this->worker,
+        [this, request, generation]() {
+            auto surfaces = cut(request, this->indices);
+            QMetaObject::invokeMethod(
+                this,
+                [this, surfaces, generation]() { onCut(surfaces, generation); },
+                Qt::QueuedConnection);
+        },
+        Qt::QueuedConnection);
+}
+
+void
+ClipCutter::onCut(const std::vector<Surface> & surfaces, quint64 generation)
+{
+    this->busy = false;
+    if (generation == this->generation)
+        this->done(surfaces);
+    if (this->pending && !this->settle->isActive())
+        start();
+}
+
+std::vector<ClipCutter::Surface>
+ClipCutter::cut(const Request & request, Indices & indices)
+{
+    auto n = (vtkIdType) request.targets.size();
+    std::vector<Surface> surfaces(n);
+    // entries are created up front, so that tasks do not modify the map
+    std::vector<std::shared_ptr<SliceIndex> *> block_indices(n);
+    for (vtkIdType i = 0; i < n; i++)
+        block_indices[i] = &indices[request.targets[i].block_id];
+
+    // one block per task, a single block is cut by the parallel cutter alone
+    vtkSMPTools::For(0, n, 1, [&](vtkIdType begin, vtkIdType end) {
+        for (vtkIdType i = begin; i < end; i++) {
+            auto & target = request.targets[i];
+
+            auto plane = vtkSmartPointer<vtkPlane>::New();
+            plane->SetOrigin(request.origin[0], request.origin[1], request.origin[2]);
+            plane->SetNormal(request.normal[0], request.normal[1], request.normal[2]);
+
+            // only cells straddling the plane are passed to the cutter
+            vtkSmartPointer<vtkDataObject> input = target.data_object;
+            auto * grid = vtkUnstructuredGrid::SafeDownCast(target.data_object);
+            if (grid != nullptr) {
+                auto & index = *block_indices[i];
+                if (index == nullptr || !index->hasNormal(request.normal))
+                    index = SliceIndex::fromCells(grid, request.normal);
+                auto cell_ids = index->query(request.origin);
+
+                auto extract = vtkSmartPointer<vtkExtractCells>::New();
+                extract->SetInputData(grid);
+                extract->SetCellIds(cell_ids.data(), (vtkIdType) cell_ids.size());
+                extract->AssumeSortedAndUniqueIdsOn();
+                extract->Update();
+                input = extract->GetOutput();
+            }
+
+            auto cutter = vtkSmartPointer<vtkPlaneCutter>::New();
+            cutter->SetInputData(input);
+            cutter->SetPlane(plane);
+
+            vtkSmartPointer<vtkPolyDataAlgorithm> geometry;
+            if (vtkCompositeDataSet::SafeDownCast(target.data_object))
+                geometry = vtkSmartPointer<vtkCompositeDataGeometryFilter>::New();
+            else
+                geometry = vtkSmartPointer<vtkGeometryFilter>::New();
+            geometry->SetInputConnection(cutter->GetOutputPort());
+            geometry->Update();
+
+            // detached from the filters, so that it outlives them
+            auto poly_data = vtkSmartPointer<vtkPolyData>::New();
+            poly_data->ShallowCopy(geometry->GetOutput());
+            surfaces[i].block_id = target.block_id;
+            surfaces[i].poly_data = poly_data;
+        }
+    });
+    return surfaces;
+}
@@ -0,0 +1,98 @@
+// SPDX-FileCopyrightText: 2024 David Andrs <andrsd@gmail.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <QObject>
+#include <functional>
+#include <map>
+#include <memory>
+#include <vector>
+#include "vtkSmartPointer.h"
+
+class QThread;
+class QTimer;
+class vtkDataObject;
+class vtkPolyData;
+class SliceIndex;
+
+/// Cuts blocks by the clip plane in a worker thread
+///
+/// A cut starts only after the plane has not moved for a while, so that dragging the plane does
+/// not queue cuts that would be outdated before they are shown. Only one cut runs at a time and
+/// only the latest plane is cut next. Results of cuts started before the plane moved again are
+/// dropped. Requests are prepared on the GUI thread right before their cut starts.
+///
+/// Unstructured grids are cut only in cells found by a `SliceIndex`, which is kept between cuts
+/// and rebuilt when the normal of the plane changes.
+class ClipCutter : public QObject {
+public:
+    /// Block to cut
+    struct Target {
+        int block_id;
+        /// Data of the block, must not be modified while the cut runs
+        vtkSmartPointer<vtkDataObject> data_object;
+    };
+
+    /// Cut request
+    struct Request {
+        double origin[3];
+        double normal[3];
+        std::vector<Target> targets;
+    };
+
+    /// Cut surface of a block
+    struct Surface {
+        int block_id;
+        vtkSmartPointer<vtkPolyData> poly_data;
+    };
+
+    /// Prepare a request for a cut by the current plane
+    ///
+    /// @return `false` if there is nothing to cut
+    using PrepareCallback = std::function<bool(Request & request)>;
+    /// Receive cut surfaces (called on the GUI thread)
+    using ResultCallback = std::function<void(const std::vector<Surface> & surfaces)>;
+
+    ClipCutter(PrepareCallback prepare, ResultCallback done);
+    ~ClipCutter() override;
+
+    /// Request a cut by the current plane once the plane settles
+    void request();
+
+    /// Drop the pending request and the result of the running cut
+    void cancel();
+
+    /// Drop indices of cells of all blocks (when blocks change or are no longer cut)
+    void clearIndices();
+
+    /// Indices of cells of blocks
+    using Indices = std::map<int, std::shared_ptr<SliceIndex>>;
+
+    /// Cut blocks of a request, blocks are cut in parallel
+    ///
+    /// Can be called from any thread.
+    ///
+    /// @param indices Indices of cells of blocks, missing or outdated ones are (re)built
+    static std::vector<Surface> cut(const Request & request, Indices & indices);
+
+protected:
+    void start();
+    void onCut(const std::vector<Surface> & surfaces, quint64 generation);
+
+    PrepareCallback prepare;
+    ResultCallback done;
+    QThread * thread;
+    /// Object living in `thread`, cuts are executed in its context
+    QObject * worker;
+    /// Delays the start of a cut until the plane settles
+    QTimer * settle;
+    /// Is a cut running
+    bool busy;
+    /// Is there a request waiting for a cut
+    bool pending;
+    /// Results of cuts started in older generations are dropped
+    quint64 generation;
+    /// Indices used by cuts, accessed only in `thread`
+    Indices indices;
+};
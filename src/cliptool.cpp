@@ -6,6 +6,7 @@
 #include "mainwindow.h"
 #include "model.h"
 #include "blockobject.h"
+#include "view.h"
 #include "vtkPlane.h"
 #include "vtkVector.h"
 #include <QSettings>
@@ -14,14 +15,27 @@ ClipTool::ClipTool(MainWindow * main_wnd) :
     main_window(main_wnd),
     model(main_wnd->getModel()),
     widget(nullptr),
+    cutter(nullptr),
     clip_plane(vtkSmartPointer<vtkPlane>::New()),
     normal(0, 0, 1),
     normal_ori(1.)
 {
+    this->cutter = new ClipCutter(
+        [this](ClipCutter::Request & request) {
+            if (this->widget == nullptr || !this->widget->isVisible())
+                return false;
+            this->clip_plane->GetOrigin(request.origin);
+            this->clip_plane->GetNormal(request.normal);
+            for (auto & [id, block] : this->model->getBlocks())
+                request.targets.push_back({ id, block->getSnapshot() });
+            return !request.targets.empty();
+        },
+        [this](const std::vector<ClipCutter::Surface> & surfaces) { onCut(surfaces); });
 }
 
 ClipTool::~ClipTool()
 {
+    delete this->cutter;
     delete this->widget;
 }
 
@@ -92,6 +106,8 @@ ClipTool::onClip()
 void
 ClipTool::onClose()
 {
+    this->cutter->cancel();
+    this->cutter->clearIndices();
     for (auto & [id, block] : this->model->getBlocks()) {
         block->setClip(false);
     }
@@ -101,14 +117,17 @@ void
 ClipTool::clipBlocks()
 {
     for (auto & [id, block] : this->model->getBlocks()) {
-        block->setClip(true);
         block->setClipPlane(this->clip_plane);
+        block->setClip(true);
     }
+    this->cutter->request();
 }
 
 void
 ClipTool::onPlaneChanged(int id)
 {
+    // indices of cells are built for the normal of the plane
+    this->cutter->clearIndices();
     if (id == 0)
         setPlaneNormal(QVector3D(1, 0, 0));
     else if (id == 1)
@@ -122,7 +141,6 @@ ClipTool::onPlaneNormalFlipped()
 {
     this->normal_ori *= -1;
     setPlaneNormal(this->normal);
-    updateModelBlocks();
 }
 
 void
@@ -138,9 +156,21 @@ ClipTool::updateModelBlocks()
 {
     for (auto & [id, block] : this->model->getBlocks()) {
         block->setClipPlane(this->clip_plane);
-        block->modified();
-        block->update();
+        block->updateClip();
+    }
+    this->cutter->request();
+}
+
+void
+ClipTool::onCut(const std::vector<ClipCutter::Surface> & surfaces)
+{
+    auto & blocks = this->model->getBlocks();
+    for (auto & surface : surfaces) {
+        auto it = blocks.find(surface.block_id);
+        if (it != blocks.end())
+            it->second->setCutSurface(surface.poly_data);
     }
+    this->main_window->getView()->render();
 }
 
 void
@@ -4,6 +4,7 @@
 #pragma once
 
 #include "clipwidget.h"
+#include "clipcutter.h"
 #include <QObject>
 #include <QVector3D>
 #include "vtkSmartPointer.h"
@@ -37,11 +38,14 @@ protected slots:
 
 protected:
     void clipBlocks();
+    /// Clip block surfaces right away and cut the volume once the plane settles
     void updateModelBlocks();
+    void onCut(const std::vector<ClipCutter::Surface> & surfaces);
 
     MainWindow * main_window;
     Model *& model;
     ClipWidget * widget;
+    ClipCutter * cutter;
     vtkSmartPointer<vtkPlane> clip_plane;
     QVector3D normal;
     float normal_ori;
@@ -4,6 +4,20 @@
 #include "exodusiireader.h"
 #include "vtkExodusIIReader.h"
 #include "vtkSmartPointer.h"
+#include "vtkMultiBlockDataSet.h"
+#include "vtkTrivialProducer.h"
+#include "vtkUnstructuredGrid.h"
+#include <algorithm>
+
+namespace {
+
+/// Object types in the order of the blocks of the reader output
+const std::vector<int> OBJ_TYPES = { vtkExodusIIReader::ELEM_BLOCK, vtkExodusIIReader::FACE_BLOCK,
+                                     vtkExodusIIReader::EDGE_BLOCK, vtkExodusIIReader::ELEM_SET,
+                                     vtkExodusIIReader::SIDE_SET,   vtkExodusIIReader::FACE_SET,
+                                     vtkExodusIIReader::EDGE_SET,   vtkExodusIIReader::NODE_SET };
+
+} // namespace
 
 ExodusIIReader::ExodusIIReader(const std::string & file_name) : Reader(file_name) {}
 
@@ -13,18 +27,18 @@ void
 ExodusIIReader::load()
 {
     this->reader = vtkSmartPointer<vtkExodusIIReader>::New();
+    observeProgress(this->reader);
 
     this->reader->SetFileName(this->file_name.c_str());
     this->reader->UpdateInformation();
-    this->reader->Update();
-
     readBlockInfo();
-    for (auto & it : this->block_info) {
-        for (auto & jt : it.second) {
-            auto & info = jt.second;
-            this->reader->SetObjectStatus(info.object_type, info.object_index, 1);
-        }
+    // only element blocks are shown right away, everything else is read by `loadObject` when
+    // it is first needed
+    for (auto & otype : OBJ_TYPES) {
+        for (int j = 0; j < this->reader->GetNumberOfObjects(otype); j++)
+            this->reader->SetObjectStatus(otype, j, otype == vtkExodusIIReader::ELEM_BLOCK ? 1 : 0);
     }
+    this->reader->Update();
 }
 
 std::size_t
@@ -78,18 +92,65 @@ ExodusIIReader::getNodeSets()
     return nodesets;
 }
 
+bool
+ExodusIIReader::isObjectLoaded(const BlockInformation & info)
+{
+    return this->reader != nullptr &&
+           this->reader->GetObjectStatus(info.object_type, info.object_index) == 1;
+}
+
+vtkAlgorithmOutput *
+ExodusIIReader::loadObject(const BlockInformation & info)
+{
+    auto key = std::make_pair(info.object_type, info.object_index);
+    auto it = this->objects.find(key);
+    if (it != this->objects.end())
+        return it->second->GetOutputPort();
+
+    auto type_it = std::find(OBJ_TYPES.begin(), OBJ_TYPES.end(), info.object_type);
+    if (type_it == OBJ_TYPES.end())
+        return nullptr;
+
+    if (this->object_reader == nullptr) {
+        this->object_reader = vtkSmartPointer<vtkExodusIIReader>::New();
+        this->object_reader->SetFileName(this->file_name.c_str());
+        this->object_reader->UpdateInformation();
+        for (auto & otype : OBJ_TYPES) {
+            for (int j = 0; j < this->object_reader->GetNumberOfObjects(otype); j++)
+                this->object_reader->SetObjectStatus(otype, j, 0);
+        }
+    }
+
+    this->object_reader->SetObjectStatus(info.object_type, info.object_index, 1);
+    this->object_reader->Update();
+    this->object_reader->SetObjectStatus(info.object_type, info.object_index, 0);
+
+    auto * output = this->object_reader->GetOutput();
+    auto * type_blocks =
+        vtkMultiBlockDataSet::SafeDownCast(output->GetBlock(type_it - OBJ_TYPES.begin()));
+    if (type_blocks == nullptr)
+        return nullptr;
+    auto * data = vtkUnstructuredGrid::SafeDownCast(type_blocks->GetBlock(info.object_index));
+    if (data == nullptr)
+        return nullptr;
+
+    // the next `loadObject` call replaces the reader output
+    auto grid = vtkSmartPointer<vtkUnstructuredGrid>::New();
+    grid->ShallowCopy(data);
+    auto producer = vtkSmartPointer<vtkTrivialProducer>::New();
+    producer->SetOutput(grid);
+    producer->Update();
+    this->objects[key] = producer;
+    return producer->GetOutputPort();
+}
+
 void
 ExodusIIReader::readBlockInfo()
 {
-    std::vector<int> obj_types = { vtkExodusIIReader::ELEM_BLOCK, vtkExodusIIReader::FACE_BLOCK,
-                                   vtkExodusIIReader::EDGE_BLOCK, vtkExodusIIReader::ELEM_SET,
-                                   vtkExodusIIReader::SIDE_SET,   vtkExodusIIReader::FACE_SET,
-                                   vtkExodusIIReader::EDGE_SET,   vtkExodusIIReader::NODE_SET };
-
     // Index to be used with the vtkExtractBlock::AddIndex method
     int index = 0;
     // Loop over all blocks of the MultiBlockDataSet
-    for (auto & otype : obj_types) {
+    for (auto & otype : OBJ_TYPES) {
         index += 1;
         this->block_info[otype] = std::map<int, BlockInformation>();
         for (int j = 0; j < this->reader->GetNumberOfObjects(otype); j++) {
@@ -8,6 +8,7 @@
 #include <map>
 
 class vtkExodusIIReader;
+class vtkTrivialProducer;
 
 class ExodusIIReader : public Reader {
 public:
@@ -24,9 +25,16 @@ public:
     std::vector<Reader::BlockInformation> getSideSets() override;
     std::vector<Reader::BlockInformation> getNodeSets() override;
 
+    bool isObjectLoaded(const BlockInformation & info) override;
+    vtkAlgorithmOutput * loadObject(const BlockInformation & info) override;
+
 protected:
     void readBlockInfo();
 
     vtkSmartPointer<vtkExodusIIReader> reader;
     std::map<int, std::map<int, BlockInformation>> block_info;
+    /// Reader for objects loaded on demand, it reads one object at a time
+    vtkSmartPointer<vtkExodusIIReader> object_reader;
+    /// Objects loaded on demand: (object type, object index) -> producer
+    std::map<std::pair<int, int>, vtkSmartPointer<vtkTrivialProducer>> objects;
 };
@@ -0,0 +1,185 @@
+// SPDX-FileCopyrightText: 2024 David Andrs <andrsd@gmail.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "hoverpicker.h"
+#include <QThread>
+#include <QTimer>
+#include <QElapsedTimer>
+#include "vtkAbstractCellLocator.h"
+#include "vtkDataSet.h"
+#include "vtkGenericCell.h"
+#include "vtkIdList.h"
+#include "vtkPoints.h"
+#include "vtkMatrix4x4.h"
+#include "vtkMath.h"
+#include <algorithm>
+#include <limits>
+
+namespace {
+
+/// Longest delay between two subsequent picks in milliseconds
+const int MAX_INTERVAL = 100;
+/// Weight of the last measured latency in the moving average
+const double LATENCY_WEIGHT = 0.2;
+/// Pick tolerance relative to the size of a surface
+const double TOLERANCE = 1e-6;
+/// Delay before an incomplete pick is repeated in milliseconds
+const int RETRY_DELAY = 50;
+
+void
+transformPoint(vtkMatrix4x4 * transform, const double in[3], double out[3])
+{
+    if (transform == nullptr) {
+        std::copy(in, in + 3, out);
+        return;
+    }
+
+    double p[4] = { in[0], in[1], in[2], 1. };
+    double q[4];
+    transform->MultiplyPoint(p, q);
+    for (int i = 0; i < 3; i++)
+        out[i] = q[i] / q[3];
+}
+
+} // namespace
+
+HoverPicker::HoverPicker(PrepareCallback prepare, ResultCallback done) :
+    QObject(),
+    prepare(prepare),
+    done(done),
+    thread(new QThread()),
+    worker(new QObject()),
+    throttle(new QTimer(this)),
+    busy(false),
+    pending(false),
+    generation(0),
+    latency(0.)
+{
+    this->worker->moveToThread(this->thread);
+    this->throttle->setSingleShot(true);
+    connect(this->throttle, &QTimer::timeout, this, &HoverPicker::start);
+    this->thread->start();
+}
+
+HoverPicker::~HoverPicker()
+{
+    this->thread->quit();
+    this->thread->wait();
+    delete this->worker;
+    delete this->thread;
+}
+
+void
+HoverPicker::request(const QPoint & pt)
+{
+    this->pending_pt = pt;
+    this->pending = true;
+    if (!this->busy && !this->throttle->isActive())
+        start();
+}
+
+void
+HoverPicker::cancel()
+{
+    this->pending = false;
+    this->generation++;
+    this->throttle->stop();
+}
+
+void
+HoverPicker::start()
+{
+    if (this->busy || !this->pending)
+        return;
+
+    this->pending = false;
+    Request request;
+    bool ok = this->prepare(this->pending_pt, request);
+    if (request.incomplete) {
+        // unless the cursor moves on in the meantime
+        QTimer::singleShot(
+            RETRY_DELAY,
+            this,
+            [this, pt = this->pending_pt, generation = this->generation]() {
+                if (generation == this->generation && pt == this->pending_pt)
+                    this->request(pt);
+            });
+    }
+    if (!ok) {
+        this->done(Result());
+        return;
+    }
+
+    this->busy = true;
+    auto generation = this->generation;
+    QMetaObject::invokeMethod(
+        this->worker,
+        [this, request, generation]() {
+            QElapsedTimer timer;
+            timer.start();
+            auto result = pick(request);
+            double latency = timer.nsecsElapsed() * 1e-6;
+            QMetaObject::invokeMethod(
+                this,
+                [this, result, generation, latency]() { onPicked(result, generation, latency); },
+                Qt::QueuedConnection);
+        },
+        Qt::QueuedConnection);
+}
+
+void
+HoverPicker::onPicked(const Result & result, quint64 generation, double latency)
+{
+    this->busy = false;
+    this->latency = (1. - LATENCY_WEIGHT) * this->latency + LATENCY_WEIGHT * latency;
+    if (generation == this->generation)
+        this->done(result);
+    if (this->pending)
+        this->throttle->start(getInterval());
+}
+
+int
+HoverPicker::getInterval() const
+{
+    return std::min((int) this->latency, MAX_INTERVAL);
+}
+
+HoverPicker::Result
+HoverPicker::pick(const Request & request)
+{
+    Result result;
+    double best_t = std::numeric_limits<double>::max();
+    auto cell = vtkSmartPointer<vtkGenericCell>::New();
+    for (auto & target : request.targets) {
+        double p1[3], p2[3];
+        transformPoint(target.transform, request.p1, p1);
+        transformPoint(target.transform, request.p2, p2);
+
+        auto * data_set = target.locator->GetDataSet();
+        double tol = TOLERANCE * data_set->GetLength();
+        double t, x[3], pcoords[3];
+        int sub_id;
+        vtkIdType cell_id;
+        if (target.locator->IntersectWithLine(p1, p2, tol, t, x, pcoords, sub_id, cell_id, cell) &&
+            t < best_t) {
+            best_t = t;
+            result.block_id = target.block_id;
+            result.cell_id = cell_id;
+            result.data_set = data_set;
+
+            double min_dist2 = std::numeric_limits<double>::max();
+            auto * ids = cell->GetPointIds();
+            auto * pts = cell->GetPoints();
+            for (vtkIdType i = 0; i < ids->GetNumberOfIds(); i++) {
+                double pt[3];
+                pts->GetPoint(i, pt);
+                auto dist2 = vtkMath::Distance2BetweenPoints(pt, x);
+                if (dist2 < min_dist2) {
+                    min_dist2 = dist2;
+                    result.point_id = ids->GetId(i);
+                }
+            }
+        }
+    }
+    return result;
+}
@@ -0,0 +1,102 @@
+// SPDX-FileCopyrightText: 2024 David Andrs <andrsd@gmail.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <QObject>
+#include <QPoint>
+#include <functional>
+#include <vector>
+#include "vtkSmartPointer.h"
+#include "vtkType.h"
+
+class QThread;
+class QTimer;
+class vtkAbstractCellLocator;
+class vtkMatrix4x4;
+class vtkDataSet;
+
+/// Picks cells under the mouse cursor in a worker thread
+///
+/// Only one pick runs at a time and only the latest requested position is picked next, older
+/// requests are dropped. Picks follow each other no sooner than the measured pick latency (up to a
+/// limit), so that the GUI thread has time to render between them. Requests are prepared on the
+/// GUI thread right before their pick starts.
+class HoverPicker : public QObject {
+public:
+    /// Pickable surface
+    struct Target {
+        /// Id of the block the surface belongs to
+        int block_id;
+        /// Locator of the surface cells
+        vtkSmartPointer<vtkAbstractCellLocator> locator;
+        /// Transformation from world to surface coordinates (`nullptr` means identity)
+        vtkSmartPointer<vtkMatrix4x4> transform;
+    };
+
+    /// Pick request
+    struct Request {
+        /// Start and end point of the pick ray in world coordinates
+        double p1[3];
+        double p2[3];
+        std::vector<Target> targets;
+        /// Some surfaces are not pickable yet, the position is picked again a bit later
+        bool incomplete = false;
+    };
+
+    /// Pick result
+    struct Result {
+        /// Id of the picked block, -1 if nothing was picked
+        int block_id = -1;
+        /// Id of the picked cell in the surface
+        vtkIdType cell_id = -1;
+        /// Id of the point of the picked cell closest to the pick position
+        vtkIdType point_id = -1;
+        /// Picked surface (cell and point ids refer to it)
+        vtkSmartPointer<vtkDataSet> data_set;
+    };
+
+    /// Prepare a request for a pick at a screen position
+    ///
+    /// @return `false` if there is nothing to pick
+    using PrepareCallback = std::function<bool(const QPoint & pt, Request & request)>;
+    /// Receive a pick result (called on the GUI thread)
+    using ResultCallback = std::function<void(const Result & result)>;
+
+    HoverPicker(PrepareCallback prepare, ResultCallback done);
+    ~HoverPicker() override;
+
+    /// Request a pick at a screen position
+    void request(const QPoint & pt);
+
+    /// Drop the pending request and the result of the running pick
+    void cancel();
+
+    /// Pick the cell hit first by the ray of a request
+    ///
+    /// Can be called from any thread.
+    static Result pick(const Request & request);
+
+protected:
+    void start();
+    void onPicked(const Result & result, quint64 generation, double latency);
+    /// Get the delay between two subsequent picks in milliseconds
+    int getInterval() const;
+
+    PrepareCallback prepare;
+    ResultCallback done;
+    QThread * thread;
+    /// Object living in `thread`, picks are executed in its context
+    QObject * worker;
+    /// Delays the start of the next pick
+    QTimer * throttle;
+    /// Is a pick running
+    bool busy;
+    /// Is there a request waiting for a pick
+    bool pending;
+    QPoint pending_pt;
+    /// Results of picks started in older generations are dropped
+    quint64 generation;
+    /// Moving average of the pick latency in milliseconds
+    double latency;
+};
@@ -23,6 +23,7 @@
 #include <QVector3D>
 #include <QShortcut>
 #include <QStandardPaths>
+#include <QLocale>
 #include "aboutdlg.h"
 #include "licensedlg.h"
 #include "filechangednotificationwidget.h"
@@ -294,7 +295,8 @@ MainWindow::updateMenuBar()
     this->show_main_window->setChecked(active_window == this);
 
     this->view_info_wnd_action->setChecked(this->info_view->isVisible());
-    bool has_file = this->model->hasFile();
+    // tools stay disabled until the file is fully loaded
+    bool has_file = this->model->hasFile() && !this->model->isLoading();
     this->export_tool->setMenuEnabled(has_file);
     this->tools_explode_action->setEnabled(has_file);
     this->tools_mesh_quality_action->setEnabled(has_file);
@@ -321,6 +323,7 @@ void
 MainWindow::connectSignals()
 {
     connect(this->model, &Model::loadFinished, this, &MainWindow::onLoadFinished);
+    connect(this->model, &Model::loadProgress, this, &MainWindow::onLoadProgress);
     connect(this->model, &Model::fileChanged, this, &MainWindow::onFileChanged);
     connect(this->model, &Model::blockAdded, this->info_view, &InfoView::onBlockAdded);
     connect(this->info_view,
@@ -373,6 +376,7 @@ void
 MainWindow::clear()
 {
     this->mesh_quality_tool->done();
+    this->mesh_quality_tool->clear();
     this->clip_tool->done();
     this->model->clear();
     this->select_tool->clear();
@@ -382,16 +386,30 @@ void
 MainWindow::loadFile(const QString & file_name)
 {
     QFileInfo fi(file_name);
-    if (fi.exists()) {
+    if (this->model->isLoading()) {
+        showNotification(QString("Unable to open '%1': Another file is being loaded.")
+                             .arg(fi.fileName()));
+    }
+    else if (fi.exists()) {
         this->select_tool->onDeselect();
         this->clear();
 
-        this->progress =
-            new QProgressDialog(QString("Loading %1...").arg(fi.fileName()), QString(), 0, 0, this);
-        this->progress->setWindowModality(Qt::WindowModal);
+        // not modal, so blocks can be inspected as they show up
+        this->progress = new QProgressDialog(QString("Loading %1...").arg(fi.fileName()),
+                                             QString(),
+                                             0,
+                                             100,
+                                             this);
+        this->progress->setWindowModality(Qt::NonModal);
+        this->progress->setMinimumDuration(0);
+        // reading the file and building blocks both run up to 100%
+        this->progress->setAutoReset(false);
+        this->progress->setAutoClose(false);
+        this->progress->setValue(0);
         this->progress->show();
 
         this->model->loadFile(file_name);
+        updateMenuBar();
     }
     else {
         auto base_file = fi.fileName();
@@ -594,6 +612,30 @@ MainWindow::hideLoadProgressBar()
     this->progress = nullptr;
 }
 
+void
+MainWindow::onLoadProgress(qint64 bytes_read, qint64 file_size, int blocks_done, int total_blocks)
+{
+    if (this->progress == nullptr)
+        return;
+
+    auto fi = this->model->getFileInfo();
+    if (total_blocks > 0) {
+        this->progress->setLabelText(QString("Loading %1... block %2 of %3")
+                                         .arg(fi.fileName())
+                                         .arg(blocks_done)
+                                         .arg(total_blocks));
+        this->progress->setValue(100 * blocks_done / total_blocks);
+    }
+    else if (file_size > 0) {
+        QLocale locale;
+        this->progress->setLabelText(QString("Loading %1... %2 of %3")
+                                         .arg(fi.fileName())
+                                         .arg(locale.formattedDataSize(bytes_read))
+                                         .arg(locale.formattedDataSize(file_size)));
+        this->progress->setValue(100 * bytes_read / file_size);
+    }
+}
+
 void
 MainWindow::onLoadFinished()
 {
@@ -644,12 +686,22 @@ MainWindow::onBlockColorChanged(int block_id, QColor color)
 void
 MainWindow::onSideSetVisibilityChanged(int sideset_id, bool visible)
 {
+    if (visible) {
+        QApplication::setOverrideCursor(Qt::WaitCursor);
+        this->model->loadSideSet(sideset_id);
+        QApplication::restoreOverrideCursor();
+    }
     this->view->setSideSetVisibility(sideset_id, visible);
 }
 
 void
 MainWindow::onNodeSetVisibilityChanged(int nodeset_id, bool visible)
 {
+    if (visible) {
+        QApplication::setOverrideCursor(Qt::WaitCursor);
+        this->model->loadNodeSet(nodeset_id);
+        QApplication::restoreOverrideCursor();
+    }
     this->view->setNodeSetVisibility(nodeset_id, visible);
 }
 
@@ -730,6 +782,20 @@ MainWindow::onReloadFile()
     loadFile(file_name);
 }
 
+void
+MainWindow::onLeftButtonPress(const QPoint & pt, const Qt::KeyboardModifiers & mods)
+{
+    if (this->model->hasFile())
+        this->select_tool->onLeftButtonPress(pt, mods);
+}
+
+void
+MainWindow::onLeftButtonRelease(const QPoint & pt)
+{
+    if (this->model->hasFile())
+        this->select_tool->onLeftButtonRelease(pt);
+}
+
 void
 MainWindow::onClicked(const QPoint & pt)
 {
@@ -88,6 +88,7 @@ protected:
 public slots:
     void onClose();
     void onLoadFinished();
+    void onLoadProgress(qint64 bytes_read, qint64 file_size, int blocks_done, int total_blocks);
     void onBlockVisibilityChanged(int block_id, bool visible);
     void onBlockOpacityChanged(int block_id, double opacity);
     void onBlockColorChanged(int block_id, QColor color);
@@ -101,6 +102,8 @@ public slots:
     void onUpdateWindow();
     void onFileChanged(const QString & path);
     void onReloadFile();
+    void onLeftButtonPress(const QPoint & pt, const Qt::KeyboardModifiers & mods);
+    void onLeftButtonRelease(const QPoint & pt);
     void onClicked(const QPoint & pt);
     void onMouseMove(const QPoint & pt);
     void onViewInfoWindow();
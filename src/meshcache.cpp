@@ -0,0 +1,565 @@
+// SPDX-FileCopyrightText: 2024 David Andrs <andrsd@gmail.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "meshcache.h"
+#include "vtkAlgorithm.h"
+#include "vtkAlgorithmOutput.h"
+#include "vtkCellArray.h"
+#include "vtkCellData.h"
+#include "vtkDataArray.h"
+#include "vtkInformation.h"
+#include "vtkMultiBlockDataSet.h"
+#include "vtkPointData.h"
+#include "vtkPoints.h"
+#include "vtkTypeInt32Array.h"
+#include "vtkTypeInt64Array.h"
+#include "vtkUnsignedCharArray.h"
+#include "vtkUnstructuredGrid.h"
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace {
+
+const char MAGIC[8] = { 'M', 'I', 'C', 'A', 'C', 'H', 'E', '\0' };
+const quint32 VERSION = 1;
+const quint32 BYTE_ORDER_MARK = 0x01020304;
+const char * ENTRY_SUFFIX = ".mi-cache";
+
+/// Number of regions of the mesh file that are hashed into the entry key
+const int N_HASH_SAMPLES = 16;
+/// Size of one hashed region
+const qint64 HASH_SAMPLE_SIZE = 64 * 1024;
+
+enum DataObjectKind : quint32 { NONE = 0, MULTI_BLOCK = 1, UNSTRUCTURED_GRID = 2 };
+
+// Memory-mapped entries stay alive as long as VTK arrays point into them
+
+std::mutex mapped_arrays_mutex;
+std::unordered_map<void *, std::shared_ptr<QFile>> mapped_arrays;
+
+void
+releaseMappedArray(void * ptr)
+{
+    std::lock_guard<std::mutex> lock(mapped_arrays_mutex);
+    mapped_arrays.erase(ptr);
+}
+
+/// Error while reading or writing an entry
+class CacheError : public std::runtime_error {
+public:
+    explicit CacheError(const char * what) : std::runtime_error(what) {}
+};
+
+class EntryWriter {
+public:
+    explicit EntryWriter(QIODevice & device) : device(device), pos(0) {}
+
+    void
+    writeBytes(const void * data, qint64 size)
+    {
+        if (size > 0 && this->device.write(static_cast<const char *>(data), size) != size)
+            throw CacheError("Failed to write cache entry");
+        this->pos += size;
+    }
+
+    template <typename T>
+    void
+    write(T val)
+    {
+        writeBytes(&val, sizeof(T));
+    }
+
+    void
+    writeString(const std::string & str)
+    {
+        write<quint32>(str.size());
+        writeBytes(str.data(), str.size());
+    }
+
+    /// Pad the output so that the next write starts at 8-byte boundary
+    void
+    align()
+    {
+        const char zeros[8] = { 0 };
+        auto rem = this->pos % 8;
+        if (rem != 0)
+            writeBytes(zeros, 8 - rem);
+    }
+
+    void
+    writeBlockInfos(const std::vector<Reader::BlockInformation> & infos)
+    {
+        write<quint32>(infos.size());
+        for (auto & info : infos) {
+            writeString(info.name);
+            write<qint32>(info.object_type);
+            write<qint32>(info.object_index);
+            write<qint32>(info.number);
+            write<qint32>(info.multiblock_index);
+            write<qint32>(info.material_index);
+        }
+    }
+
+    void
+    writeArray(vtkDataArray * arr)
+    {
+        vtkSmartPointer<vtkDataArray> data = arr;
+        if (!arr->HasStandardMemoryLayout()) {
+            data = vtkSmartPointer<vtkDataArray>::Take(
+                vtkDataArray::CreateDataArray(arr->GetDataType()));
+            data->DeepCopy(arr);
+        }
+
+        writeString(data->GetName() ? data->GetName() : "");
+        write<qint32>(data->GetDataType());
+        write<qint32>(data->GetNumberOfComponents());
+        write<qint64>(data->GetNumberOfTuples());
+        align();
+        writeBytes(data->GetVoidPointer(0),
+                   (qint64) data->GetNumberOfValues() * data->GetDataTypeSize());
+    }
+
+    void
+    writeAttributes(vtkFieldData * fd)
+    {
+        std::vector<vtkDataArray *> arrays;
+        for (int i = 0; i < fd->GetNumberOfArrays(); i++) {
+            // only numeric arrays are stored
+            auto arr = fd->GetArray(i);
+            if (arr)
+                arrays.push_back(arr);
+        }
+        write<quint32>(arrays.size());
+        for (auto & arr : arrays)
+            writeArray(arr);
+    }
+
+    void
+    writeDataObject(vtkDataObject * obj)
+    {
+        if (obj == nullptr)
+            write<quint32>(NONE);
+        else if (auto mb = vtkMultiBlockDataSet::SafeDownCast(obj)) {
+            write<quint32>(MULTI_BLOCK);
+            write<quint32>(mb->GetNumberOfBlocks());
+            for (unsigned int i = 0; i < mb->GetNumberOfBlocks(); i++) {
+                const char * name = nullptr;
+                if (mb->HasMetaData(i) && mb->GetMetaData(i)->Has(vtkCompositeDataSet::NAME()))
+                    name = mb->GetMetaData(i)->Get(vtkCompositeDataSet::NAME());
+                write<quint8>(name != nullptr);
+                if (name != nullptr)
+                    writeString(name);
+                writeDataObject(mb->GetBlock(i));
+            }
+        }
+        else if (auto ug = vtkUnstructuredGrid::SafeDownCast(obj)) {
+            write<quint32>(UNSTRUCTURED_GRID);
+            auto pts = ug->GetPoints();
+            write<quint8>(pts != nullptr);
+            if (pts)
+                writeArray(pts->GetData());
+            // grids without cells may have no cell types
+            auto cells = ug->GetCellTypesArray() != nullptr ? ug->GetCells() : nullptr;
+            write<quint8>(cells != nullptr);
+            if (cells) {
+                writeArray(cells->GetOffsetsArray());
+                writeArray(cells->GetConnectivityArray());
+                writeArray(ug->GetCellTypesArray());
+            }
+            writeAttributes(ug->GetPointData());
+            writeAttributes(ug->GetCellData());
+        }
+        else
+            throw CacheError("Unsupported data object");
+    }
+
+private:
+    QIODevice & device;
+    qint64 pos;
+};
+
+class EntryReader {
+public:
+    EntryReader(const uchar * data, qint64 size, std::shared_ptr<QFile> file) :
+        data(data),
+        size(size),
+        pos(0),
+        file(file)
+    {
+    }
+
+    const uchar *
+    readBytes(qint64 n)
+    {
+        if (n < 0 || n > this->size - this->pos)
+            throw CacheError("Truncated cache entry");
+        auto ptr = this->data + this->pos;
+        this->pos += n;
+        return ptr;
+    }
+
+    template <typename T>
+    T
+    read()
+    {
+        T val;
+        std::memcpy(&val, readBytes(sizeof(T)), sizeof(T));
+        return val;
+    }
+
+    std::string
+    readString()
+    {
+        auto len = read<quint32>();
+        auto ptr = readBytes(len);
+        return std::string(reinterpret_cast<const char *>(ptr), len);
+    }
+
+    void
+    align()
+    {
+        auto rem = this->pos % 8;
+        if (rem != 0)
+            readBytes(8 - rem);
+    }
+
+    /// Check that `n` items of at least `item_size` bytes fit into the rest of the entry, so that
+    /// a corrupted count does not allocate huge amounts of memory
+    void
+    checkCount(quint64 n, qint64 item_size)
+    {
+        if (n > (quint64) (this->size - this->pos) / std::max<qint64>(item_size, 1))
+            throw CacheError("Truncated cache entry");
+    }
+
+    std::vector<Reader::BlockInformation>
+    readBlockInfos()
+    {
+        auto n = read<quint32>();
+        // name length and 5 integers
+        checkCount(n, 6 * sizeof(qint32));
+        std::vector<Reader::BlockInformation> infos(n);
+        for (auto & info : infos) {
+            info.name = readString();
+            info.object_type = read<qint32>();
+            info.object_index = read<qint32>();
+            info.number = read<qint32>();
+            info.multiblock_index = read<qint32>();
+            info.material_index = read<qint32>();
+        }
+        return infos;
+    }
+
+    vtkSmartPointer<vtkDataArray>
+    readArray()
+    {
+        auto name = readString();
+        auto type = read<qint32>();
+        auto n_comps = read<qint32>();
+        auto n_tuples = read<qint64>();
+        align();
+
+        vtkSmartPointer<vtkDataArray> arr;
+        if (type == VTK_TYPE_INT64)
+            arr = vtkSmartPointer<vtkTypeInt64Array>::New();
+        else if (type == VTK_TYPE_INT32)
+            arr = vtkSmartPointer<vtkTypeInt32Array>::New();
+        else
+            arr = vtkSmartPointer<vtkDataArray>::Take(vtkDataArray::CreateDataArray(type));
+        if (arr == nullptr || n_comps <= 0 || n_tuples < 0)
+            throw CacheError("Invalid array in cache entry");
+        checkCount(n_tuples, (qint64) n_comps * arr->GetDataTypeSize());
+        if (!name.empty())
+            arr->SetName(name.c_str());
+        arr->SetNumberOfComponents(n_comps);
+
+        vtkIdType n_values = n_tuples * n_comps;
+        auto ptr = const_cast<uchar *>(readBytes(n_values * arr->GetDataTypeSize()));
+        if (n_values > 0) {
+            {
+                std::lock_guard<std::mutex> lock(mapped_arrays_mutex);
+                mapped_arrays[ptr] = this->file;
+            }
+            arr->SetVoidArray(ptr, n_values, 0, vtkAbstractArray::VTK_DATA_ARRAY_USER_DEFINED);
+            arr->SetArrayFreeFunction(releaseMappedArray);
+        }
+        return arr;
+    }
+
+    void
+    readAttributes(vtkFieldData * fd)
+    {
+        auto n = read<quint32>();
+        // name length, type, number of components and tuples
+        checkCount(n, 3 * sizeof(qint32) + sizeof(qint64));
+        for (quint32 i = 0; i < n; i++)
+            fd->AddArray(readArray());
+    }
+
+    vtkSmartPointer<vtkDataObject>
+    readDataObject()
+    {
+        auto kind = read<quint32>();
+        if (kind == NONE)
+            return vtkSmartPointer<vtkDataObject>();
+        else if (kind == MULTI_BLOCK) {
+            auto mb = vtkSmartPointer<vtkMultiBlockDataSet>::New();
+            auto n = read<quint32>();
+            // name flag and kind
+            checkCount(n, sizeof(quint8) + sizeof(quint32));
+            mb->SetNumberOfBlocks(n);
+            for (quint32 i = 0; i < n; i++) {
+                if (read<quint8>())
+                    mb->GetMetaData(i)->Set(vtkCompositeDataSet::NAME(), readString());
+                mb->SetBlock(i, readDataObject());
+            }
+            return mb;
+        }
+        else if (kind == UNSTRUCTURED_GRID) {
+            auto ug = vtkSmartPointer<vtkUnstructuredGrid>::New();
+            if (read<quint8>()) {
+                auto pts = vtkSmartPointer<vtkPoints>::New();
+                pts->SetData(readArray());
+                ug->SetPoints(pts);
+            }
+            if (read<quint8>()) {
+                auto offsets = readArray();
+                auto connectivity = readArray();
+                auto types = readArray();
+                auto cells = vtkSmartPointer<vtkCellArray>::New();
+                if (vtkUnsignedCharArray::SafeDownCast(types) == nullptr ||
+                    !cells->SetData(offsets, connectivity))
+                    throw CacheError("Invalid cells in cache entry");
+                ug->SetCells(vtkUnsignedCharArray::SafeDownCast(types), cells);
+            }
+            readAttributes(ug->GetPointData());
+            readAttributes(ug->GetCellData());
+            return ug;
+        }
+        else
+            throw CacheError("Unknown data object in cache entry");
+    }
+
+private:
+    const uchar * data;
+    qint64 size;
+    qint64 pos;
+    std::shared_ptr<QFile> file;
+};
+
+/// Size of the entry header that precedes the key
+const qint64 HEADER_SIZE = sizeof(MAGIC) + 3 * sizeof(quint32);
+
+} // namespace
+
+MeshCache::MeshCache(const QString & file_name, qint64 max_size) :
+    file_name(file_name),
+    max_size(max_size)
+{
+    this->key = computeKey();
+    auto hex = QCryptographicHash::hash(this->key, QCryptographicHash::Sha1).toHex();
+    this->entry_file_name = QDir(getDirectory()).filePath(QString::fromLatin1(hex) + ENTRY_SUFFIX);
+}
+
+QString
+MeshCache::getDirectory()
+{
+    return QDir(QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation))
+        .filePath("MeshInspector/meshes");
+}
+
+bool
+MeshCache::isSupported(const QString & file_name)
+{
+    return file_name.endsWith(".e") || file_name.endsWith(".exo") || file_name.endsWith(".msh");
+}
+
+const QString &
+MeshCache::getEntryFileName() const
+{
+    return this->entry_file_name;
+}
+
+QByteArray
+MeshCache::computeKey() const
+{
+    QFileInfo fi(this->file_name);
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(fi.canonicalFilePath().toUtf8());
+    hash.addData(QByteArray::number(fi.size()));
+    hash.addData(QByteArray::number(fi.lastModified().toMSecsSinceEpoch()));
+
+    // hash evenly spaced samples of the contents, reading whole multi-GB files would take too long
+    QFile file(this->file_name);
+    if (file.open(QIODevice::ReadOnly)) {
+        auto file_size = file.size();
+        auto stride = std::max<qint64>(file_size / N_HASH_SAMPLES, HASH_SAMPLE_SIZE);
+        for (qint64 ofs = 0; ofs < file_size; ofs += stride) {
+            file.seek(ofs);
+            hash.addData(file.read(HASH_SAMPLE_SIZE));
+        }
+        file.seek(std::max<qint64>(file_size - HASH_SAMPLE_SIZE, 0));
+        hash.addData(file.read(HASH_SAMPLE_SIZE));
+    }
+    return hash.result();
+}
+
+bool
+MeshCache::hasEntry() const
+{
+    QFile file(this->entry_file_name);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+    auto header = file.read(HEADER_SIZE + this->key.size());
+    if (header.size() != HEADER_SIZE + this->key.size())
+        return false;
+
+    EntryReader rd(reinterpret_cast<const uchar *>(header.constData()), header.size(), nullptr);
+    if (std::memcmp(rd.readBytes(sizeof(MAGIC)), MAGIC, sizeof(MAGIC)) != 0)
+        return false;
+    if (rd.read<quint32>() != VERSION || rd.read<quint32>() != BYTE_ORDER_MARK)
+        return false;
+    if (rd.read<quint32>() != (quint32) this->key.size())
+        return false;
+    return std::memcmp(rd.readBytes(this->key.size()), this->key.constData(), this->key.size()) ==
+           0;
+}
+
+bool
+MeshCache::read(Contents & contents) const
+{
+    if (!hasEntry())
+        return false;
+
+    auto file = std::make_shared<QFile>(this->entry_file_name);
+    if (!file->open(QIODevice::ReadOnly))
+        return false;
+    // private mapping, so nothing VTK does to the arrays can reach the file
+    auto data = file->map(0, file->size(), QFileDevice::MapPrivateOption);
+    if (data == nullptr)
+        return false;
+
+    try {
+        EntryReader rd(data, file->size(), file);
+        rd.readBytes(HEADER_SIZE + this->key.size());
+        contents.total_elements = rd.read<quint64>();
+        contents.total_nodes = rd.read<quint64>();
+        contents.dimensionality = rd.read<qint32>();
+        contents.blocks = rd.readBlockInfos();
+        contents.side_sets = rd.readBlockInfos();
+        contents.node_sets = rd.readBlockInfos();
+        contents.data = rd.readDataObject();
+    }
+    catch (CacheError &) {
+        contents = Contents();
+        return false;
+    }
+
+    // mark the entry as recently used
+    file->setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+    return true;
+}
+
+bool
+MeshCache::write(Reader * reader) const
+{
+    return write(snapshot(reader));
+}
+
+MeshCache::Contents
+MeshCache::snapshot(Reader * reader)
+{
+    Contents contents;
+    auto port = reader->getVtkOutputPort();
+    if (port == nullptr)
+        return contents;
+    auto alg = port->GetProducer();
+    alg->Update();
+    auto * data = alg->GetOutputDataObject(port->GetIndex());
+    if (data == nullptr)
+        return contents;
+
+    contents.data.TakeReference(data->NewInstance());
+    contents.data->ShallowCopy(data);
+    contents.blocks = reader->getBlocks();
+    contents.side_sets = reader->getSideSets();
+    contents.node_sets = reader->getNodeSets();
+    contents.total_elements = reader->getTotalNumberOfElements();
+    contents.total_nodes = reader->getTotalNumberOfNodes();
+    contents.dimensionality = reader->getDimensionality();
+    return contents;
+}
+
+bool
+MeshCache::write(const Contents & contents) const
+{
+    if (contents.data == nullptr)
+        return false;
+
+    QDir().mkpath(getDirectory());
+    QSaveFile file(this->entry_file_name);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+
+    try {
+        EntryWriter wr(file);
+        wr.writeBytes(MAGIC, sizeof(MAGIC));
+        wr.write<quint32>(VERSION);
+        wr.write<quint32>(BYTE_ORDER_MARK);
+        wr.write<quint32>(this->key.size());
+        wr.writeBytes(this->key.constData(), this->key.size());
+        wr.write<quint64>(contents.total_elements);
+        wr.write<quint64>(contents.total_nodes);
+        wr.write<qint32>(contents.dimensionality);
+        wr.writeBlockInfos(contents.blocks);
+        wr.writeBlockInfos(contents.side_sets);
+        wr.writeBlockInfos(contents.node_sets);
+        wr.writeDataObject(contents.data);
+    }
+    catch (CacheError &) {
+        file.cancelWriting();
+        return false;
+    }
+    if (!file.commit())
+        return false;
+
+    prune();
+    return true;
+}
+
+void
+MeshCache::remove() const
+{
+    QFile::remove(this->entry_file_name);
+}
+
+void
+MeshCache::prune() const
+{
+    QDir dir(getDirectory());
+    auto entries = dir.entryInfoList(QStringList() << QString("*") + ENTRY_SUFFIX,
+                                     QDir::Files,
+                                     QDir::Time | QDir::Reversed);
+    qint64 total = 0;
+    for (auto & fi : entries)
+        total += fi.size();
+    // oldest entries go first
+    for (auto & fi : entries) {
+        if (total <= this->max_size)
+            break;
+        if (fi.absoluteFilePath() == QFileInfo(this->entry_file_name).absoluteFilePath())
+            continue;
+        total -= fi.size();
+        QFile::remove(fi.absoluteFilePath());
+    }
+}
@@ -0,0 +1,90 @@
+// SPDX-FileCopyrightText: 2024 David Andrs <andrsd@gmail.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <QString>
+#include <QByteArray>
+#include <vector>
+#include "vtkSmartPointer.h"
+#include "reader.h"
+
+class vtkDataObject;
+
+/// On-disk cache of loaded meshes
+///
+/// An entry stores the output of a reader (unstructured grids inside multi-block data sets), the
+/// block/side set/node set information and mesh totals. Array data is laid out so that it can be
+/// used directly from a memory-mapped file. Entries are keyed by file path, size, modification
+/// time and a hash of sampled file contents.
+class MeshCache {
+public:
+    /// Contents of a cache entry
+    struct Contents {
+        /// Reader output
+        vtkSmartPointer<vtkDataObject> data;
+        std::vector<Reader::BlockInformation> blocks;
+        std::vector<Reader::BlockInformation> side_sets;
+        std::vector<Reader::BlockInformation> node_sets;
+        std::size_t total_elements = 0;
+        std::size_t total_nodes = 0;
+        int dimensionality = 0;
+    };
+
+    /// @param file_name Mesh file name
+    /// @param max_size Maximum size of the whole cache in bytes
+    MeshCache(const QString & file_name, qint64 max_size);
+
+    /// Query if there is a valid entry for the mesh file
+    bool hasEntry() const;
+
+    /// Get file name of the cache entry
+    const QString & getEntryFileName() const;
+
+    /// Read the cache entry
+    ///
+    /// Array data references the memory-mapped entry, the mapping is released with the last array
+    ///
+    /// @param contents Receives the contents of the entry
+    /// @return `true` on success, `false` otherwise
+    bool read(Contents & contents) const;
+
+    /// Store reader output as the cache entry
+    ///
+    /// Old entries are removed if the cache grows over its maximum size
+    ///
+    /// @param reader Reader with loaded data
+    /// @return `true` on success, `false` if the output could not be stored
+    bool write(Reader * reader) const;
+
+    /// Store contents as the cache entry (see `write(Reader *)`)
+    bool write(const Contents & contents) const;
+
+    /// Take the contents of a reader to be stored later
+    ///
+    /// The data is a shallow copy of the reader output, so it can be written from another thread
+    /// while the output is used (e.g. gets new arrays)
+    static Contents snapshot(Reader * reader);
+
+    /// Remove the cache entry
+    void remove() const;
+
+    /// Get the directory with cache entries
+    static QString getDirectory();
+
+    /// Query if a file can be cached
+    static bool isSupported(const QString & file_name);
+
+protected:
+    QByteArray computeKey() const;
+    void prune() const;
+
+    /// Mesh file name
+    QString file_name;
+    /// Maximum size of the cache in bytes
+    qint64 max_size;
+    /// Entry key
+    QByteArray key;
+    /// Entry file name
+    QString entry_file_name;
+};
@@ -2,24 +2,43 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 
 #include "meshobject.h"
+#include <QThreadPool>
 #include "vtkDataObject.h"
+#include "vtkDataSet.h"
 #include "vtkAlgorithmOutput.h"
 #include "vtkCompositeDataGeometryFilter.h"
-#include "vtkGeometryFilter.h"
 #include "vtkPolyDataMapper.h"
 #include "vtkDataSetMapper.h"
 #include "vtkMultiBlockDataSet.h"
 #include "vtkActor.h"
 #include "vtkProperty.h"
 #include "vtkPolyDataPlaneClipper.h"
-#include "vtkPlaneCutter.h"
+#include "vtkPolyData.h"
 #include "vtkPlane.h"
+#include "vtkStaticCellLocator.h"
+#include "vtkboundaryextractor.h"
+
+namespace {
+
+vtkSmartPointer<vtkStaticCellLocator>
+createCellLocator(vtkDataSet * data_set)
+{
+    auto locator = vtkSmartPointer<vtkStaticCellLocator>::New();
+    locator->SetDataSet(data_set);
+    locator->BuildLocator();
+    return locator;
+}
+
+} // namespace
 
 MeshObject::MeshObject(vtkAlgorithmOutput * alg_output) :
     clipping(false),
     clipper(vtkSmartPointer<vtkPolyDataPlaneClipper>::New()),
     clip_plane(vtkSmartPointer<vtkPlane>::New()),
-    clipped_actor(vtkSmartPointer<vtkActor>::New())
+    clipped_actor(vtkSmartPointer<vtkActor>::New()),
+    cell_locator(nullptr),
+    cell_locator_build(std::make_shared<CellLocatorBuild>()),
+    cell_locator_input(nullptr)
 {
     auto * algoritm = alg_output->GetProducer();
     this->data_object = algoritm->GetOutputDataObject(0);
@@ -28,13 +47,11 @@ MeshObject::MeshObject(vtkAlgorithmOutput * alg_output) :
         this->geometry = vtkSmartPointer<vtkCompositeDataGeometryFilter>::New();
         this->mapper = vtkSmartPointer<vtkPolyDataMapper>::New();
         this->clipped_away_mapper = vtkSmartPointer<vtkPolyDataMapper>::New();
-        this->cut_away_geometry = vtkSmartPointer<vtkCompositeDataGeometryFilter>::New();
     }
     else {
-        this->geometry = vtkSmartPointer<vtkGeometryFilter>::New();
+        this->geometry = vtkSmartPointer<vtkBoundaryExtractor>::New();
         this->mapper = vtkSmartPointer<vtkDataSetMapper>::New();
         this->clipped_away_mapper = vtkSmartPointer<vtkDataSetMapper>::New();
-        this->cut_away_geometry = vtkSmartPointer<vtkGeometryFilter>::New();
     }
 
     this->geometry->SetInputConnection(0, alg_output);
@@ -52,9 +69,6 @@ MeshObject::MeshObject(vtkAlgorithmOutput * alg_output) :
     double center[3];
     this->bounding_box.GetCenter(center);
     this->center_of_bounds = vtkVector3d(center[0], center[1], center[2]);
-
-    this->cutter = vtkSmartPointer<vtkPlaneCutter>::New();
-    this->cutter->SetInputData(this->data_object);
 }
 
 MeshObject::~MeshObject() {}
@@ -100,6 +114,7 @@ MeshObject::update()
     this->mapper->Update();
     if (this->clipping)
         this->clipped_away_mapper->Update();
+    updateCellLocator();
 }
 
 void
@@ -160,13 +175,8 @@ MeshObject::setClip(bool state)
         this->mapper->SetInputConnection(this->clipper->GetOutputPort());
         this->mapper->Update();
 
-        // set up surface from the cut
-        this->cutter->SetPlane(this->clip_plane);
-        this->cutter->Update();
-
-        this->cut_away_geometry->SetInputConnection(this->cutter->GetOutputPort());
-        this->clipped_away_mapper->SetInputConnection(this->cut_away_geometry->GetOutputPort());
-
+        // the cut surface is computed elsewhere, see `setCutSurface`
+        setCutSurface(nullptr);
         this->clipped_actor->SetMapper(this->clipped_away_mapper);
         this->clipped_actor->SetVisibility(this->actor->GetVisibility());
 
@@ -190,6 +200,7 @@ MeshObject::setClip(bool state)
         this->clipped_away_mapper->RemoveAllInputs();
         this->clipped_actor->SetMapper(nullptr);
     }
+    updateCellLocator();
 }
 
 void
@@ -201,6 +212,40 @@ MeshObject::setClipPlane(vtkPlane * plane)
     this->clip_plane->SetOrigin(origin);
 }
 
+void
+MeshObject::updateClip()
+{
+    if (!this->clipping)
+        return;
+
+    this->clipper->Modified();
+    this->clipper->Update();
+    this->mapper->Update();
+    setCutSurface(nullptr);
+    updateCellLocator();
+}
+
+void
+MeshObject::setCutSurface(vtkPolyData * poly_data)
+{
+    if (!this->clipping)
+        return;
+
+    if (poly_data != nullptr)
+        this->clipped_away_mapper->SetInputDataObject(poly_data);
+    else
+        this->clipped_away_mapper->SetInputDataObject(vtkSmartPointer<vtkPolyData>::New());
+}
+
+vtkSmartPointer<vtkDataObject>
+MeshObject::getSnapshot() const
+{
+    vtkSmartPointer<vtkDataObject> snapshot;
+    snapshot.TakeReference(this->data_object->NewInstance());
+    snapshot->ShallowCopy(this->data_object);
+    return snapshot;
+}
+
 vtkActor *
 MeshObject::getClippedActor()
 {
@@ -212,3 +257,80 @@ MeshObject::getClippedProperty()
 {
     return this->clipped_actor->GetProperty();
 }
+
+vtkSmartPointer<vtkDataSet>
+MeshObject::getOutdatedSurface()
+{
+    auto * data_set = this->mapper->GetInput();
+    if (data_set == nullptr) {
+        this->cell_locator_input = nullptr;
+        invalidateCellLocator();
+        return nullptr;
+    }
+
+    if (this->cell_locator_input == data_set &&
+        this->cell_locator_time.GetMTime() > data_set->GetMTime())
+        return nullptr;
+
+    this->cell_locator_input = data_set;
+    this->cell_locator_time.Modified();
+    vtkSmartPointer<vtkDataSet> snapshot;
+    snapshot.TakeReference(data_set->NewInstance());
+    snapshot->ShallowCopy(data_set);
+    return snapshot;
+}
+
+unsigned long
+MeshObject::invalidateCellLocator()
+{
+    this->cell_locator = nullptr;
+    std::lock_guard<std::mutex> lock(this->cell_locator_build->mutex);
+    this->cell_locator_build->locator = nullptr;
+    return ++this->cell_locator_build->generation;
+}
+
+void
+MeshObject::buildCellLocator()
+{
+    auto snapshot = getOutdatedSurface();
+    if (snapshot == nullptr)
+        return;
+
+    invalidateCellLocator();
+    this->cell_locator = createCellLocator(snapshot);
+}
+
+void
+MeshObject::updateCellLocator()
+{
+    auto snapshot = getOutdatedSurface();
+    if (snapshot == nullptr)
+        return;
+
+    // picking skips this object until the new locator is built
+    auto generation = invalidateCellLocator();
+    QThreadPool::globalInstance()->start(
+        [build = this->cell_locator_build, snapshot, generation]() {
+            auto locator = createCellLocator(snapshot);
+            std::lock_guard<std::mutex> lock(build->mutex);
+            if (build->generation == generation)
+                build->locator = locator;
+        });
+}
+
+vtkSmartPointer<vtkAbstractCellLocator>
+MeshObject::getCellLocator()
+{
+    if (this->cell_locator == nullptr) {
+        // pick up the locator once its rebuild finishes
+        std::lock_guard<std::mutex> lock(this->cell_locator_build->mutex);
+        this->cell_locator = this->cell_locator_build->locator;
+    }
+    return this->cell_locator;
+}
+
+bool
+MeshObject::isBuildingCellLocator()
+{
+    return getCellLocator() == nullptr && this->cell_locator_input != nullptr;
+}
@@ -3,11 +3,15 @@
 
 #pragma once
 
+#include <memory>
+#include <mutex>
 #include "vtkVector.h"
 #include "vtkBoundingBox.h"
 #include "vtkSmartPointer.h"
+#include "vtkTimeStamp.h"
 
 class vtkDataObject;
+class vtkDataSet;
 class vtkAlgorithmOutput;
 class vtkPolyDataAlgorithm;
 class vtkMapper;
@@ -16,7 +20,9 @@ class vtkProperty;
 class vtkVector3d;
 class vtkPlane;
 class vtkPolyDataPlaneClipper;
-class vtkPlaneCutter;
+class vtkPolyData;
+class vtkAbstractCellLocator;
+class vtkStaticCellLocator;
 
 class MeshObject {
 public:
@@ -39,11 +45,46 @@ public:
 
     void setClip(bool state);
     void setClipPlane(vtkPlane * plane);
+    /// Clip the surface by the clip plane
+    ///
+    /// This is the fast part of clipping, the cut surface is hidden until `setCutSurface` supplies
+    /// the one for the new plane.
+    void updateClip();
+    /// Set surface of the cut through the volume by the clip plane (`nullptr` hides it)
+    void setCutSurface(vtkPolyData * poly_data);
+    /// Get shallow copy of the data, which can be read from other threads while arrays are added
+    /// to or removed from the data
+    vtkSmartPointer<vtkDataObject> getSnapshot() const;
     vtkActor * getClippedActor();
     vtkProperty * getClippedProperty();
 
+    /// Build the cell locator of the rendered surface in the calling thread if it is out of date
+    ///
+    /// Meant for objects created off the GUI thread, so that they can be picked as soon as they
+    /// are shown.
+    void buildCellLocator();
+    /// Rebuild the cell locator of the rendered surface in the background if it is out of date
+    ///
+    /// The locator is out of date when the surface changes, i.e. when clipping is turned on/off,
+    /// the clip plane moves or the geometry is modified. This is checked whenever the surface is
+    /// updated. A rebuild creates a new locator over a snapshot of the surface, so locators handed
+    /// out earlier stay valid and can be used from other threads.
+    void updateCellLocator();
+    /// Get the cell locator of the rendered surface, never builds one
+    ///
+    /// @return Cell locator, `nullptr` if there is nothing rendered or the locator is being rebuilt
+    vtkSmartPointer<vtkAbstractCellLocator> getCellLocator();
+    /// Check if the cell locator is being rebuilt in the background
+    bool isBuildingCellLocator();
+
 protected:
     vtkVector3d computeCenterOfBounds();
+    /// Get a snapshot of the rendered surface if the cell locator was not requested for it yet
+    vtkSmartPointer<vtkDataSet> getOutdatedSurface();
+    /// Drop the cell locator and results of its rebuilds still running
+    ///
+    /// @return Generation of the next rebuild
+    unsigned long invalidateCellLocator();
 
     vtkDataObject * data_object;
     vtkSmartPointer<vtkPolyDataAlgorithm> geometry;
@@ -57,6 +98,21 @@ protected:
     vtkSmartPointer<vtkPlane> clip_plane;
     vtkSmartPointer<vtkMapper> clipped_away_mapper;
     vtkSmartPointer<vtkActor> clipped_actor;
-    vtkSmartPointer<vtkPlaneCutter> cutter;
-    vtkSmartPointer<vtkPolyDataAlgorithm> cut_away_geometry;
+
+    /// Locator being rebuilt in the background, shared with the task building it
+    struct CellLocatorBuild {
+        std::mutex mutex;
+        /// Locator built by the latest rebuild, `nullptr` until it finishes
+        vtkSmartPointer<vtkStaticCellLocator> locator;
+        /// Results of rebuilds started in older generations are dropped
+        unsigned long generation = 0;
+    };
+
+    /// Locator of cells in a snapshot of the mapper input, used for picking
+    vtkSmartPointer<vtkStaticCellLocator> cell_locator;
+    std::shared_ptr<CellLocatorBuild> cell_locator_build;
+    /// Mapper input the locator was requested for
+    vtkDataSet * cell_locator_input;
+    /// Time the locator was requested
+    vtkTimeStamp cell_locator_time;
 };
@@ -8,18 +8,41 @@
 #include "view.h"
 #include "colorprofile.h"
 #include "blockobject.h"
+#include "qualityengine.h"
+#include "qualitystatistics.h"
+#include "qualitystatisticswidget.h"
+#include "qualityindex.h"
+#include "vtkboundaryextractor.h"
+#include "selection.h"
+#include "selecttool.h"
 #include "vtkLookupTable.h"
 #include "vtkScalarBarActor.h"
 #include "vtkProperty.h"
 #include "vtkProperty2D.h"
 #include "vtkTextProperty.h"
 #include "vtkCellData.h"
-#include "vtkCellQuality.h"
+#include "vtkDoubleArray.h"
 #include "vtkUnstructuredGrid.h"
 #include "vtkMapper.h"
 #include "vtkRenderer.h"
+#include "vtkActor.h"
+#include "vtkExtractCells.h"
+#include "vtkPolyDataMapper.h"
 #include <QSettings>
 
+namespace {
+
+/// Number of histogram bins
+const int N_BINS = 40;
+/// Number of listed worst cells
+const std::size_t N_WORST_CELLS = 100;
+/// Size of the neighborhood of a cell shown when zooming to it (relative to the cell size)
+const double ZOOM_SCALE = 5.;
+/// Opacity of blocks around the cells shown by the threshold
+const double THRESHOLD_CONTEXT_OPACITY = 0.1;
+
+} // namespace
+
 const char * MeshQualityTool::MESH_QUALITY_FIELD_NAME = "CellQuality";
 
 MeshQualityTool::MeshQualityTool(MainWindow * main_wnd) :
@@ -28,13 +51,21 @@ MeshQualityTool::MeshQualityTool(MainWindow * main_wnd) :
     view(main_wnd->getView()),
     mesh_quality(nullptr),
     lut(nullptr),
-    color_bar(nullptr)
+    color_bar(nullptr),
+    quality_engine(new QualityEngine()),
+    statistics(new QualityStatistics(N_BINS, N_WORST_CELLS)),
+    statistics_widget(nullptr),
+    selected_cell(nullptr),
+    threshold_metric(-1)
 {
 }
 
 MeshQualityTool::~MeshQualityTool()
 {
     delete this->mesh_quality;
+    delete this->quality_engine;
+    delete this->statistics_widget;
+    delete this->statistics;
 }
 
 void
@@ -53,12 +84,32 @@ MeshQualityTool::setupWidgets()
             this,
             &MeshQualityTool::onMetricChanged);
     connect(this->mesh_quality, &MeshQualityWidget::closed, this, &MeshQualityTool::onClose);
+    connect(this->mesh_quality,
+            &MeshQualityWidget::statisticsClicked,
+            this,
+            &MeshQualityTool::onStatistics);
+    connect(this->mesh_quality,
+            &MeshQualityWidget::thresholdChanged,
+            this,
+            &MeshQualityTool::onThresholdChanged);
     this->mesh_quality->setVisible(false);
 
+    this->statistics_widget = new QualityStatisticsWidget(this->main_window);
+    connect(this->statistics_widget,
+            &QualityStatisticsWidget::cellActivated,
+            this,
+            &MeshQualityTool::onCellActivated);
+    this->statistics_widget->setVisible(false);
+
     auto * settings = this->main_window->getSettings();
     auto pos = settings->value("mesh_quality/pos", QPoint(-1, -1)).toPoint();
     if (pos.x() >= 0 && pos.y() >= 0)
         this->mesh_quality->move(pos);
+    auto stats_pos = settings->value("mesh_quality/statistics_pos", QPoint(-1, -1)).toPoint();
+    if (stats_pos.x() >= 0 && stats_pos.y() >= 0)
+        this->statistics_widget->move(stats_pos);
+    auto single_precision = settings->value("mesh_quality/single_precision", false).toBool();
+    this->quality_engine->setSinglePrecision(single_precision);
 }
 
 void
@@ -66,6 +117,10 @@ MeshQualityTool::update()
 {
     auto renderer = this->view->getRenderer();
     renderer->AddActor2D(this->color_bar);
+
+    this->selected_cell = std::make_shared<Selection>();
+    setSelectedCellProperties();
+    renderer->AddActor(this->selected_cell->getActor());
 }
 
 bool
@@ -80,49 +135,62 @@ MeshQualityTool::done()
     this->mesh_quality->done();
 }
 
+void
+MeshQualityTool::clear()
+{
+    releaseQuality();
+}
+
+void
+MeshQualityTool::releaseQuality()
+{
+    for (auto & [id, block] : this->model->getBlocks()) {
+        auto grid = block->getUnstructuredGrid();
+        if (grid != nullptr)
+            grid->GetCellData()->RemoveArray(MESH_QUALITY_FIELD_NAME);
+    }
+    this->quality_engine->clear();
+    this->statistics_widget->setStatistics(nullptr);
+
+    auto renderer = this->view->getRenderer();
+    for (auto & [id, thr] : this->thresholds)
+        renderer->RemoveActor(thr.actor);
+    this->thresholds.clear();
+    this->threshold_metric = -1;
+}
+
 void
 MeshQualityTool::onMeshQuality()
 {
     this->mesh_quality->adjustSize();
     this->mesh_quality->show();
 
+    // quality is computed for the shown metric only, other metrics when they are selected
     auto metric_id = this->mesh_quality->getMetricId();
     onMetricChanged(metric_id);
 
     this->main_window->updateMenuBar();
     this->color_bar->VisibilityOn();
+    this->statistics_widget->show();
 }
 
 void
 MeshQualityTool::onMetricChanged(int metric_id)
 {
+    computeQuality({ metric_id });
     for (auto & [id, block] : this->model->getBlocks()) {
         auto grid = block->getUnstructuredGrid();
-        auto cell_quality = vtkSmartPointer<vtkCellQuality>::New();
-        switch (metric_id) {
-        default:
-        case MESH_METRIC_JACOBIAN:
-            cell_quality->SetQualityMeasureToJacobian();
-            break;
-        case MESH_METRIC_AREA:
-            cell_quality->SetQualityMeasureToArea();
-            break;
-        case MESH_METRIC_VOLUME:
-            cell_quality->SetQualityMeasureToVolume();
-            break;
-        case MESH_METRIC_ASPECT_RATIO:
-            cell_quality->SetQualityMeasureToAspectRatio();
-            break;
-        case MESH_METRIC_CONDITION:
-            cell_quality->SetQualityMeasureToCondition();
-            break;
-        }
-        cell_quality->SetInputData(grid);
-        cell_quality->Update();
-        auto out = cell_quality->GetOutput();
-        grid->GetCellData()->AddArray(out->GetCellData()->GetArray("CellQuality"));
+        auto quality = this->quality_engine->get(id, metric_id);
+        if (grid == nullptr || quality == nullptr)
+            continue;
+        quality->SetName(MESH_QUALITY_FIELD_NAME);
+        grid->GetCellData()->AddArray(quality);
     }
 
+    updateStatistics(metric_id);
+    if (this->selected_cell)
+        this->selected_cell->clear();
+
     double range[2];
     getCellQualityRange(range);
 
@@ -131,18 +199,52 @@ MeshQualityTool::onMetricChanged(int metric_id)
         block->modified();
         block->update();
     }
+
+    this->mesh_quality->setThresholdRange(range);
+    if (this->mesh_quality->isThresholdEnabled())
+        updateThreshold();
+}
+
+void
+MeshQualityTool::computeQuality(const std::vector<int> & metrics)
+{
+    std::vector<QualityEngine::Block> blocks;
+    for (auto & [id, block] : this->model->getBlocks()) {
+        auto grid = block->getUnstructuredGrid();
+        if (grid != nullptr)
+            blocks.push_back({ id, grid });
+    }
+    this->quality_engine->compute(blocks, metrics);
+}
+
+void
+MeshQualityTool::updateStatistics(int metric_id)
+{
+    std::vector<QualityStatistics::Block> blocks;
+    for (auto & [id, block] : this->model->getBlocks()) {
+        auto quality = this->quality_engine->get(id, metric_id);
+        if (quality != nullptr)
+            blocks.push_back({ id, quality });
+    }
+    auto higher_is_worse =
+        metric_id == MESH_METRIC_ASPECT_RATIO || metric_id == MESH_METRIC_CONDITION;
+    this->statistics->compute(blocks, higher_is_worse);
+    this->statistics_widget->setStatistics(this->statistics);
 }
 
 void
 MeshQualityTool::getCellQualityRange(double range[])
 {
+    auto metric_id = this->mesh_quality->getMetricId();
     range[0] = std::numeric_limits<double>::max();
     range[1] = -std::numeric_limits<double>::max();
     for (auto & [id, block] : this->model->getBlocks()) {
-        auto cell_data = block->getCellData();
+        auto quality = this->quality_engine->get(id, metric_id);
+        if (quality == nullptr)
+            continue;
 
         double block_range[2];
-        cell_data->GetRange(MESH_QUALITY_FIELD_NAME, block_range);
+        quality->GetRange(block_range);
         range[0] = std::min(range[0], block_range[0]);
         range[1] = std::max(range[1], block_range[1]);
     }
@@ -151,6 +253,7 @@ MeshQualityTool::getCellQualityRange(double range[])
 void
 MeshQualityTool::onClose()
 {
+    releaseQuality();
     for (auto & [id, block] : this->model->getBlocks()) {
         auto * mapper = block->getMapper();
         mapper->ScalarVisibilityOff();
@@ -160,6 +263,9 @@ MeshQualityTool::onClose()
     this->view->activateRenderMode();
     this->main_window->updateMenuBar();
     this->color_bar->VisibilityOff();
+    this->statistics_widget->hide();
+    if (this->selected_cell)
+        this->selected_cell->clear();
 }
 
 void
@@ -170,6 +276,145 @@ MeshQualityTool::onColorProfileChanged(ColorProfile * profile)
     prop->SetColor(qclr.redF(), qclr.greenF(), qclr.blueF());
 }
 
+void
+MeshQualityTool::onStatistics()
+{
+    this->statistics_widget->show();
+    this->statistics_widget->raise();
+}
+
+void
+MeshQualityTool::onCellActivated(int block_id, qint64 cell_id)
+{
+    auto block = this->model->getBlock(block_id);
+    if (!block || block->getUnstructuredGrid() == nullptr || !this->selected_cell)
+        return;
+
+    Selection::Part part = { block->getUnstructuredGrid(),
+                             { (vtkIdType) cell_id },
+                             block->getActor()->GetMatrix() };
+    this->selected_cell->selectCells({ part });
+
+    // keep the view direction, show the cell with its neighborhood
+    double bounds[6];
+    this->selected_cell->getActor()->GetBounds(bounds);
+    for (int i = 0; i < 3; i++) {
+        auto center = 0.5 * (bounds[2 * i] + bounds[2 * i + 1]);
+        auto half = 0.5 * ZOOM_SCALE * (bounds[2 * i + 1] - bounds[2 * i]);
+        bounds[2 * i] = center - half;
+        bounds[2 * i + 1] = center + half;
+    }
+    this->view->getRenderer()->ResetCamera(bounds);
+    this->view->render();
+}
+
+void
+MeshQualityTool::onThresholdChanged()
+{
+    if (this->mesh_quality->isThresholdEnabled())
+        updateThreshold();
+    else {
+        hideThreshold();
+
+        double range[2];
+        getCellQualityRange(range);
+        for (auto & [id, block] : this->model->getBlocks())
+            setBlockMeshQualityProperties(block, range);
+        this->view->render();
+    }
+}
+
+void
+MeshQualityTool::updateThreshold()
+{
+    auto metric_id = this->mesh_quality->getMetricId();
+    if (metric_id != this->threshold_metric) {
+        // indices of only one metric are kept, they take as much memory as the quality itself
+        for (auto & [id, thr] : this->thresholds)
+            thr.index = nullptr;
+        this->threshold_metric = metric_id;
+    }
+
+    double range[2];
+    getCellQualityRange(range);
+    double threshold[2];
+    this->mesh_quality->getThreshold(threshold);
+    for (auto & [id, block] : this->model->getBlocks()) {
+        auto grid = block->getUnstructuredGrid();
+        auto quality = this->quality_engine->get(id, metric_id);
+        if (grid == nullptr || quality == nullptr)
+            continue;
+
+        auto & thr = this->thresholds[id];
+        if (thr.actor == nullptr) {
+            thr.extract = vtkSmartPointer<vtkExtractCells>::New();
+            thr.extract->SetInputData(grid);
+            thr.extract->AssumeSortedAndUniqueIdsOn();
+            thr.boundary = vtkSmartPointer<vtkBoundaryExtractor>::New();
+            thr.boundary->SetInputConnection(thr.extract->GetOutputPort());
+            thr.mapper = vtkSmartPointer<vtkPolyDataMapper>::New();
+            thr.mapper->SetInputConnection(thr.boundary->GetOutputPort());
+            thr.mapper->ScalarVisibilityOn();
+            thr.mapper->SelectColorArray(MESH_QUALITY_FIELD_NAME);
+            thr.mapper->SetScalarModeToUseCellFieldData();
+            thr.mapper->SetColorModeToMapScalars();
+            thr.mapper->SetLookupTable(this->lut);
+            thr.actor = vtkSmartPointer<vtkActor>::New();
+            thr.actor->SetMapper(thr.mapper);
+            auto * property = thr.actor->GetProperty();
+            property->SetAmbient(0.4);
+            property->SetDiffuse(0.6);
+            property->SetEdgeVisibility(true);
+            property->SetEdgeColor(View::SIDESET_EDGE_CLR.redF(),
+                                   View::SIDESET_EDGE_CLR.greenF(),
+                                   View::SIDESET_EDGE_CLR.blueF());
+            property->SetLineWidth(this->main_window->HIDPI(View::EDGE_WIDTH));
+            this->view->getRenderer()->AddActor(thr.actor);
+        }
+        if (thr.index == nullptr)
+            thr.index = std::make_shared<QualityIndex>(quality);
+
+        // only the cells in the range are extracted, the rest of the block is never visited
+        auto ids = thr.index->query(threshold[0], threshold[1]);
+        thr.extract->SetCellIds(ids.data(), (vtkIdType) ids.size());
+        thr.mapper->SetScalarRange(range);
+        thr.mapper->Update();
+        thr.actor->SetPosition(block->getActor()->GetPosition());
+        thr.actor->SetVisibility(block->visible() && !ids.empty());
+
+        // the rest of the block is kept as a faint context
+        auto * property = block->getProperty();
+        property->SetOpacity(THRESHOLD_CONTEXT_OPACITY);
+        property->SetEdgeVisibility(false);
+    }
+    this->view->render();
+}
+
+void
+MeshQualityTool::hideThreshold()
+{
+    for (auto & [id, thr] : this->thresholds)
+        thr.actor->VisibilityOff();
+}
+
+void
+MeshQualityTool::setSelectedCellProperties()
+{
+    auto * property = this->selected_cell->getActor()->GetProperty();
+    property->SetRepresentationToSurface();
+    property->EdgeVisibilityOn();
+    property->SetColor(SelectTool::SELECTION_CLR.redF(),
+                       SelectTool::SELECTION_CLR.greenF(),
+                       SelectTool::SELECTION_CLR.blueF());
+    property->SetLineWidth(this->main_window->HIDPI(3.5));
+    property->SetEdgeColor(SelectTool::SELECTION_EDGE_CLR.redF(),
+                           SelectTool::SELECTION_EDGE_CLR.greenF(),
+                           SelectTool::SELECTION_EDGE_CLR.blueF());
+    property->SetOpacity(0.5);
+    property->SetAmbient(1);
+    property->SetDiffuse(0);
+}
+
 void
 MeshQualityTool::setupLookupTable()
 {
@@ -431,4 +676,5 @@ MeshQualityTool::closeEvent(QCloseEvent * event)
     auto pos = this->mesh_quality->pos();
     auto * settings = this->main_window->getSettings();
     settings->setValue("mesh_quality/pos", pos);
+    settings->setValue("mesh_quality/statistics_pos", this->statistics_widget->pos());
 }
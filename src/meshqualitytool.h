@@ -6,6 +6,8 @@
 #include <QObject>
 #include "vtkSmartPointer.h"
 #include <QPoint>
+#include <map>
+#include <vector>
 
 class MainWindow;
 class Model;
@@ -13,9 +15,18 @@ class View;
 class MeshQualityWidget;
 class vtkLookupTable;
 class vtkScalarBarActor;
+class vtkExtractCells;
+class vtkBoundaryExtractor;
+class vtkPolyDataMapper;
+class vtkActor;
 class ColorProfile;
 class BlockObject;
 class QCloseEvent;
+class QualityEngine;
+class QualityStatistics;
+class QualityStatisticsWidget;
+class Selection;
+class QualityIndex;
 
 class MeshQualityTool : public QObject {
 public:
@@ -26,6 +37,8 @@ public:
     void setupVtk();
     bool isVisible() const;
     void done();
+    /// Drop the computed cell quality (when the mesh is reloaded)
+    void clear();
     void update();
     void closeEvent(QCloseEvent * event);
 
@@ -34,12 +47,27 @@ public slots:
     void onMetricChanged(int metric_id);
     void onClose();
     void onColorProfileChanged(ColorProfile * profile);
+    void onStatistics();
+    /// Select a cell and zoom to it
+    void onCellActivated(int block_id, qint64 cell_id);
+    void onThresholdChanged();
 
 protected:
     void setupLookupTable();
     void setupColorBar();
     void getCellQualityRange(double range[]);
     void setBlockMeshQualityProperties(std::shared_ptr<BlockObject> block, double range[]);
+    /// Compute metrics of all blocks that were not computed yet
+    void computeQuality(const std::vector<int> & metrics);
+    /// Compute statistics of the quality of all blocks
+    void updateStatistics(int metric_id);
+    void setSelectedCellProperties();
+    /// Show cells with quality in the threshold range
+    void updateThreshold();
+    /// Hide cells shown by the threshold
+    void hideThreshold();
+    /// Free the memory taken by the cell quality and everything derived from it
+    void releaseQuality();
 
     MainWindow * main_window;
     Model *& model;
@@ -47,6 +75,27 @@ protected:
     MeshQualityWidget * mesh_quality;
     vtkSmartPointer<vtkLookupTable> lut;
     vtkSmartPointer<vtkScalarBarActor> color_bar;
+    /// Computes and caches the quality of block cells
+    QualityEngine * quality_engine;
+    /// Statistics of the shown metric
+    QualityStatistics * statistics;
+    QualityStatisticsWidget * statistics_widget;
+    /// Cell selected from the list of the worst cells
+    std::shared_ptr<Selection> selected_cell;
+
+    /// Cells of a block shown by the threshold
+    struct Threshold {
+        /// Cells of the block sorted by quality
+        std::shared_ptr<QualityIndex> index;
+        vtkSmartPointer<vtkExtractCells> extract;
+        vtkSmartPointer<vtkBoundaryExtractor> boundary;
+        vtkSmartPointer<vtkPolyDataMapper> mapper;
+        vtkSmartPointer<vtkActor> actor;
+    };
+    /// Metric the quality indices are built for
+    int threshold_metric;
+    /// Threshold of each block (by block id)
+    std::map<int, Threshold> thresholds;
 
 public:
     static const char * MESH_QUALITY_FIELD_NAME;
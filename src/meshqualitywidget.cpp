@@ -2,28 +2,48 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 
 #include "meshqualitywidget.h"
+#include "rangeslider.h"
 #include <QGraphicsOpacityEffect>
+#include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QLabel>
 #include <QComboBox>
+#include <QPushButton>
+#include <QCheckBox>
+#include <QLineEdit>
+#include <QDoubleValidator>
+#include <algorithm>
+#include <cmath>
 
-MeshQualityWidget::MeshQualityWidget(QWidget * parent) : QWidget(parent)
+namespace {
+
+/// Number of steps of the threshold slider
+const int SLIDER_STEPS = 1000;
+
+} // namespace
+
+MeshQualityWidget::MeshQualityWidget(QWidget * parent) :
+    QWidget(parent),
+    threshold_range { 0., 0. },
+    threshold_values { 0., 0. }
 {
     setWindowTitle("Mesh quality");
     setWindowFlags(Qt::Tool | Qt::WindowStaysOnTopHint | Qt::CustomizeWindowHint |
                    Qt::WindowTitleHint | Qt::WindowCloseButtonHint);
     setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed);
-    setFixedHeight(40);
-    setFixedWidth(250);
+    setFixedHeight(72);
+    setFixedWidth(400);
 
-    this->layout = new QHBoxLayout();
+    this->layout = new QVBoxLayout();
     this->layout->setContentsMargins(15, 8, 15, 8);
 
+    auto * metric_row = new QHBoxLayout();
+
     this->metric_label = new QLabel();
     this->metric_label->setText("Metric");
     this->metric_label->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed);
     this->metric_label->setFixedWidth(50);
-    this->layout->addWidget(this->metric_label);
+    metric_row->addWidget(this->metric_label);
 
     this->metric = new QComboBox();
     this->metric->setEditable(false);
@@ -32,7 +52,37 @@ MeshQualityWidget::MeshQualityWidget(QWidget * parent) : QWidget(parent)
     this->metric->addItem("Condition number", MESH_METRIC_CONDITION);
     this->metric->addItem("Area", MESH_METRIC_AREA);
     this->metric->addItem("Volume", MESH_METRIC_VOLUME);
-    this->layout->addWidget(this->metric);
+    metric_row->addWidget(this->metric);
+
+    this->statistics = new QPushButton("Statistics");
+    this->statistics->setFixedWidth(80);
+    metric_row->addWidget(this->statistics);
+    this->layout->addLayout(metric_row);
+
+    auto * threshold_row = new QHBoxLayout();
+
+    this->threshold = new QCheckBox("Threshold");
+    this->threshold->setFixedWidth(90);
+    threshold_row->addWidget(this->threshold);
+
+    this->threshold_validator = new QDoubleValidator(this);
+
+    this->threshold_lower = new QLineEdit();
+    this->threshold_lower->setValidator(this->threshold_validator);
+    this->threshold_lower->setFixedWidth(60);
+    threshold_row->addWidget(this->threshold_lower);
+
+    this->threshold_slider = new RangeSlider();
+    this->threshold_slider->setRange(0, SLIDER_STEPS);
+    this->threshold_slider->setValues(0, SLIDER_STEPS);
+    threshold_row->addWidget(this->threshold_slider);
+
+    this->threshold_upper = new QLineEdit();
+    this->threshold_upper->setValidator(this->threshold_validator);
+    this->threshold_upper->setFixedWidth(60);
+    threshold_row->addWidget(this->threshold_upper);
+
+    this->layout->addLayout(threshold_row);
 
     this->setLayout(this->layout);
 
@@ -40,6 +90,22 @@ MeshQualityWidget::MeshQualityWidget(QWidget * parent) : QWidget(parent)
             &QComboBox::currentIndexChanged,
             this,
             &MeshQualityWidget::onMetricChanged);
+    connect(this->statistics, &QPushButton::clicked, this, &MeshQualityWidget::statisticsClicked);
+    connect(this->threshold, &QCheckBox::toggled, this, &MeshQualityWidget::onThresholdToggled);
+    connect(this->threshold_slider,
+            &RangeSlider::valuesChanged,
+            this,
+            &MeshQualityWidget::onThresholdSliderChanged);
+    connect(this->threshold_lower,
+            &QLineEdit::editingFinished,
+            this,
+            &MeshQualityWidget::onThresholdEdited);
+    connect(this->threshold_upper,
+            &QLineEdit::editingFinished,
+            this,
+            &MeshQualityWidget::onThresholdEdited);
+
+    onThresholdToggled(false);
 
     this->metric->setCurrentIndex(0);
 }
@@ -57,6 +123,96 @@ MeshQualityWidget::getMetricId()
     return this->metric->currentData().toInt();
 }
 
+void
+MeshQualityWidget::setThresholdRange(const double range[])
+{
+    this->threshold_range[0] = range[0];
+    this->threshold_range[1] = range[1];
+    this->threshold_values[0] = range[0];
+    this->threshold_values[1] = range[1];
+    this->threshold_slider->setValues(0, SLIDER_STEPS);
+    updateThresholdEdits();
+}
+
+bool
+MeshQualityWidget::isThresholdEnabled()
+{
+    return this->threshold->isChecked();
+}
+
+void
+MeshQualityWidget::getThreshold(double range[])
+{
+    range[0] = this->threshold_values[0];
+    range[1] = this->threshold_values[1];
+}
+
+void
+MeshQualityWidget::onThresholdToggled(bool checked)
+{
+    this->threshold_lower->setEnabled(checked);
+    this->threshold_slider->setEnabled(checked);
+    this->threshold_upper->setEnabled(checked);
+    emit thresholdChanged();
+}
+
+void
+MeshQualityWidget::onThresholdSliderChanged(int lower, int upper)
+{
+    this->threshold_values[0] = sliderToValue(lower);
+    this->threshold_values[1] = sliderToValue(upper);
+    updateThresholdEdits();
+    emit thresholdChanged();
+}
+
+void
+MeshQualityWidget::onThresholdEdited()
+{
+    // edit boxes show rounded values, keep the exact ones unless the user typed something
+    if (this->threshold_lower->isModified())
+        this->threshold_values[0] = this->threshold_lower->text().toDouble();
+    if (this->threshold_upper->isModified())
+        this->threshold_values[1] = this->threshold_upper->text().toDouble();
+    this->threshold_values[1] = std::max(this->threshold_values[0], this->threshold_values[1]);
+    this->threshold_slider->setValues(valueToSlider(this->threshold_values[0]),
+                                      valueToSlider(this->threshold_values[1]));
+    updateThresholdEdits();
+    emit thresholdChanged();
+}
+
+void
+MeshQualityWidget::updateThresholdEdits()
+{
+    this->threshold_lower->setText(QString::number(this->threshold_values[0], 'g', 6));
+    this->threshold_lower->setModified(false);
+    this->threshold_upper->setText(QString::number(this->threshold_values[1], 'g', 6));
+    this->threshold_upper->setModified(false);
+}
+
+double
+MeshQualityWidget::sliderToValue(int position) const
+{
+    // ends of the slider hit the range exactly, so that no cell is lost to round-off
+    if (position <= 0)
+        return this->threshold_range[0];
+    else if (position >= SLIDER_STEPS)
+        return this->threshold_range[1];
+    else {
+        auto width = this->threshold_range[1] - this->threshold_range[0];
+        return this->threshold_range[0] + width * position / SLIDER_STEPS;
+    }
+}
+
+int
+MeshQualityWidget::valueToSlider(double value) const
+{
+    auto width = this->threshold_range[1] - this->threshold_range[0];
+    if (width <= 0.)
+        return value < this->threshold_range[0] ? 0 : SLIDER_STEPS;
+    auto position = std::lround((value - this->threshold_range[0]) / width * SLIDER_STEPS);
+    return (int) std::clamp<long>(position, 0, SLIDER_STEPS);
+}
+
 void
 MeshQualityWidget::done()
 {
@@ -6,9 +6,14 @@
 #include <QWidget>
 
 class QGraphicsOpacityEffect;
-class QHBoxLayout;
+class QVBoxLayout;
 class QLabel;
 class QComboBox;
+class QPushButton;
+class QCheckBox;
+class QLineEdit;
+class QDoubleValidator;
+class RangeSlider;
 
 enum MeshQualityMetric {
     MESH_METRIC_JACOBIAN = 1,
@@ -26,19 +31,44 @@ public:
 
     int getMetricId();
     void done();
+    /// Set range of quality the threshold can be chosen from (resets the threshold to it)
+    void setThresholdRange(const double range[]);
+    bool isThresholdEnabled();
+    /// Get range of quality of cells shown by the threshold
+    void getThreshold(double range[]);
 
 signals:
     void closed();
     void metricChanged(int metric_id);
+    void statisticsClicked();
+    /// Threshold was turned on/off or its range changed
+    void thresholdChanged();
 
 protected slots:
     void onMetricChanged(int index);
+    void onThresholdToggled(bool checked);
+    void onThresholdSliderChanged(int lower, int upper);
+    void onThresholdEdited();
 
 protected:
     void closeEvent(QCloseEvent * event) override;
+    /// Show the threshold values in the edit boxes
+    void updateThresholdEdits();
+    double sliderToValue(int position) const;
+    int valueToSlider(double value) const;
 
 protected:
-    QHBoxLayout * layout;
+    QVBoxLayout * layout;
     QLabel * metric_label;
     QComboBox * metric;
+    QPushButton * statistics;
+    QCheckBox * threshold;
+    QDoubleValidator * threshold_validator;
+    QLineEdit * threshold_lower;
+    RangeSlider * threshold_slider;
+    QLineEdit * threshold_upper;
+    /// Range the threshold can be chosen from
+    double threshold_range[2];
+    /// Current threshold
+    double threshold_values[2];
 };
@@ -5,14 +5,18 @@
 #include "mainwindow.h"
 #include "view.h"
 #include "infoview.h"
-#include "vtkExtractBlock.h"
+#include "vtkDataObjectTree.h"
+#include "vtkDataObjectTreeIterator.h"
 #include "vtkBoundingBox.h"
 #include "vtkAlgorithmOutput.h"
+#include "vtkTrivialProducer.h"
+#include "vtkUnstructuredGrid.h"
 #include "blockobject.h"
 #include "sidesetobject.h"
 #include "nodesetobject.h"
-#include "vtkextractmaterialblock.h"
+#include "vtkmaterialpartitioner.h"
 #include <QThread>
+#include <QThreadPool>
 #include <QFileInfo>
 #include <QFileSystemWatcher>
 #include "reader.h"
@@ -21,25 +25,100 @@
 #include "objreader.h"
 #include "stlreader.h"
 #include "mshreader.h"
+#include "cachereader.h"
+#include "meshcache.h"
+#include <QSettings>
+#include <functional>
 
 class LoadThread : public QThread {
 public:
-    explicit LoadThread(std::shared_ptr<Reader> reader);
+    /// @param reader Reader to load the file with
+    /// @param cache Mesh cache to store the loaded mesh into (can be `nullptr`), meshes read from
+    ///        the cache are not stored again
+    /// @param prepare Work done with the loaded data before the thread finishes
+    LoadThread(std::shared_ptr<Reader> reader,
+               std::shared_ptr<MeshCache> cache,
+               std::function<void()> prepare);
+
+    /// Write the loaded mesh into the cache in the background
+    ///
+    /// Called when the loaded objects are shown, so that writing the entry does not delay them
+    void startCacheWrite();
 
 protected:
     void run() override;
 
     std::shared_ptr<Reader> reader;
+    std::shared_ptr<MeshCache> cache;
+    std::function<void()> prepare;
+    /// Loaded mesh to store in the cache
+    MeshCache::Contents cache_contents;
 };
 
-LoadThread::LoadThread(std::shared_ptr<Reader> reader) : QThread(), reader(reader) {}
+LoadThread::LoadThread(std::shared_ptr<Reader> reader,
+                       std::shared_ptr<MeshCache> cache,
+                       std::function<void()> prepare) :
+    QThread(),
+    reader(reader),
+    cache(cache),
+    prepare(prepare)
+{
+}
 
 void
 LoadThread::run()
 {
     this->reader->load();
+    // taken before the prepared objects start to modify the data
+    auto cache_reader = std::dynamic_pointer_cast<CacheReader>(this->reader);
+    if (this->cache && (cache_reader == nullptr || cache_reader->isFallbackUsed()))
+        this->cache_contents = MeshCache::snapshot(this->reader.get());
+    if (this->prepare)
+        this->prepare();
+}
+
+void
+LoadThread::startCacheWrite()
+{
+    if (this->cache == nullptr || this->cache_contents.data == nullptr)
+        return;
+
+    QThreadPool::globalInstance()->start(
+        [cache = this->cache, contents = std::move(this->cache_contents)]() {
+            cache->write(contents);
+        });
+    this->cache_contents = MeshCache::Contents();
+}
+
+//
+
+namespace {
+
+/// Get a data object collected by `Model::splitOutput`
+vtkDataObject *
+findOutput(const std::vector<vtkDataObject *> & output, int multiblock_index)
+{
+    if (multiblock_index >= 0 && (std::size_t) multiblock_index < output.size())
+        return output[multiblock_index];
+    else
+        return nullptr;
+}
+
+/// Create an up-to-date producer of a data object
+vtkSmartPointer<vtkTrivialProducer>
+createProducer(vtkDataObject * data)
+{
+    auto producer = vtkSmartPointer<vtkTrivialProducer>::New();
+    producer->SetOutput(data);
+    producer->Update();
+    return producer;
 }
 
+} // namespace
+
+/// Default maximum size of the mesh cache
+static const qint64 MESH_CACHE_MAX_SIZE = 20LL * 1024 * 1024 * 1024;
+
 //
 
 Model::Model(MainWindow * main_win) :
@@ -50,6 +129,7 @@ Model::Model(MainWindow * main_win) :
     center_of_bounds(0., 0., 0.),
     load_thread(nullptr),
     reader(nullptr),
+    mesh_cache(nullptr),
     file_name(),
     file_watcher(new QFileSystemWatcher()),
     reset_camera_on_load(true)
@@ -94,9 +174,11 @@ Model::clear()
     this->blocks.clear();
     this->side_sets.clear();
     this->node_sets.clear();
+    this->lazy_side_sets.clear();
+    this->lazy_node_sets.clear();
 
-    this->extract_blocks.clear();
-    this->extract_mat_blocks.clear();
+    this->material_partitioner = nullptr;
+    this->producers.clear();
 
     this->file_name = QString();
     auto watched_files = this->file_watcher->files();
@@ -126,71 +208,178 @@ Model::computeTotalBoundingBox()
     this->center_of_bounds = vtkVector3d(center[0], center[1], center[2]);
 }
 
+std::vector<vtkDataObject *>
+Model::splitOutput()
+{
+    auto * port = this->reader->getVtkOutputPort();
+    auto * root = port->GetProducer()->GetOutputDataObject(port->GetIndex());
+    std::vector<vtkDataObject *> output = { root };
+
+    auto * tree = vtkDataObjectTree::SafeDownCast(root);
+    if (tree != nullptr) {
+        auto it = vtkSmartPointer<vtkDataObjectTreeIterator>::Take(tree->NewTreeIterator());
+        it->VisitOnlyLeavesOff();
+        it->SkipEmptyNodesOff();
+        for (it->InitTraversal(); !it->IsDoneWithTraversal(); it->GoToNextItem()) {
+            auto idx = it->GetCurrentFlatIndex();
+            if (idx >= output.size())
+                output.resize(idx + 1, nullptr);
+            output[idx] = it->GetCurrentDataObject();
+        }
+    }
+    return output;
+}
+
 void
-Model::addBlocks()
+Model::prepareObjects()
 {
-    auto * camera = this->view->getActiveCamera();
+    auto output = splitOutput();
+    prepareBlocks(output);
+    prepareSideSets(output);
+    prepareNodeSets(output);
+}
 
+void
+Model::prepareBlocks(const std::vector<vtkDataObject *> & output)
+{
+    auto & prep = this->prepared;
     for (auto & binfo : this->reader->getBlocks()) {
+        // blocks added while loading
+        {
+            std::lock_guard<std::mutex> lock(this->streamed_mutex);
+            if (this->streamed_blocks.count(binfo.number) > 0)
+                continue;
+        }
+
         std::shared_ptr<BlockObject> block;
         if (binfo.multiblock_index != -1) {
-            auto eb = vtkSmartPointer<vtkExtractBlock>::New();
-            eb->SetInputConnection(this->reader->getVtkOutputPort());
-            eb->AddIndex(binfo.multiblock_index);
-            eb->Update();
-            this->extract_blocks.push_back(eb);
-
-            block = std::make_shared<BlockObject>(eb->GetOutputPort(), camera);
+            auto * data = findOutput(output, binfo.multiblock_index);
+            if (data == nullptr)
+                continue;
+            auto producer = createProducer(data);
+            prep.producers.push_back(producer);
+            block = std::make_shared<BlockObject>(producer->GetOutputPort());
         }
         else if (binfo.material_index != -1) {
-            auto eb = vtkSmartPointer<vtkExtractMaterialBlock>::New();
-            eb->SetInputConnection(this->reader->getVtkOutputPort());
-            eb->SetBlockId(binfo.material_index);
-            eb->Update();
-            this->extract_mat_blocks.push_back(eb);
-
-            block = std::make_shared<BlockObject>(eb->GetOutputPort(), camera);
+            // all materials are split in one pass
+            if (prep.material_partitioner == nullptr) {
+                prep.material_partitioner = vtkSmartPointer<vtkMaterialPartitioner>::New();
+                prep.material_partitioner->SetInputConnection(this->reader->getVtkOutputPort());
+                prep.material_partitioner->Update();
+            }
+            auto * grid = prep.material_partitioner->GetMaterialBlock(binfo.material_index);
+            if (grid == nullptr)
+                continue;
+            auto producer = createProducer(grid);
+            prep.producers.push_back(producer);
+            block = std::make_shared<BlockObject>(producer->GetOutputPort());
         }
         else {
-            block = std::make_shared<BlockObject>(this->reader->getVtkOutputPort(), camera);
+            block = std::make_shared<BlockObject>(this->reader->getVtkOutputPort());
+        }
+        // picking uses the locator, so build it before the block is shown
+        block->buildCellLocator();
+        prep.blocks.emplace_back(binfo, block);
+    }
+}
+
+void
+Model::prepareSideSets(const std::vector<vtkDataObject *> & output)
+{
+    auto & prep = this->prepared;
+    for (auto & finfo : this->reader->getSideSets()) {
+        std::shared_ptr<SideSetObject> sideset;
+        auto * data = findOutput(output, finfo.multiblock_index);
+        if (this->reader->isObjectLoaded(finfo) && data != nullptr) {
+            auto producer = createProducer(data);
+            prep.producers.push_back(producer);
+            sideset = std::make_shared<SideSetObject>(producer->GetOutputPort());
         }
+        prep.side_sets.emplace_back(finfo, sideset);
+    }
+}
+
+void
+Model::prepareNodeSets(const std::vector<vtkDataObject *> & output)
+{
+    auto & prep = this->prepared;
+    for (auto & ninfo : this->reader->getNodeSets()) {
+        std::shared_ptr<NodeSetObject> nodeset;
+        auto * data = findOutput(output, ninfo.multiblock_index);
+        if (this->reader->isObjectLoaded(ninfo) && data != nullptr) {
+            auto producer = createProducer(data);
+            prep.producers.push_back(producer);
+            nodeset = std::make_shared<NodeSetObject>(producer->GetOutputPort());
+        }
+        prep.node_sets.emplace_back(ninfo, nodeset);
+    }
+}
+
+void
+Model::attachPreparedObjects()
+{
+    auto & prep = this->prepared;
+    this->material_partitioner = prep.material_partitioner;
+    this->producers.insert(this->producers.end(), prep.producers.begin(), prep.producers.end());
+
+    auto * camera = this->view->getActiveCamera();
+    for (auto & [binfo, block] : prep.blocks) {
+        block->setUpSilhouette(camera);
         this->blocks[binfo.number] = block;
         this->view->addBlock(block);
         emit blockAdded(binfo.number, QString::fromStdString(binfo.name));
     }
+
+    for (auto & [finfo, sideset] : prep.side_sets) {
+        if (sideset) {
+            this->side_sets[finfo.number] = sideset;
+            this->view->addSideSet(sideset);
+        }
+        else
+            this->lazy_side_sets[finfo.number] = finfo;
+        emit sideSetAdded(finfo.number, QString::fromStdString(finfo.name));
+    }
+
+    for (auto & [ninfo, nodeset] : prep.node_sets) {
+        if (nodeset) {
+            this->node_sets[ninfo.number] = nodeset;
+            this->view->addNodeSet(nodeset);
+        }
+        else
+            this->lazy_node_sets[ninfo.number] = ninfo;
+        emit nodeSetAdded(ninfo.number, QString::fromStdString(ninfo.name));
+    }
 }
 
 void
-Model::addSideSets()
+Model::loadSideSet(int sideset_id)
 {
-    for (auto & finfo : this->reader->getSideSets()) {
-        auto eb = vtkSmartPointer<vtkExtractBlock>::New();
-        eb->SetInputConnection(this->reader->getVtkOutputPort());
-        eb->AddIndex(finfo.multiblock_index);
-        eb->Update();
-        this->extract_blocks.push_back(eb);
-
-        auto sideset = std::make_shared<SideSetObject>(eb->GetOutputPort());
-        this->side_sets[finfo.number] = sideset;
+    auto it = this->lazy_side_sets.find(sideset_id);
+    if (it == this->lazy_side_sets.end())
+        return;
+
+    auto * port = this->reader->loadObject(it->second);
+    this->lazy_side_sets.erase(it);
+    if (port != nullptr) {
+        auto sideset = std::make_shared<SideSetObject>(port);
+        this->side_sets[sideset_id] = sideset;
         this->view->addSideSet(sideset);
-        emit sideSetAdded(finfo.number, QString::fromStdString(finfo.name));
     }
 }
 
 void
-Model::addNodeSets()
+Model::loadNodeSet(int nodeset_id)
 {
-    for (auto & ninfo : reader->getNodeSets()) {
-        auto eb = vtkSmartPointer<vtkExtractBlock>::New();
-        eb->SetInputConnection(this->reader->getVtkOutputPort());
-        eb->AddIndex(ninfo.multiblock_index);
-        eb->Update();
-        this->extract_blocks.push_back(eb);
-
-        auto nodeset = std::make_shared<NodeSetObject>(eb->GetOutputPort());
-        this->node_sets[ninfo.number] = nodeset;
+    auto it = this->lazy_node_sets.find(nodeset_id);
+    if (it == this->lazy_node_sets.end())
+        return;
+
+    auto * port = this->reader->loadObject(it->second);
+    this->lazy_node_sets.erase(it);
+    if (port != nullptr) {
+        auto nodeset = std::make_shared<NodeSetObject>(port);
+        this->node_sets[nodeset_id] = nodeset;
         this->view->addNodeSet(nodeset);
-        emit nodeSetAdded(ninfo.number, QString::fromStdString(ninfo.name));
     }
 }
 
@@ -242,28 +431,81 @@ Model::loadFile(const QString & file_name)
     this->reader = createReader(file_name);
     if (this->reader) {
         this->file_name = file_name;
-        this->load_thread = std::make_shared<LoadThread>(this->reader);
+        this->reader->setProgressCallback([this](const Reader::LoadProgress & progress) {
+            QMetaObject::invokeMethod(
+                this,
+                [this, progress]() {
+                    emit loadProgress(progress.bytes_read,
+                                      progress.file_size,
+                                      progress.blocks_done,
+                                      progress.total_blocks);
+                },
+                Qt::QueuedConnection);
+        });
+        // the grid, its producer, surface and cell locator are created here, the GUI thread
+        // attaches them to the view
+        this->reader->setBlockLoadedCallback(
+            [this](const Reader::BlockInformation & binfo, vtkDataObject * data) {
+                // the view adds arrays to the grid, so it gets its own copy and the reader output
+                // stays untouched
+                vtkSmartPointer<vtkDataObject> copy;
+                copy.TakeReference(data->NewInstance());
+                copy->ShallowCopy(data);
+                auto producer = createProducer(copy);
+                auto block = std::make_shared<BlockObject>(producer->GetOutputPort());
+                block->buildCellLocator();
+                {
+                    std::lock_guard<std::mutex> lock(this->streamed_mutex);
+                    this->streamed_blocks.insert(binfo.number);
+                }
+                QMetaObject::invokeMethod(
+                    this,
+                    [this, binfo, producer, block]() { onBlockLoaded(binfo, producer, block); },
+                    Qt::QueuedConnection);
+            });
+        this->load_thread =
+            std::make_shared<LoadThread>(this->reader, this->mesh_cache, [this]() {
+                prepareObjects();
+            });
         connect(this->load_thread.get(), &LoadThread::finished, this, &Model::onLoadFinished);
-        this->load_thread->start(QThread::IdlePriority);
+        this->load_thread->start(QThread::LowPriority);
     }
 }
 
+void
+Model::onBlockLoaded(const Reader::BlockInformation & binfo,
+                     vtkSmartPointer<vtkTrivialProducer> producer,
+                     std::shared_ptr<BlockObject> block)
+{
+    this->producers.push_back(producer);
+    // the camera is used by the rendering on this thread
+    block->setUpSilhouette(this->view->getActiveCamera());
+    bool first_block = this->blocks.empty();
+    this->blocks[binfo.number] = block;
+    this->view->addBlock(block);
+    emit blockAdded(binfo.number, QString::fromStdString(binfo.name));
+
+    if (first_block && this->reset_camera_on_load)
+        this->view->resetCamera();
+    this->view->render();
+}
+
 void
 Model::onLoadFinished()
 {
     if (this->hasValidFile()) {
         this->file_watcher->addPath(this->file_name);
-        this->info_view->clear();
-        addBlocks();
-        addSideSets();
-        addNodeSets();
+        attachPreparedObjects();
         computeTotalBoundingBox();
         this->view->updateBoundingBox();
         this->view->setInteractorStyle(getDimension());
         if (this->reset_camera_on_load)
             this->view->resetCamera();
         this->info_view->update();
+        this->load_thread->startCacheWrite();
     }
+    this->prepared = PreparedObjects();
+    this->streamed_blocks.clear();
     emit loadFinished();
     this->load_thread = nullptr;
 }
@@ -274,6 +516,12 @@ Model::hasFile() const
     return !this->file_name.isEmpty();
 }
 
+bool
+Model::isLoading() const
+{
+    return this->load_thread != nullptr;
+}
+
 bool
 Model::hasValidFile() const
 {
@@ -332,6 +580,26 @@ Model::onFileChanged(const QString & path)
 
 std::shared_ptr<Reader>
 Model::createReader(const QString & file_name)
+{
+    this->mesh_cache = nullptr;
+    auto reader = createFileReader(file_name);
+    if (reader == nullptr || !MeshCache::isSupported(file_name))
+        return reader;
+
+    auto * settings = this->main_window->getSettings();
+    if (!settings->value("mesh_cache/enabled", true).toBool())
+        return reader;
+
+    auto max_size = settings->value("mesh_cache/max_size", MESH_CACHE_MAX_SIZE).toLongLong();
+    this->mesh_cache = std::make_shared<MeshCache>(file_name, max_size);
+    if (this->mesh_cache->hasEntry())
+        return std::make_shared<CacheReader>(file_name.toStdString(), this->mesh_cache, reader);
+    else
+        return reader;
+}
+
+std::shared_ptr<Reader>
+Model::createFileReader(const QString & file_name)
 {
     if (file_name.endsWith(".e") || file_name.endsWith(".exo"))
         return std::make_shared<ExodusIIReader>(file_name.toStdString());
@@ -7,11 +7,15 @@
 #include <QFileInfo>
 #include "vtkVector.h"
 #include "vtkBoundingBox.h"
+#include "vtkSmartPointer.h"
+#include "reader.h"
 #include <vector>
+#include <memory>
+#include <mutex>
+#include <set>
 
 class MainWindow;
-class vtkExtractBlock;
-class vtkExtractMaterialBlock;
+class vtkMaterialPartitioner;
 class vtkActor;
 class vtkAlgorithmOutput;
 class BlockObject;
@@ -19,7 +23,9 @@ class SideSetObject;
 class NodeSetObject;
 class QString;
 class LoadThread;
-class Reader;
+class vtkDataObject;
+class vtkTrivialProducer;
+class MeshCache;
 class View;
 class InfoView;
 class QFileSystemWatcher;
@@ -45,9 +51,15 @@ public:
 
     void clear();
     void loadFile(const QString & file_name);
+    /// Load a side set that was not loaded with the file
+    void loadSideSet(int sideset_id);
+    /// Load a node set that was not loaded with the file
+    void loadNodeSet(int nodeset_id);
     vtkBoundingBox getTotalBoundingBox();
 
     bool hasFile() const;
+    /// Query if a file is being loaded
+    bool isLoading() const;
     bool hasValidFile() const;
     const QString & getFileName() const;
     QFileInfo getFileInfo();
@@ -64,6 +76,13 @@ signals:
     void sideSetAdded(int id, const QString & name);
     void nodeSetAdded(int id, const QString & name);
     void loadFinished();
+    /// Progress of loading a file
+    ///
+    /// @param bytes_read Number of bytes read from the file
+    /// @param file_size Size of the file in bytes
+    /// @param blocks_done Number of blocks that were added
+    /// @param total_blocks Total number of blocks (0 if blocks are added when loading finishes)
+    void loadProgress(qint64 bytes_read, qint64 file_size, int blocks_done, int total_blocks);
     void fileChanged(const QString & path);
 
 public slots:
@@ -71,21 +90,61 @@ public slots:
     void onFileChanged(const QString & path);
 
 protected:
-    void addBlocks();
-    void addSideSets();
-    void addNodeSets();
+    /// Attach a block created while loading (runs on the GUI thread)
+    void onBlockLoaded(const Reader::BlockInformation & binfo,
+                       vtkSmartPointer<vtkTrivialProducer> producer,
+                       std::shared_ptr<BlockObject> block);
+    /// Walk the reader output once and collect its data objects by their flat index
+    ///
+    /// @return Data objects indexed by `BlockInformation::multiblock_index`
+    std::vector<vtkDataObject *> splitOutput();
+    /// Create objects from the loaded data, runs in the load thread
+    ///
+    /// Silhouettes are set up when the objects are attached, see `attachPreparedObjects`
+    void prepareObjects();
+    void prepareBlocks(const std::vector<vtkDataObject *> & output);
+    void prepareSideSets(const std::vector<vtkDataObject *> & output);
+    void prepareNodeSets(const std::vector<vtkDataObject *> & output);
+    /// Add prepared objects to the model and the view
+    void attachPreparedObjects();
     void computeTotalBoundingBox();
+    /// Create a reader for a file, using the mesh cache if it has the file
     std::shared_ptr<Reader> createReader(const QString & file_name);
+    /// Create a reader for a file based on its extension
+    std::shared_ptr<Reader> createFileReader(const QString & file_name);
 
     MainWindow * main_window;
     View *& view;
     InfoView *& info_view;
 
-    std::vector<vtkSmartPointer<vtkExtractBlock>> extract_blocks;
-    std::vector<vtkSmartPointer<vtkExtractMaterialBlock>> extract_mat_blocks;
+    /// Splits the reader output by material ids (created on first use)
+    vtkSmartPointer<vtkMaterialPartitioner> material_partitioner;
+    /// Producers of blocks, side sets and node sets
+    std::vector<vtkSmartPointer<vtkTrivialProducer>> producers;
     std::map<int, std::shared_ptr<BlockObject>> blocks;
     std::map<int, std::shared_ptr<SideSetObject>> side_sets;
     std::map<int, std::shared_ptr<NodeSetObject>> node_sets;
+    /// Side sets that are loaded when they are first shown
+    std::map<int, Reader::BlockInformation> lazy_side_sets;
+    /// Node sets that are loaded when they are first shown
+    std::map<int, Reader::BlockInformation> lazy_node_sets;
+
+    /// Objects created by the load thread, waiting to be attached to the view
+    struct PreparedObjects {
+        std::vector<std::pair<Reader::BlockInformation, std::shared_ptr<BlockObject>>> blocks;
+        /// Side sets, `nullptr` if the side set is loaded when first shown
+        std::vector<std::pair<Reader::BlockInformation, std::shared_ptr<SideSetObject>>>
+            side_sets;
+        /// Node sets, `nullptr` if the node set is loaded when first shown
+        std::vector<std::pair<Reader::BlockInformation, std::shared_ptr<NodeSetObject>>>
+            node_sets;
+        std::vector<vtkSmartPointer<vtkTrivialProducer>> producers;
+        vtkSmartPointer<vtkMaterialPartitioner> material_partitioner;
+    } prepared;
+    /// Numbers of blocks that were created while loading
+    std::set<int> streamed_blocks;
+    /// Guards `streamed_blocks`
+    std::mutex streamed_mutex;
 
     /// Bounding box
     vtkBoundingBox bbox;
@@ -94,6 +153,8 @@ protected:
 
     std::shared_ptr<LoadThread> load_thread;
     std::shared_ptr<Reader> reader;
+    /// Mesh cache for the loaded file (`nullptr` if the file is not cached)
+    std::shared_ptr<MeshCache> mesh_cache;
     QString file_name;
     QFileSystemWatcher * file_watcher;
     bool reset_camera_on_load;
@@ -3,6 +3,8 @@
 
 #include "mshreader.h"
 #include "vtkmshreader.h"
+#include "vtkUnstructuredGrid.h"
+#include <algorithm>
 
 MSHReader::MSHReader(const std::string & file_name) : Reader(file_name), reader(nullptr) {}
 
@@ -12,6 +14,15 @@ void
 MSHReader::load()
 {
     this->reader = vtkSmartPointer<vtkMshReader>::New();
+    observeProgress(this->reader);
+    // side sets are not shown by default, so only element blocks are worth handing out early
+    this->reader->SetBlockReadyCallback(
+        [this](int object_type, int object_index, vtkUnstructuredGrid * grid) {
+            if (object_type == vtkMshReader::ELEM_BLOCK)
+                reportBlockLoaded(getBlockInformation(object_type, object_index),
+                                  grid,
+                                  this->reader->GetNumberOfObjects(object_type));
+        });
 
     this->reader->SetFileName(this->file_name.c_str());
     this->reader->UpdateInformation();
@@ -73,28 +84,36 @@ void
 MSHReader::readBlockInfo()
 {
     std::vector<int> obj_types = { vtkMshReader::ELEM_BLOCK, vtkMshReader::SIDE_SET };
-
-    // Index to be used with the vtkExtractBlock::AddIndex method
-    int index = 0;
-    // Loop over all blocks of the MultiBlockDataSet
     for (auto & otype : obj_types) {
-        index += 1;
         this->block_info[otype] = std::map<int, BlockInformation>();
         for (int j = 0; j < this->reader->GetNumberOfObjects(otype); j++) {
-            index += 1;
-            std::string name = this->reader->GetObjectNameStr(otype, j);
-            auto vtkid = this->reader->GetObjectId(otype, j);
-            if (name.rfind("Unnamed", 0) == 0)
-                name = std::to_string(vtkid);
-
-            BlockInformation binfo;
-            binfo.object_type = otype;
-            binfo.name = name;
-            binfo.number = vtkid;
-            binfo.object_index = j;
-            binfo.multiblock_index = index;
-            binfo.material_index = -1;
-            this->block_info[otype][vtkid] = binfo;
+            auto binfo = getBlockInformation(otype, j);
+            this->block_info[otype][binfo.number] = binfo;
         }
     }
 }
+
+Reader::BlockInformation
+MSHReader::getBlockInformation(int object_type, int object_index)
+{
+    // Index to be used with the vtkExtractBlock::AddIndex method: the MultiBlockDataSet holds one
+    // MultiBlockDataSet per object type, each holding the grids of its objects
+    int index = 1;
+    for (int otype = vtkMshReader::ELEM_BLOCK; otype < object_type; otype++)
+        index += 1 + std::max(this->reader->GetNumberOfObjects(otype), 0);
+    index += 1 + object_index;
+
+    std::string name = this->reader->GetObjectNameStr(object_type, object_index);
+    auto vtkid = this->reader->GetObjectId(object_type, object_index);
+    if (name.rfind("Unnamed", 0) == 0)
+        name = std::to_string(vtkid);
+
+    BlockInformation binfo;
+    binfo.object_type = object_type;
+    binfo.name = name;
+    binfo.number = vtkid;
+    binfo.object_index = object_index;
+    binfo.multiblock_index = index;
+    binfo.material_index = -1;
+    return binfo;
+}
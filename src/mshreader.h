@@ -26,6 +26,7 @@ public:
 
 protected:
     void readBlockInfo();
+    BlockInformation getBlockInformation(int object_type, int object_index);
 
     vtkSmartPointer<vtkMshReader> reader;
     std::map<int, std::map<int, BlockInformation>> block_info;
@@ -15,14 +15,16 @@ OInteractorInterface::OInteractorInterface(MainWindow * widget) :
 }
 
 void
-OInteractorInterface::onLeftButtonPress(const QPoint & pos)
+OInteractorInterface::onLeftButtonPress(const QPoint & pos, const Qt::KeyboardModifiers & mods)
 {
     this->last_mouse_pos = pos;
+    this->widget->onLeftButtonPress(pos, mods);
 }
 
 void
 OInteractorInterface::onLeftButtonRelease(const QPoint & pos)
 {
+    this->widget->onLeftButtonRelease(pos);
     if (this->last_mouse_pos == pos)
         this->widget->onClicked(pos);
 }
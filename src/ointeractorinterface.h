@@ -15,7 +15,7 @@ public:
     explicit OInteractorInterface(MainWindow * widget);
 
 protected:
-    void onLeftButtonPress(const QPoint & pos);
+    void onLeftButtonPress(const QPoint & pos, const Qt::KeyboardModifiers & mods);
     void onLeftButtonRelease(const QPoint & pos);
     void onMouseMove(const QPoint & pos);
 
@@ -17,7 +17,8 @@ OInteractorStyle2D::OnLeftButtonDown()
 {
     auto event_pos = this->Interactor->GetEventPosition();
     auto pt = QPoint(event_pos[0], event_pos[1]);
-    OInteractorInterface::onLeftButtonPress(pt);
+    auto mods = getKeyboardModifiers(this->Interactor);
+    OInteractorInterface::onLeftButtonPress(pt, mods);
 }
 
 void
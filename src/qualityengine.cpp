@@ -0,0 +1,641 @@
+// SPDX-FileCopyrightText: 2024 David Andrs <andrsd@gmail.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "qualityengine.h"
+#include "meshqualitywidget.h"
+#include "vtkUnstructuredGrid.h"
+#include "vtkUnsignedCharArray.h"
+#include "vtkDoubleArray.h"
+#include "vtkCellData.h"
+#include "vtkCellType.h"
+#include "vtkGenericCell.h"
+#include "vtkIdList.h"
+#include "vtkPoints.h"
+#include "vtkFloatArray.h"
+#include "vtkCellQuality.h"
+#include "vtkMeshQuality.h"
+#include "vtkSMPTools.h"
+#include "vtkSMPThreadLocalObject.h"
+#include <algorithm>
+#include <cmath>
+
+const double QualityEngine::UNSUPPORTED = -1.;
+
+namespace {
+
+/// Number of cells evaluated together by the metric kernels
+const int BATCH = 8;
+/// Values verdict uses for near zero and infinite quantities
+const double VERDICT_DBL_MIN = 1.0e-30;
+const double VERDICT_DBL_MAX = 1.0e+30;
+
+/// Check that all cells of a grid can be processed by `computeCellQuality`
+///
+/// @param grid Grid to check
+/// @param cell_type Type of all cells if they have the same type, otherwise `VTK_EMPTY_CELL`
+bool
+isSupported(vtkUnstructuredGrid * grid, int & cell_type)
+{
+    cell_type = VTK_EMPTY_CELL;
+    auto * types = grid->GetCellTypesArray();
+    if (types == nullptr)
+        return true;
+    for (vtkIdType i = 0; i < types->GetNumberOfValues(); i++) {
+        int type = types->GetValue(i);
+        switch (type) {
+        case VTK_TRIANGLE:
+        case VTK_QUAD:
+        case VTK_TETRA:
+        case VTK_HEXAHEDRON:
+            break;
+        default:
+            return false;
+        }
+        if (i == 0)
+            cell_type = type;
+        else if (type != cell_type)
+            cell_type = VTK_EMPTY_CELL;
+    }
+    return true;
+}
+
+// Metric kernels
+//
+// Coordinates of a batch of cells are gathered into a structure of arrays, so that the loops over
+// the cells of a batch have no dependencies and no indirect accesses and can be vectorized by the
+// compiler. The formulas are the ones verdict uses (and therefore `vtkMeshQuality`).
+
+struct Vec {
+    double x, y, z;
+};
+
+inline Vec
+operator+(const Vec & a, const Vec & b)
+{
+    return { a.x + b.x, a.y + b.y, a.z + b.z };
+}
+
+inline Vec
+operator-(const Vec & a, const Vec & b)
+{
+    return { a.x - b.x, a.y - b.y, a.z - b.z };
+}
+
+inline Vec
+operator*(double a, const Vec & b)
+{
+    return { a * b.x, a * b.y, a * b.z };
+}
+
+inline double
+dot(const Vec & a, const Vec & b)
+{
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+inline Vec
+cross(const Vec & a, const Vec & b)
+{
+    return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+}
+
+inline double
+fixRange(double value)
+{
+    return value > 0 ? std::min(value, VERDICT_DBL_MAX) : std::max(value, -VERDICT_DBL_MAX);
+}
+
+/// Divide by a determinant, `VERDICT_DBL_MAX` if the determinant is not positive
+///
+/// Written without branches, so that the loops calling it can be vectorized.
+inline double
+divideByDet(double value, double det)
+{
+    bool degenerate = det <= VERDICT_DBL_MIN;
+    double quotient = value / (degenerate ? 1. : det);
+    return degenerate ? VERDICT_DBL_MAX : quotient;
+}
+
+/// Condition number of the map given by three edge vectors
+inline double
+conditionComp(const Vec & xxi, const Vec & xet, const Vec & xze)
+{
+    double det = dot(xxi, cross(xet, xze));
+    double term1 = dot(xxi, xxi) + dot(xet, xet) + dot(xze, xze);
+    auto a = cross(xxi, xet);
+    auto b = cross(xet, xze);
+    auto c = cross(xze, xxi);
+    double term2 = dot(a, a) + dot(b, b) + dot(c, c);
+    return divideByDet(std::sqrt(term1 * term2), det);
+}
+
+/// Node coordinates of a batch of cells
+template <int N_NODES>
+struct Batch {
+    double x[N_NODES][BATCH];
+    double y[N_NODES][BATCH];
+    double z[N_NODES][BATCH];
+};
+
+/// Evaluate a function of node coordinates for each cell of a batch
+template <int N_NODES, typename FN>
+inline void
+forEachCell(const Batch<N_NODES> & batch, double out[BATCH], FN fn)
+{
+    for (int l = 0; l < BATCH; l++) {
+        Vec p[N_NODES];
+        for (int i = 0; i < N_NODES; i++)
+            p[i] = { batch.x[i][l], batch.y[i][l], batch.z[i][l] };
+        out[l] = fn(p);
+    }
+}
+
+/// Linear tetrahedron
+struct Tet4 {
+    static const int N_NODES = 4;
+
+    static double
+    jacobian(const Vec * p)
+    {
+        auto side0 = p[1] - p[0];
+        auto side2 = p[0] - p[2];
+        auto side3 = p[3] - p[0];
+        return dot(side3, cross(side2, side0));
+    }
+
+    static double
+    volume(const Vec * p)
+    {
+        return jacobian(p) / 6.;
+    }
+
+    static double
+    aspectRatio(const Vec * p)
+    {
+        const double normal_coeff = std::sqrt(6.) / 12.;
+        auto ab = p[1] - p[0];
+        auto ac = p[2] - p[0];
+        auto ad = p[3] - p[0];
+        double det = dot(ab, cross(ac, ad));
+        auto bc = p[2] - p[1];
+        auto bd = p[3] - p[1];
+        auto cd = p[3] - p[2];
+        double hm2 = std::max({ dot(ab, ab), dot(bc, bc), dot(ac, ac), dot(ad, ad), dot(bd, bd),
+                                dot(cd, cd) });
+        auto a = cross(ab, bc);
+        auto b = cross(ab, ad);
+        auto c = cross(ac, ad);
+        auto d = cross(bc, cd);
+        double faces = std::sqrt(dot(a, a)) + std::sqrt(dot(b, b)) + std::sqrt(dot(c, c)) +
+                       std::sqrt(dot(d, d));
+        double aspect_ratio = divideByDet(normal_coeff * std::sqrt(hm2) * faces, det);
+        return det < VERDICT_DBL_MIN ? VERDICT_DBL_MAX : fixRange(aspect_ratio);
+    }
+
+    static double
+    condition(const Vec * p)
+    {
+        const double sqrt3 = std::sqrt(3.);
+        const double sqrt6 = std::sqrt(6.);
+        auto side0 = p[1] - p[0];
+        auto side2 = p[0] - p[2];
+        auto side3 = p[3] - p[0];
+        auto c1 = side0;
+        auto c2 = (1. / sqrt3) * (-2. * side2 - side0);
+        auto c3 = (1. / sqrt6) * (3. * side3 + side2 - side0);
+        double term1 = dot(c1, c1) + dot(c2, c2) + dot(c3, c3);
+        auto a = cross(c1, c2);
+        auto b = cross(c2, c3);
+        auto c = cross(c1, c3);
+        double term2 = dot(a, a) + dot(b, b) + dot(c, c);
+        double det = dot(c1, cross(c2, c3));
+        return divideByDet(std::sqrt(term1 * term2), 3. * det);
+    }
+
+    /// Evaluate a metric for a batch of cells
+    ///
+    /// @return `false` if there is no kernel for the metric
+    static bool
+    evaluate(int metric, const Batch<N_NODES> & batch, double out[BATCH])
+    {
+        switch (metric) {
+        case MESH_METRIC_JACOBIAN:
+            forEachCell(batch, out, jacobian);
+            return true;
+        case MESH_METRIC_VOLUME:
+            forEachCell(batch, out, volume);
+            return true;
+        case MESH_METRIC_ASPECT_RATIO:
+            forEachCell(batch, out, aspectRatio);
+            return true;
+        case MESH_METRIC_CONDITION:
+            forEachCell(batch, out, condition);
+            return true;
+        case MESH_METRIC_AREA:
+            std::fill(out, out + BATCH, QualityEngine::UNSUPPORTED);
+            return true;
+        default:
+            return false;
+        }
+    }
+};
+
+/// Linear hexahedron
+struct Hex8 {
+    static const int N_NODES = 8;
+
+    /// Edge vectors at a corner of a hexahedron (in the directions of the reference axes)
+    static void
+    cornerEdges(const Vec * p, int corner, Vec & xxi, Vec & xet, Vec & xze)
+    {
+        // pairs of nodes (head, tail) defining the edge vectors at each corner
+        static const int edges[8][6] = { { 1, 0, 3, 0, 4, 0 }, { 1, 0, 2, 1, 5, 1 },
+                                         { 2, 3, 2, 1, 6, 2 }, { 2, 3, 3, 0, 7, 3 },
+                                         { 5, 4, 7, 4, 4, 0 }, { 5, 4, 6, 5, 5, 1 },
+                                         { 6, 7, 6, 5, 6, 2 }, { 6, 7, 7, 4, 7, 3 } };
+        auto * e = edges[corner];
+        xxi = p[e[0]] - p[e[1]];
+        xet = p[e[2]] - p[e[3]];
+        xze = p[e[4]] - p[e[5]];
+    }
+
+    static double
+    cornerJacobian(const Vec * p, int corner)
+    {
+        Vec xxi, xet, xze;
+        cornerEdges(p, corner, xxi, xet, xze);
+        return dot(xxi, cross(xet, xze));
+    }
+
+    static double
+    cornerCondition(const Vec * p, int corner)
+    {
+        Vec xxi, xet, xze;
+        cornerEdges(p, corner, xxi, xet, xze);
+        return conditionComp(xxi, xet, xze);
+    }
+
+    // corners are listed explicitly (not looped over), so that the loops over cells are vectorized
+
+    static double
+    jacobian(const Vec * p)
+    {
+        auto efg1 = (p[1] + p[2] + p[5] + p[6]) - (p[0] + p[3] + p[4] + p[7]);
+        auto efg2 = (p[2] + p[3] + p[6] + p[7]) - (p[0] + p[1] + p[4] + p[5]);
+        auto efg3 = (p[4] + p[5] + p[6] + p[7]) - (p[0] + p[1] + p[2] + p[3]);
+        double center = dot(efg1, cross(efg2, efg3)) / 64.;
+        return fixRange(std::min({ center,
+                                   cornerJacobian(p, 0),
+                                   cornerJacobian(p, 1),
+                                   cornerJacobian(p, 2),
+                                   cornerJacobian(p, 3),
+                                   cornerJacobian(p, 4),
+                                   cornerJacobian(p, 5),
+                                   cornerJacobian(p, 6),
+                                   cornerJacobian(p, 7) }));
+    }
+
+    static double
+    condition(const Vec * p)
+    {
+        // verdict defines it as the maximum aspect Frobenius over the corners
+        double cond = std::max({ cornerCondition(p, 0),
+                                 cornerCondition(p, 1),
+                                 cornerCondition(p, 2),
+                                 cornerCondition(p, 3),
+                                 cornerCondition(p, 4),
+                                 cornerCondition(p, 5),
+                                 cornerCondition(p, 6),
+                                 cornerCondition(p, 7) });
+        return cond >= VERDICT_DBL_MAX ? VERDICT_DBL_MAX : fixRange(cond / 3.);
+    }
+
+    /// Evaluate a metric for a batch of cells
+    ///
+    /// @return `false` if there is no kernel for the metric
+    static bool
+    evaluate(int metric, const Batch<N_NODES> & batch, double out[BATCH])
+    {
+        switch (metric) {
+        case MESH_METRIC_JACOBIAN:
+            forEachCell(batch, out, jacobian);
+            return true;
+        case MESH_METRIC_CONDITION:
+            forEachCell(batch, out, condition);
+            return true;
+        case MESH_METRIC_AREA:
+        case MESH_METRIC_ASPECT_RATIO:
+            std::fill(out, out + BATCH, QualityEngine::UNSUPPORTED);
+            return true;
+        default:
+            return false;
+        }
+    }
+};
+
+/// Quality of the cells of a block, stored in single or double precision
+struct Output {
+    double * dbl = nullptr;
+    float * flt = nullptr;
+
+    bool
+    isSet() const
+    {
+        return this->dbl != nullptr || this->flt != nullptr;
+    }
+
+    void
+    set(vtkIdType cell_id, double value)
+    {
+        if (this->dbl != nullptr)
+            this->dbl[cell_id] = value;
+        else
+            this->flt[cell_id] = (float) value;
+    }
+
+    void
+    set(vtkIdType first, const double * values, int n)
+    {
+        if (this->dbl != nullptr)
+            std::copy(values, values + n, this->dbl + first);
+        else
+            std::transform(values, values + n, this->flt + first, [](double v) {
+                return (float) v;
+            });
+    }
+};
+
+/// Evaluate metrics of a range of cells of a grid made of `ELEM` cells only
+///
+/// @return Bit mask of metrics (indices into `metrics`) that were evaluated
+template <typename ELEM, typename COORD>
+unsigned int
+evaluateKernels(vtkUnstructuredGrid * grid,
+                const COORD * xyz,
+                vtkIdType begin,
+                vtkIdType end,
+                const std::vector<int> & metrics,
+                std::vector<Output> & values,
+                vtkIdList * ids)
+{
+    Batch<ELEM::N_NODES> batch;
+    double out[BATCH];
+    unsigned int evaluated = 0;
+    for (vtkIdType first = begin; first < end; first += BATCH) {
+        int n = (int) std::min<vtkIdType>(BATCH, end - first);
+        // a partial batch is padded with its last cell
+        for (int l = 0; l < BATCH; l++) {
+            vtkIdType npts;
+            const vtkIdType * pts;
+            grid->GetCellPoints(first + std::min(l, n - 1), npts, pts, ids);
+            for (int i = 0; i < ELEM::N_NODES; i++) {
+                batch.x[i][l] = xyz[3 * pts[i]];
+                batch.y[i][l] = xyz[3 * pts[i] + 1];
+                batch.z[i][l] = xyz[3 * pts[i] + 2];
+            }
+        }
+        for (std::size_t m = 0; m < metrics.size(); m++) {
+            if (!values[m].isSet() || !ELEM::evaluate(metrics[m], batch, out))
+                continue;
+            values[m].set(first, out, n);
+            evaluated |= 1u << m;
+        }
+    }
+    return evaluated;
+}
+
+template <typename ELEM>
+unsigned int
+evaluateKernels(vtkUnstructuredGrid * grid,
+                vtkIdType begin,
+                vtkIdType end,
+                const std::vector<int> & metrics,
+                std::vector<Output> & values,
+                vtkIdList * ids)
+{
+    auto * coords = grid->GetPoints()->GetData();
+    if (auto * dbl = vtkDoubleArray::FastDownCast(coords))
+        return evaluateKernels<ELEM>(grid, dbl->GetPointer(0), begin, end, metrics, values, ids);
+    else if (auto * flt = vtkFloatArray::FastDownCast(coords))
+        return evaluateKernels<ELEM>(grid, flt->GetPointer(0), begin, end, metrics, values, ids);
+    else
+        return 0;
+}
+
+/// Compute quality of a cell (the same way `vtkCellQuality` does)
+double
+computeCellQuality(vtkCell * cell, int metric)
+{
+    switch (cell->GetCellType()) {
+    case VTK_TRIANGLE:
+        switch (metric) {
+        case MESH_METRIC_AREA:
+            return vtkMeshQuality::TriangleArea(cell);
+        case MESH_METRIC_ASPECT_RATIO:
+            return vtkMeshQuality::TriangleAspectRatio(cell);
+        case MESH_METRIC_CONDITION:
+            return vtkMeshQuality::TriangleCondition(cell);
+        }
+        break;
+    case VTK_QUAD:
+        switch (metric) {
+        case MESH_METRIC_JACOBIAN:
+            return vtkMeshQuality::QuadJacobian(cell);
+        case MESH_METRIC_AREA:
+            return vtkMeshQuality::QuadArea(cell);
+        case MESH_METRIC_ASPECT_RATIO:
+            return vtkMeshQuality::QuadAspectRatio(cell);
+        case MESH_METRIC_CONDITION:
+            return vtkMeshQuality::QuadCondition(cell);
+        }
+        break;
+    case VTK_TETRA:
+        switch (metric) {
+        case MESH_METRIC_JACOBIAN:
+            return vtkMeshQuality::TetJacobian(cell);
+        case MESH_METRIC_ASPECT_RATIO:
+            return vtkMeshQuality::TetAspectRatio(cell);
+        case MESH_METRIC_CONDITION:
+            return vtkMeshQuality::TetCondition(cell);
+        case MESH_METRIC_VOLUME:
+            return vtkMeshQuality::TetVolume(cell);
+        }
+        break;
+    case VTK_HEXAHEDRON:
+        switch (metric) {
+        case MESH_METRIC_JACOBIAN:
+            return vtkMeshQuality::HexJacobian(cell);
+        case MESH_METRIC_CONDITION:
+            return vtkMeshQuality::HexCondition(cell);
+        case MESH_METRIC_VOLUME:
+            return vtkMeshQuality::HexVolume(cell);
+        }
+        break;
+    }
+    return QualityEngine::UNSUPPORTED;
+}
+
+void
+setQualityMeasure(vtkCellQuality * cell_quality, int metric)
+{
+    switch (metric) {
+    default:
+    case MESH_METRIC_JACOBIAN:
+        cell_quality->SetQualityMeasureToJacobian();
+        break;
+    case MESH_METRIC_AREA:
+        cell_quality->SetQualityMeasureToArea();
+        break;
+    case MESH_METRIC_VOLUME:
+        cell_quality->SetQualityMeasureToVolume();
+        break;
+    case MESH_METRIC_ASPECT_RATIO:
+        cell_quality->SetQualityMeasureToAspectRatio();
+        break;
+    case MESH_METRIC_CONDITION:
+        cell_quality->SetQualityMeasureToCondition();
+        break;
+    }
+}
+
+} // namespace
+
+QualityEngine::QualityEngine() : single_precision(false) {}
+
+void
+QualityEngine::setSinglePrecision(bool single)
+{
+    this->single_precision = single;
+}
+
+bool
+QualityEngine::getSinglePrecision() const
+{
+    return this->single_precision;
+}
+
+void
+QualityEngine::compute(const std::vector<Block> & blocks, const std::vector<int> & metrics)
+{
+    // blocks with missing metrics, laid out one after another in a single range of cells
+    struct Work {
+        vtkUnstructuredGrid * grid;
+        /// Type of all cells, `VTK_EMPTY_CELL` if there are several types
+        int cell_type;
+        /// Output per metric, not set if the metric is cached
+        std::vector<Output> values;
+    };
+    std::vector<Work> work;
+    std::vector<vtkIdType> offsets = { 0 };
+    for (auto & block : blocks) {
+        std::vector<int> missing;
+        for (auto metric : metrics)
+            if (this->cache.find({ block.id, metric }) == this->cache.end())
+                missing.push_back(metric);
+        if (missing.empty())
+            continue;
+
+        int cell_type;
+        if (!isSupported(block.grid, cell_type)) {
+            computeSerial(block, missing);
+            continue;
+        }
+
+        auto n_cells = block.grid->GetNumberOfCells();
+        Work w = { block.grid, cell_type, std::vector<Output>(metrics.size()) };
+        for (std::size_t m = 0; m < metrics.size(); m++) {
+            if (std::find(missing.begin(), missing.end(), metrics[m]) == missing.end())
+                continue;
+            if (this->single_precision) {
+                auto quality = vtkSmartPointer<vtkFloatArray>::New();
+                quality->SetNumberOfTuples(n_cells);
+                w.values[m].flt = quality->GetPointer(0);
+                this->cache[{ block.id, metrics[m] }] = quality;
+            }
+            else {
+                auto quality = vtkSmartPointer<vtkDoubleArray>::New();
+                quality->SetNumberOfTuples(n_cells);
+                w.values[m].dbl = quality->GetPointer(0);
+                this->cache[{ block.id, metrics[m] }] = quality;
+            }
+        }
+        work.push_back(w);
+        offsets.push_back(offsets.back() + n_cells);
+    }
+
+    vtkSMPThreadLocalObject<vtkGenericCell> cells;
+    vtkSMPThreadLocalObject<vtkIdList> cell_pts;
+    vtkSMPTools::For(0, offsets.back(), [&](vtkIdType begin, vtkIdType end) {
+        auto * cell = cells.Local();
+        auto * ids = cell_pts.Local();
+        auto it = std::upper_bound(offsets.begin(), offsets.end(), begin);
+        std::size_t k = it - offsets.begin() - 1;
+        while (begin < end) {
+            while (begin >= offsets[k + 1])
+                k++;
+            // part of the range that falls into block `k`
+            auto & w = work[k];
+            auto first = begin - offsets[k];
+            auto last = std::min(end, offsets[k + 1]) - offsets[k];
+            begin = offsets[k] + last;
+
+            unsigned int evaluated = 0;
+            if (w.cell_type == VTK_TETRA)
+                evaluated = evaluateKernels<Tet4>(w.grid, first, last, metrics, w.values, ids);
+            else if (w.cell_type == VTK_HEXAHEDRON)
+                evaluated = evaluateKernels<Hex8>(w.grid, first, last, metrics, w.values, ids);
+
+            // metrics without a kernel
+            std::vector<std::size_t> rest;
+            for (std::size_t m = 0; m < metrics.size(); m++)
+                if (w.values[m].isSet() && !(evaluated & (1u << m)))
+                    rest.push_back(m);
+            if (rest.empty())
+                continue;
+            for (auto cell_id = first; cell_id < last; cell_id++) {
+                w.grid->GetCell(cell_id, cell);
+                for (auto m : rest)
+                    w.values[m].set(cell_id, computeCellQuality(cell, metrics[m]));
+            }
+        }
+    });
+}
+
+void
+QualityEngine::computeSerial(const Block & block, const std::vector<int> & metrics)
+{
+    for (auto metric : metrics) {
+        auto cell_quality = vtkSmartPointer<vtkCellQuality>::New();
+        setQualityMeasure(cell_quality, metric);
+        cell_quality->SetUnsupportedGeometry(UNSUPPORTED);
+        cell_quality->SetInputData(block.grid);
+        cell_quality->Update();
+        auto * out = cell_quality->GetOutput();
+        auto * quality = out->GetCellData()->GetArray("CellQuality");
+        if (quality == nullptr)
+            continue;
+        if (this->single_precision) {
+            auto flt = vtkSmartPointer<vtkFloatArray>::New();
+            flt->DeepCopy(quality);
+            this->cache[{ block.id, metric }] = flt;
+        }
+        else
+            this->cache[{ block.id, metric }] = quality;
+    }
+}
+
+vtkSmartPointer<vtkDataArray>
+QualityEngine::get(int block_id, int metric) const
+{
+    auto it = this->cache.find({ block_id, metric });
+    if (it != this->cache.end())
+        return it->second;
+    else
+        return nullptr;
+}
+
+void
+QualityEngine::clear()
+{
+    this->cache.clear();
+}
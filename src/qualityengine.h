@@ -0,0 +1,76 @@
+// SPDX-FileCopyrightText: 2024 David Andrs <andrsd@gmail.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <map>
+#include <utility>
+#include <vector>
+#include "vtkSmartPointer.h"
+#include "vtkDoubleArray.h"
+#include "vtkFloatArray.h"
+
+class vtkDataArray;
+class vtkUnstructuredGrid;
+
+/// Computes cell quality metrics of blocks and caches the results
+///
+/// All cells of all blocks are processed in one parallel loop, so that small blocks do not leave
+/// threads idle. Several metrics can be computed in a single pass over the cells. Cells of blocks
+/// made only of linear tetrahedra or hexahedra are evaluated in small batches laid out so that the
+/// compiler can vectorize the metric formulas. Blocks with cell types other than triangles, quads,
+/// tetrahedra and hexahedra are handled by `vtkCellQuality`.
+class QualityEngine {
+public:
+    /// Block to compute the quality of
+    struct Block {
+        int id;
+        vtkUnstructuredGrid * grid;
+    };
+
+    QualityEngine();
+
+    /// Compute metrics of blocks that are not cached yet
+    ///
+    /// @param blocks Blocks to compute the metrics for
+    /// @param metrics Metrics to compute (values of `MeshQualityMetric`)
+    void compute(const std::vector<Block> & blocks, const std::vector<int> & metrics);
+
+    /// Get cached quality of block cells
+    ///
+    /// @param block_id Id of the block
+    /// @param metric Metric (value of `MeshQualityMetric`)
+    /// @return Quality of cells (`vtkFloatArray` or `vtkDoubleArray`), `nullptr` if it was not
+    ///         computed
+    vtkSmartPointer<vtkDataArray> get(int block_id, int metric) const;
+
+    /// Store the quality of cells computed from now on in single precision (to save memory)
+    void setSinglePrecision(bool single);
+    bool getSinglePrecision() const;
+
+    /// Drop all cached results
+    void clear();
+
+    /// Value of the quality of cells the metric is not defined for
+    static const double UNSUPPORTED;
+
+protected:
+    /// Compute metrics of a block with `vtkCellQuality`
+    void computeSerial(const Block & block, const std::vector<int> & metrics);
+
+    /// Store computed quality in `vtkFloatArray` instead of `vtkDoubleArray`
+    bool single_precision;
+    /// Cached cell quality per block id and metric
+    std::map<std::pair<int, int>, vtkSmartPointer<vtkDataArray>> cache;
+};
+
+/// Call `fn` with a pointer to the values of a quality array returned by `QualityEngine::get`
+template <typename FN>
+void
+withQualityValues(vtkDataArray * quality, FN && fn)
+{
+    if (auto * dbl = vtkDoubleArray::FastDownCast(quality))
+        fn(static_cast<const double *>(dbl->GetPointer(0)));
+    else if (auto * flt = vtkFloatArray::FastDownCast(quality))
+        fn(static_cast<const float *>(flt->GetPointer(0)));
+}
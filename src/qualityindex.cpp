@@ -0,0 +1,62 @@
+// SPDX-FileCopyrightText: 2024 David Andrs <andrsd@gmail.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "qualityindex.h"
+#include "qualityengine.h"
+#include "vtkSMPTools.h"
+#include <algorithm>
+#include <cmath>
+
+QualityIndex::QualityIndex(vtkDataArray * quality) : quality(quality)
+{
+    vtkIdType n = quality->GetNumberOfTuples();
+    this->order.reserve(n);
+    withQualityValues(quality, [&](auto * values) {
+        for (vtkIdType i = 0; i < n; i++)
+            if (!std::isnan(values[i]) && values[i] != QualityEngine::UNSUPPORTED)
+                this->order.push_back(i);
+        auto by_quality = [values](vtkIdType a, vtkIdType b) {
+            return values[a] < values[b] || (values[a] == values[b] && a < b);
+        };
+        vtkSMPTools::Sort(this->order.begin(), this->order.end(), by_quality);
+    });
+}
+
+vtkIdType
+QualityIndex::getNumberOfCells() const
+{
+    return this->order.size();
+}
+
+std::pair<std::size_t, std::size_t>
+QualityIndex::find(double lo, double hi) const
+{
+    if (hi < lo)
+        return { 0, 0 };
+
+    std::pair<std::size_t, std::size_t> found = { 0, 0 };
+    withQualityValues(this->quality, [&](auto * values) {
+        auto below = [values](vtkIdType id, double v) { return values[id] < v; };
+        auto above = [values](double v, vtkIdType id) { return v < values[id]; };
+        auto first = std::lower_bound(this->order.begin(), this->order.end(), lo, below);
+        auto last = std::upper_bound(first, this->order.end(), hi, above);
+        found = { first - this->order.begin(), last - this->order.begin() };
+    });
+    return found;
+}
+
+vtkIdType
+QualityIndex::count(double lo, double hi) const
+{
+    auto [first, last] = find(lo, hi);
+    return last - first;
+}
+
+std::vector<vtkIdType>
+QualityIndex::query(double lo, double hi) const
+{
+    auto [first, last] = find(lo, hi);
+    std::vector<vtkIdType> ids(this->order.begin() + first, this->order.begin() + last);
+    vtkSMPTools::Sort(ids.begin(), ids.end());
+    return ids;
+}
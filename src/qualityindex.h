@@ -0,0 +1,43 @@
+// SPDX-FileCopyrightText: 2024 David Andrs <andrsd@gmail.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <utility>
+#include <vector>
+#include "vtkType.h"
+#include "vtkSmartPointer.h"
+
+class vtkDataArray;
+
+/// Cells of a block ordered by their quality
+///
+/// Cells with quality in a range form a contiguous run in the order, which is found by a binary
+/// search. The cost of a query depends only on the number of cells found, not on the size of the
+/// block.
+class QualityIndex {
+public:
+    /// @param quality Quality of cells (cells with undefined quality are left out)
+    explicit QualityIndex(vtkDataArray * quality);
+
+    /// Get number of indexed cells
+    vtkIdType getNumberOfCells() const;
+
+    /// Count cells with quality in a range
+    vtkIdType count(double lo, double hi) const;
+
+    /// Find cells with quality in a range
+    ///
+    /// @param lo Lower bound of the range (inclusive)
+    /// @param hi Upper bound of the range (inclusive)
+    /// @return Sorted ids of cells
+    std::vector<vtkIdType> query(double lo, double hi) const;
+
+protected:
+    /// Find the positions in `order` of the first cell and past the last cell in a range
+    std::pair<std::size_t, std::size_t> find(double lo, double hi) const;
+
+    vtkSmartPointer<vtkDataArray> quality;
+    /// Cell ids sorted by quality
+    std::vector<vtkIdType> order;
+};
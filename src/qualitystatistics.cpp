@@ -0,0 +1,339 @@
+// SPDX-FileCopyrightText: 2024 David Andrs <andrsd@gmail.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "qualitystatistics.h"
+#include "qualityengine.h"
+#include "vtkDataArray.h"
+#include "vtkSMPTools.h"
+#include "vtkSMPThreadLocal.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+/// Number of key bits resolved by one counting pass of the radix select
+const int DIGIT_BITS = 16;
+const std::size_t N_DIGITS = std::size_t(1) << DIGIT_BITS;
+/// Up to this many values, percentiles are found by sorting a copy of the values
+const vtkIdType MAX_SORTED = 1 << 16;
+
+bool
+isDefined(double value)
+{
+    return !std::isnan(value) && value != QualityEngine::UNSUPPORTED;
+}
+
+/// Map a value to an unsigned integer with the same ordering
+std::uint64_t
+toKey(double value)
+{
+    std::uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return (bits >> 63) ? ~bits : bits | (std::uint64_t(1) << 63);
+}
+
+double
+fromKey(std::uint64_t key)
+{
+    std::uint64_t bits = (key >> 63) ? key & ~(std::uint64_t(1) << 63) : ~key;
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+/// Find values at given positions in the sorted sequence of defined values of blocks
+///
+/// @param blocks Blocks with the values
+/// @param n Number of defined values in `blocks`
+/// @param ranks Positions to find the values at
+std::vector<double>
+selectRanks(const std::vector<QualityStatistics::Block> & blocks,
+            vtkIdType n,
+            const std::vector<vtkIdType> & ranks)
+{
+    std::vector<double> result(ranks.size());
+    if (n <= MAX_SORTED) {
+        std::vector<double> values;
+        values.reserve(n);
+        for (auto & blk : blocks) {
+            for (vtkIdType i = 0; i < blk.quality->GetNumberOfTuples(); i++)
+                if (isDefined(blk.quality->GetTuple1(i)))
+                    values.push_back(blk.quality->GetTuple1(i));
+        }
+        std::sort(values.begin(), values.end());
+        for (std::size_t t = 0; t < ranks.size(); t++)
+            result[t] = values[ranks[t]];
+        return result;
+    }
+
+    // Each pass counts the values by the next digit of their keys, considering only values whose
+    // higher digits match the ones already resolved for a target rank
+    auto n_targets = ranks.size();
+    std::vector<std::uint64_t> prefix(n_targets, 0);
+    std::vector<vtkIdType> rank(ranks);
+    for (int shift = 64 - DIGIT_BITS; shift >= 0; shift -= DIGIT_BITS) {
+        // targets sharing resolved digits share counts
+        std::vector<std::uint64_t> group_prefix(prefix);
+        std::sort(group_prefix.begin(), group_prefix.end());
+        group_prefix.erase(std::unique(group_prefix.begin(), group_prefix.end()),
+                           group_prefix.end());
+        auto n_groups = group_prefix.size();
+        // position of the resolved digits in the keys
+        int high_shift = shift + DIGIT_BITS;
+
+        vtkSMPThreadLocal<std::vector<vtkIdType>> counts;
+        for (auto & blk : blocks) {
+            auto n_values = blk.quality->GetNumberOfTuples();
+            withQualityValues(blk.quality, [&](auto * values) {
+                vtkSMPTools::For(0, n_values, [&](vtkIdType begin, vtkIdType end) {
+                    auto & cnt = counts.Local();
+                    if (cnt.empty())
+                        cnt.assign(n_groups * N_DIGITS, 0);
+                    for (vtkIdType i = begin; i < end; i++) {
+                        if (!isDefined(values[i]))
+                            continue;
+                        auto key = toKey(values[i]);
+                        std::uint64_t high = high_shift < 64 ? key >> high_shift : 0;
+                        auto digit = (key >> shift) & (N_DIGITS - 1);
+                        for (std::size_t g = 0; g < n_groups; g++)
+                            if (high == group_prefix[g])
+                                cnt[g * N_DIGITS + digit]++;
+                    }
+                });
+            });
+        }
+
+        std::vector<vtkIdType> total(n_groups * N_DIGITS, 0);
+        for (auto & cnt : counts)
+            for (std::size_t k = 0; k < cnt.size(); k++)
+                total[k] += cnt[k];
+
+        for (std::size_t t = 0; t < n_targets; t++) {
+            auto g = std::lower_bound(group_prefix.begin(), group_prefix.end(), prefix[t]) -
+                     group_prefix.begin();
+            std::size_t digit = 0;
+            while (rank[t] >= total[g * N_DIGITS + digit]) {
+                rank[t] -= total[g * N_DIGITS + digit];
+                digit++;
+            }
+            prefix[t] = (prefix[t] << DIGIT_BITS) | digit;
+        }
+    }
+    for (std::size_t t = 0; t < n_targets; t++)
+        result[t] = fromKey(prefix[t]);
+    return result;
+}
+
+/// Partial results of one thread
+struct Partial {
+    vtkIdType n_cells = 0;
+    double lo = std::numeric_limits<double>::max();
+    double hi = std::numeric_limits<double>::lowest();
+    double sum = 0.;
+    std::vector<QualityStatistics::Cell> worst;
+    /// Is `worst` holding enough cells, so that `bound` is valid
+    bool full = false;
+    /// The best of the worst cells
+    QualityStatistics::Cell bound;
+};
+
+} // namespace
+
+const std::vector<double> QualityStatistics::PERCENTILES = { 1., 5., 25., 50., 75., 95., 99. };
+
+QualityStatistics::QualityStatistics(int n_bins, std::size_t n_worst) :
+    n_bins(n_bins),
+    n_worst(n_worst),
+    histogram_range { 0., 0. }
+{
+}
+
+void
+QualityStatistics::compute(const std::vector<Block> & blocks, bool higher_is_worse)
+{
+    this->summary = Summary();
+    this->block_summaries.clear();
+
+    auto is_worse = [higher_is_worse](const Cell & a, const Cell & b) {
+        if (a.value != b.value)
+            return higher_is_worse ? a.value > b.value : a.value < b.value;
+        return a.block_id < b.block_id || (a.block_id == b.block_id && a.cell_id < b.cell_id);
+    };
+    // keep only the `n_worst` worst cells
+    auto truncate = [&](std::vector<Cell> & cells) {
+        if (this->n_worst > 0 && cells.size() > this->n_worst) {
+            std::nth_element(cells.begin(),
+                             cells.begin() + this->n_worst - 1,
+                             cells.end(),
+                             is_worse);
+            cells.resize(this->n_worst);
+        }
+    };
+
+    this->summary.range[0] = std::numeric_limits<double>::max();
+    this->summary.range[1] = std::numeric_limits<double>::lowest();
+    double sum = 0.;
+    for (auto & blk : blocks) {
+        vtkSMPThreadLocal<Partial> partials;
+        auto n_values = blk.quality->GetNumberOfTuples();
+        withQualityValues(blk.quality, [&](auto * values) {
+            vtkSMPTools::For(0, n_values, [&](vtkIdType begin, vtkIdType end) {
+                auto & p = partials.Local();
+                for (vtkIdType i = begin; i < end; i++) {
+                    double value = values[i];
+                    if (!isDefined(value))
+                        continue;
+                    p.n_cells++;
+                    p.lo = std::min(p.lo, value);
+                    p.hi = std::max(p.hi, value);
+                    p.sum += value;
+
+                    if (this->n_worst == 0)
+                        continue;
+                    Cell cell = { blk.id, i, value };
+                    if (p.full && !is_worse(cell, p.bound))
+                        continue;
+                    p.worst.push_back(cell);
+                    if (p.worst.size() >= 2 * this->n_worst) {
+                        truncate(p.worst);
+                        p.bound = p.worst[this->n_worst - 1];
+                        p.full = true;
+                    }
+                }
+            });
+        });
+
+        auto & s = this->block_summaries[blk.id];
+        s.range[0] = std::numeric_limits<double>::max();
+        s.range[1] = std::numeric_limits<double>::lowest();
+        double block_sum = 0.;
+        for (auto & p : partials) {
+            s.n_cells += p.n_cells;
+            s.range[0] = std::min(s.range[0], p.lo);
+            s.range[1] = std::max(s.range[1], p.hi);
+            block_sum += p.sum;
+            s.worst.insert(s.worst.end(), p.worst.begin(), p.worst.end());
+        }
+        truncate(s.worst);
+        std::sort(s.worst.begin(), s.worst.end(), is_worse);
+        if (s.n_cells > 0) {
+            s.mean = block_sum / s.n_cells;
+            this->summary.n_cells += s.n_cells;
+            this->summary.range[0] = std::min(this->summary.range[0], s.range[0]);
+            this->summary.range[1] = std::max(this->summary.range[1], s.range[1]);
+            sum += block_sum;
+        }
+        else
+            s.range[0] = s.range[1] = 0.;
+        this->summary.worst.insert(this->summary.worst.end(), s.worst.begin(), s.worst.end());
+    }
+    truncate(this->summary.worst);
+    std::sort(this->summary.worst.begin(), this->summary.worst.end(), is_worse);
+    if (this->summary.n_cells > 0)
+        this->summary.mean = sum / this->summary.n_cells;
+    else
+        this->summary.range[0] = this->summary.range[1] = 0.;
+
+    // histograms share the range, so that the blocks can be compared
+    this->histogram_range[0] = this->summary.range[0];
+    this->histogram_range[1] = this->summary.range[1];
+    auto lo = this->histogram_range[0];
+    auto width = this->histogram_range[1] - this->histogram_range[0];
+    this->summary.histogram.assign(this->n_bins, 0);
+    for (auto & blk : blocks) {
+        vtkSMPThreadLocal<std::vector<vtkIdType>> counts;
+        auto n_values = blk.quality->GetNumberOfTuples();
+        withQualityValues(blk.quality, [&](auto * values) {
+            vtkSMPTools::For(0, n_values, [&](vtkIdType begin, vtkIdType end) {
+                auto & cnt = counts.Local();
+                if (cnt.empty())
+                    cnt.assign(this->n_bins, 0);
+                for (vtkIdType i = begin; i < end; i++) {
+                    if (!isDefined(values[i]))
+                        continue;
+                    auto t = width > 0. ? (values[i] - lo) / width * this->n_bins : 0.;
+                    auto bin = t < this->n_bins ? (int) t : this->n_bins - 1;
+                    cnt[bin]++;
+                }
+            });
+        });
+
+        auto & s = this->block_summaries[blk.id];
+        s.histogram.assign(this->n_bins, 0);
+        for (auto & cnt : counts) {
+            for (int k = 0; k < (int) cnt.size(); k++) {
+                s.histogram[k] += cnt[k];
+                this->summary.histogram[k] += cnt[k];
+            }
+        }
+
+        computePercentiles({ blk }, s);
+    }
+    computePercentiles(blocks, this->summary);
+}
+
+void
+QualityStatistics::computePercentiles(const std::vector<Block> & blocks, Summary & summary) const
+{
+    summary.percentiles.clear();
+    auto n = summary.n_cells;
+    if (n == 0)
+        return;
+
+    // percentiles are interpolated between the values at the neighboring ranks
+    std::vector<vtkIdType> ranks;
+    for (auto p : PERCENTILES) {
+        auto pos = p / 100. * (n - 1);
+        ranks.push_back((vtkIdType) std::floor(pos));
+        ranks.push_back((vtkIdType) std::ceil(pos));
+    }
+    std::sort(ranks.begin(), ranks.end());
+    ranks.erase(std::unique(ranks.begin(), ranks.end()), ranks.end());
+
+    auto values = selectRanks(blocks, n, ranks);
+    auto value_at = [&](vtkIdType rank) {
+        return values[std::lower_bound(ranks.begin(), ranks.end(), rank) - ranks.begin()];
+    };
+    for (auto p : PERCENTILES) {
+        auto pos = p / 100. * (n - 1);
+        auto lo = std::floor(pos);
+        auto v_lo = value_at((vtkIdType) lo);
+        auto v_hi = value_at((vtkIdType) std::ceil(pos));
+        summary.percentiles.push_back(v_lo + (pos - lo) * (v_hi - v_lo));
+    }
+}
+
+const QualityStatistics::Summary &
+QualityStatistics::getSummary() const
+{
+    return this->summary;
+}
+
+std::vector<int>
+QualityStatistics::getBlockIds() const
+{
+    std::vector<int> ids;
+    for (auto & [id, s] : this->block_summaries)
+        ids.push_back(id);
+    return ids;
+}
+
+const QualityStatistics::Summary *
+QualityStatistics::getBlockSummary(int block_id) const
+{
+    auto it = this->block_summaries.find(block_id);
+    if (it != this->block_summaries.end())
+        return &it->second;
+    else
+        return nullptr;
+}
+
+void
+QualityStatistics::getHistogramRange(double range[]) const
+{
+    range[0] = this->histogram_range[0];
+    range[1] = this->histogram_range[1];
+}
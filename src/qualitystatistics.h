@@ -0,0 +1,82 @@
+// SPDX-FileCopyrightText: 2024 David Andrs <andrsd@gmail.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <map>
+#include <vector>
+#include "vtkType.h"
+
+class vtkDataArray;
+
+/// Statistics of cell quality per block and over all blocks
+///
+/// Minimum, maximum, mean and histograms are computed with parallel reductions. Percentiles are
+/// exact, they are found by a radix select over the bits of the values, so that the values never
+/// have to be copied or sorted. The worst cells are found by partial sorts of the chunks of cells
+/// processed by each thread. Cells with `QualityEngine::UNSUPPORTED` quality are not counted.
+class QualityStatistics {
+public:
+    /// Quality of the cells of a block
+    struct Block {
+        int id;
+        vtkDataArray * quality;
+    };
+
+    /// Cell and its quality
+    struct Cell {
+        int block_id;
+        vtkIdType cell_id;
+        double value;
+    };
+
+    struct Summary {
+        /// Number of cells the metric is defined for
+        vtkIdType n_cells = 0;
+        double range[2] = { 0., 0. };
+        double mean = 0.;
+        /// Number of cells in each bin of the histogram (see `getHistogramRange`)
+        std::vector<vtkIdType> histogram;
+        /// Values at `PERCENTILES`, empty if there are no cells
+        std::vector<double> percentiles;
+        /// Worst cells, the worst first
+        std::vector<Cell> worst;
+    };
+
+    /// @param n_bins Number of histogram bins
+    /// @param n_worst Number of worst cells to find
+    QualityStatistics(int n_bins, std::size_t n_worst);
+
+    /// Compute the statistics
+    ///
+    /// @param blocks Quality of cells of each block
+    /// @param higher_is_worse `true` if higher values mean worse cells (e.g. aspect ratio)
+    void compute(const std::vector<Block> & blocks, bool higher_is_worse);
+
+    /// Get statistics of all blocks
+    const Summary & getSummary() const;
+
+    /// Get ids of blocks with statistics
+    std::vector<int> getBlockIds() const;
+
+    /// Get statistics of a block
+    ///
+    /// @return Statistics of the block, `nullptr` if the block is not known
+    const Summary * getBlockSummary(int block_id) const;
+
+    /// Get range of histograms (the same for all blocks, so that they can be compared)
+    void getHistogramRange(double range[]) const;
+
+    /// Percentiles reported in `Summary::percentiles`
+    static const std::vector<double> PERCENTILES;
+
+protected:
+    /// Compute percentiles of the quality of cells in `blocks`
+    void computePercentiles(const std::vector<Block> & blocks, Summary & summary) const;
+
+    int n_bins;
+    std::size_t n_worst;
+    Summary summary;
+    std::map<int, Summary> block_summaries;
+    double histogram_range[2];
+};
@@ -0,0 +1,251 @@
+// SPDX-FileCopyrightText: 2024 David Andrs <andrsd@gmail.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "qualitystatisticswidget.h"
+#include "qualitystatistics.h"
+#include <QVBoxLayout>
+#include <QComboBox>
+#include <QTreeWidget>
+#include <QTreeWidgetItem>
+#include <QHeaderView>
+#include <QHelpEvent>
+#include <QPainter>
+#include <QToolTip>
+#include <QLocale>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+QString
+formatValue(double value)
+{
+    return QString::number(value, 'g', 6);
+}
+
+} // namespace
+
+/// Bar chart of a histogram
+class HistogramWidget : public QWidget {
+public:
+    explicit HistogramWidget(QWidget * parent = nullptr);
+
+    /// @param counts Number of values in each bin
+    /// @param range Range of values covered by the bins
+    void setHistogram(const std::vector<vtkIdType> & counts, const double range[]);
+
+protected:
+    bool event(QEvent * event) override;
+    void paintEvent(QPaintEvent * event) override;
+    /// Area with the bars
+    QRect getChartRect() const;
+
+    std::vector<vtkIdType> counts;
+    double range[2];
+};
+
+HistogramWidget::HistogramWidget(QWidget * parent) : QWidget(parent), range { 0., 0. }
+{
+    setMinimumHeight(100);
+}
+
+void
+HistogramWidget::setHistogram(const std::vector<vtkIdType> & counts, const double range[])
+{
+    this->counts = counts;
+    this->range[0] = range[0];
+    this->range[1] = range[1];
+    update();
+}
+
+QRect
+HistogramWidget::getChartRect() const
+{
+    return rect().adjusted(1, 1, -1, -fontMetrics().height() - 3);
+}
+
+bool
+HistogramWidget::event(QEvent * event)
+{
+    if (event->type() == QEvent::ToolTip) {
+        auto * help_event = static_cast<QHelpEvent *>(event);
+        auto chart = getChartRect();
+        auto n = (int) this->counts.size();
+        if (n > 0 && chart.width() > 0 && chart.contains(help_event->pos())) {
+            int bin = std::min(n - 1, (help_event->pos().x() - chart.left()) * n / chart.width());
+            auto width = (this->range[1] - this->range[0]) / n;
+            auto text = QString("%1 - %2: %3")
+                            .arg(formatValue(this->range[0] + bin * width))
+                            .arg(formatValue(this->range[0] + (bin + 1) * width))
+                            .arg(QLocale::system().toString((qlonglong) this->counts[bin]));
+            QToolTip::showText(help_event->globalPos(), text, this);
+        }
+        else
+            QToolTip::hideText();
+        return true;
+    }
+    return QWidget::event(event);
+}
+
+void
+HistogramWidget::paintEvent(QPaintEvent * event)
+{
+    QPainter painter(this);
+    auto chart = getChartRect();
+    painter.setPen(palette().color(QPalette::Mid));
+    painter.drawLine(chart.bottomLeft(), chart.bottomRight());
+    if (this->counts.empty())
+        return;
+
+    auto n = (int) this->counts.size();
+    auto max_count = *std::max_element(this->counts.begin(), this->counts.end());
+    painter.setPen(Qt::NoPen);
+    painter.setBrush(palette().color(QPalette::Highlight));
+    for (int i = 0; i < n; i++) {
+        if (this->counts[i] == 0)
+            continue;
+        int x0 = chart.left() + i * chart.width() / n;
+        int x1 = chart.left() + (i + 1) * chart.width() / n;
+        // bins with only a few cells must not disappear
+        auto ratio = (double) this->counts[i] / max_count;
+        int h = std::max(1, (int) std::lround(ratio * chart.height()));
+        painter.drawRect(x0, chart.bottom() - h, std::max(1, x1 - x0 - 1), h);
+    }
+
+    painter.setPen(palette().color(QPalette::WindowText));
+    QRect labels(chart.left(), chart.bottom() + 3, chart.width(), fontMetrics().height());
+    painter.drawText(labels, Qt::AlignLeft, formatValue(this->range[0]));
+    painter.drawText(labels, Qt::AlignRight, formatValue(this->range[1]));
+}
+
+QualityStatisticsWidget::QualityStatisticsWidget(QWidget * parent) :
+    QWidget(parent),
+    statistics(nullptr)
+{
+    setWindowTitle("Mesh quality statistics");
+    setWindowFlags(Qt::Tool | Qt::WindowStaysOnTopHint | Qt::CustomizeWindowHint |
+                   Qt::WindowTitleHint | Qt::WindowCloseButtonHint);
+    setFixedWidth(300);
+
+    this->layout = new QVBoxLayout();
+    this->layout->setContentsMargins(15, 8, 15, 8);
+
+    this->block = new QComboBox();
+    this->block->setEditable(false);
+    this->layout->addWidget(this->block);
+
+    this->histogram = new HistogramWidget();
+    this->layout->addWidget(this->histogram);
+
+    this->summary = new QTreeWidget();
+    this->summary->setFixedHeight(200);
+    this->summary->setIndentation(0);
+    this->summary->setHeaderLabels(QStringList({ "Statistic", "Value" }));
+    this->summary->setColumnWidth(0, 110);
+    this->layout->addWidget(this->summary);
+
+    this->worst_cells = new QTreeWidget();
+    this->worst_cells->setMinimumHeight(150);
+    this->worst_cells->setIndentation(0);
+    this->worst_cells->setHeaderLabels(QStringList({ "Block", "Cell", "Quality" }));
+    this->worst_cells->setColumnWidth(0, 60);
+    this->worst_cells->setColumnWidth(1, 90);
+    this->worst_cells->setSortingEnabled(true);
+    this->layout->addWidget(this->worst_cells);
+
+    this->setLayout(this->layout);
+
+    connect(this->block,
+            &QComboBox::currentIndexChanged,
+            this,
+            &QualityStatisticsWidget::onBlockChanged);
+    connect(this->worst_cells,
+            &QTreeWidget::itemClicked,
+            this,
+            &QualityStatisticsWidget::onCellClicked);
+}
+
+void
+QualityStatisticsWidget::setStatistics(const QualityStatistics * statistics)
+{
+    this->statistics = statistics;
+
+    // keep the selected block, so that metrics can be compared
+    auto current = this->block->currentData();
+    this->block->blockSignals(true);
+    this->block->clear();
+    if (this->statistics != nullptr) {
+        this->block->addItem("All blocks");
+        for (auto id : this->statistics->getBlockIds())
+            this->block->addItem(QString("Block %1").arg(id), id);
+        auto index = current.isValid() ? this->block->findData(current) : 0;
+        this->block->setCurrentIndex(std::max(index, 0));
+    }
+    this->block->blockSignals(false);
+
+    updateSummary();
+}
+
+void
+QualityStatisticsWidget::onBlockChanged(int index)
+{
+    updateSummary();
+}
+
+void
+QualityStatisticsWidget::onCellClicked(QTreeWidgetItem * item, int column)
+{
+    emit cellActivated(item->data(0, Qt::DisplayRole).toInt(),
+                       item->data(1, Qt::DisplayRole).toLongLong());
+}
+
+void
+QualityStatisticsWidget::updateSummary()
+{
+    this->summary->clear();
+    this->worst_cells->clear();
+
+    const QualityStatistics::Summary * s = nullptr;
+    if (this->statistics != nullptr) {
+        auto block_id = this->block->currentData();
+        if (block_id.isValid())
+            s = this->statistics->getBlockSummary(block_id.toInt());
+        else
+            s = &this->statistics->getSummary();
+    }
+    if (s == nullptr) {
+        double range[2] = { 0., 0. };
+        this->histogram->setHistogram({}, range);
+        return;
+    }
+
+    double range[2];
+    this->statistics->getHistogramRange(range);
+    this->histogram->setHistogram(s->histogram, range);
+
+    auto add_row = [this](const QString & name, const QString & value) {
+        this->summary->addTopLevelItem(new QTreeWidgetItem(QStringList({ name, value })));
+    };
+    add_row("Cells", QLocale::system().toString((qlonglong) s->n_cells));
+    if (s->n_cells > 0) {
+        add_row("Minimum", formatValue(s->range[0]));
+        add_row("Maximum", formatValue(s->range[1]));
+        add_row("Mean", formatValue(s->mean));
+        for (std::size_t i = 0; i < s->percentiles.size(); i++) {
+            auto name = QString("Percentile %1").arg(QualityStatistics::PERCENTILES[i]);
+            add_row(name, formatValue(s->percentiles[i]));
+        }
+    }
+
+    // the worst cell first, until the list is sorted by a column
+    this->worst_cells->setSortingEnabled(false);
+    for (auto & cell : s->worst) {
+        auto * item = new QTreeWidgetItem();
+        item->setData(0, Qt::DisplayRole, cell.block_id);
+        item->setData(1, Qt::DisplayRole, (qlonglong) cell.cell_id);
+        item->setData(2, Qt::DisplayRole, cell.value);
+        this->worst_cells->addTopLevelItem(item);
+    }
+    this->worst_cells->header()->setSortIndicator(-1, Qt::AscendingOrder);
+    this->worst_cells->setSortingEnabled(true);
+}
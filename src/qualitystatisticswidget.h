@@ -0,0 +1,46 @@
+// SPDX-FileCopyrightText: 2024 David Andrs <andrsd@gmail.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <QWidget>
+
+class QVBoxLayout;
+class QComboBox;
+class QTreeWidget;
+class QTreeWidgetItem;
+class HistogramWidget;
+class QualityStatistics;
+
+/// Panel with the histogram, percentiles and the worst cells of the cell quality
+class QualityStatisticsWidget : public QWidget {
+    Q_OBJECT
+
+public:
+    explicit QualityStatisticsWidget(QWidget * parent = nullptr);
+
+    /// Show statistics
+    ///
+    /// @param statistics Statistics to show (must stay alive while they are shown), `nullptr` to
+    ///        show nothing
+    void setStatistics(const QualityStatistics * statistics);
+
+signals:
+    /// Cell from the list of the worst cells was clicked
+    void cellActivated(int block_id, qint64 cell_id);
+
+protected slots:
+    void onBlockChanged(int index);
+    void onCellClicked(QTreeWidgetItem * item, int column);
+
+protected:
+    /// Show statistics of the block selected in `block`
+    void updateSummary();
+
+    const QualityStatistics * statistics;
+    QVBoxLayout * layout;
+    QComboBox * block;
+    HistogramWidget * histogram;
+    QTreeWidget * summary;
+    QTreeWidget * worst_cells;
+};
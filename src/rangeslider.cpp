@@ -0,0 +1,171 @@
+// SPDX-FileCopyrightText: 2024 David Andrs <andrsd@gmail.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "rangeslider.h"
+#include <QMouseEvent>
+#include <QPainter>
+#include <QSlider>
+#include <QStyle>
+#include <QStyleOptionSlider>
+#include <algorithm>
+#include <cstdlib>
+
+RangeSlider::RangeSlider(QWidget * parent) :
+    QWidget(parent),
+    minimum(0),
+    maximum(100),
+    lower_value(0),
+    upper_value(100),
+    dragged(HANDLE_NONE)
+{
+    setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Fixed);
+}
+
+void
+RangeSlider::setRange(int minimum, int maximum)
+{
+    this->minimum = minimum;
+    this->maximum = std::max(minimum, maximum);
+    setValues(this->lower_value, this->upper_value);
+}
+
+void
+RangeSlider::setValues(int lower, int upper)
+{
+    this->lower_value = std::clamp(lower, this->minimum, this->maximum);
+    this->upper_value = std::clamp(upper, this->lower_value, this->maximum);
+    update();
+}
+
+int
+RangeSlider::lower() const
+{
+    return this->lower_value;
+}
+
+int
+RangeSlider::upper() const
+{
+    return this->upper_value;
+}
+
+QSize
+RangeSlider::sizeHint() const
+{
+    QSlider slider(Qt::Horizontal);
+    return slider.sizeHint();
+}
+
+QSize
+RangeSlider::minimumSizeHint() const
+{
+    QSlider slider(Qt::Horizontal);
+    return slider.minimumSizeHint();
+}
+
+void
+RangeSlider::initStyleOption(QStyleOptionSlider & option, int value) const
+{
+    option.initFrom(this);
+    option.orientation = Qt::Horizontal;
+    option.minimum = this->minimum;
+    option.maximum = this->maximum;
+    option.sliderPosition = value;
+    option.sliderValue = value;
+    option.subControls = QStyle::SC_SliderHandle;
+}
+
+QRect
+RangeSlider::getSubControlRect(int value, QStyle::SubControl control) const
+{
+    QStyleOptionSlider option;
+    initStyleOption(option, value);
+    return style()->subControlRect(QStyle::CC_Slider, &option, control, this);
+}
+
+void
+RangeSlider::paintEvent(QPaintEvent * event)
+{
+    QPainter painter(this);
+    QStyleOptionSlider option;
+
+    initStyleOption(option, this->lower_value);
+    option.subControls = QStyle::SC_SliderGroove;
+    style()->drawComplexControl(QStyle::CC_Slider, &option, &painter, this);
+
+    // highlight the selected part of the groove
+    auto groove = getSubControlRect(this->lower_value, QStyle::SC_SliderGroove);
+    auto lo = getSubControlRect(this->lower_value, QStyle::SC_SliderHandle);
+    auto hi = getSubControlRect(this->upper_value, QStyle::SC_SliderHandle);
+    QRect span(QPoint(lo.center().x(), groove.center().y() - 1),
+               QPoint(hi.center().x(), groove.center().y() + 1));
+    painter.fillRect(span, palette().color(QPalette::Highlight));
+
+    for (auto value : { this->lower_value, this->upper_value }) {
+        initStyleOption(option, value);
+        style()->drawComplexControl(QStyle::CC_Slider, &option, &painter, this);
+    }
+}
+
+int
+RangeSlider::valueAt(int x) const
+{
+    auto groove = getSubControlRect(this->lower_value, QStyle::SC_SliderGroove);
+    auto handle = getSubControlRect(this->lower_value, QStyle::SC_SliderHandle);
+    auto span = groove.width() - handle.width();
+    return QStyle::sliderValueFromPosition(this->minimum,
+                                           this->maximum,
+                                           x - groove.left() - handle.width() / 2,
+                                           std::max(span, 1));
+}
+
+void
+RangeSlider::moveHandle(int x)
+{
+    auto value = valueAt(x);
+    if (this->dragged == HANDLE_LOWER)
+        value = std::min(value, this->upper_value);
+    else
+        value = std::max(value, this->lower_value);
+    auto & handle_value = this->dragged == HANDLE_LOWER ? this->lower_value : this->upper_value;
+    if (value != handle_value) {
+        handle_value = value;
+        update();
+        emit valuesChanged(this->lower_value, this->upper_value);
+    }
+}
+
+void
+RangeSlider::mousePressEvent(QMouseEvent * event)
+{
+    if (event->button() != Qt::LeftButton || this->maximum == this->minimum) {
+        QWidget::mousePressEvent(event);
+        return;
+    }
+
+    // the nearer handle is dragged, when they overlap the one that can move towards the click
+    auto value = valueAt(event->position().toPoint().x());
+    auto d_lower = std::abs(value - this->lower_value);
+    auto d_upper = std::abs(value - this->upper_value);
+    if (d_lower < d_upper || (d_lower == d_upper && value < this->lower_value))
+        this->dragged = HANDLE_LOWER;
+    else
+        this->dragged = HANDLE_UPPER;
+    moveHandle(event->position().toPoint().x());
+}
+
+void
+RangeSlider::mouseMoveEvent(QMouseEvent * event)
+{
+    if (this->dragged != HANDLE_NONE)
+        moveHandle(event->position().toPoint().x());
+    else
+        QWidget::mouseMoveEvent(event);
+}
+
+void
+RangeSlider::mouseReleaseEvent(QMouseEvent * event)
+{
+    this->dragged = HANDLE_NONE;
+    QWidget::mouseReleaseEvent(event);
+}
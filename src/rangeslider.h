@@ -0,0 +1,50 @@
+// SPDX-FileCopyrightText: 2024 David Andrs <andrsd@gmail.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <QWidget>
+#include <QStyle>
+
+class QStyleOptionSlider;
+
+/// Horizontal slider with two handles selecting a range
+class RangeSlider : public QWidget {
+    Q_OBJECT
+
+public:
+    explicit RangeSlider(QWidget * parent = nullptr);
+
+    void setRange(int minimum, int maximum);
+    /// Set positions of the handles (does not emit `valuesChanged`)
+    void setValues(int lower, int upper);
+    int lower() const;
+    int upper() const;
+
+    QSize sizeHint() const override;
+    QSize minimumSizeHint() const override;
+
+signals:
+    void valuesChanged(int lower, int upper);
+
+protected:
+    enum EHandle { HANDLE_NONE, HANDLE_LOWER, HANDLE_UPPER };
+
+    void paintEvent(QPaintEvent * event) override;
+    void mousePressEvent(QMouseEvent * event) override;
+    void mouseMoveEvent(QMouseEvent * event) override;
+    void mouseReleaseEvent(QMouseEvent * event) override;
+    void initStyleOption(QStyleOptionSlider & option, int value) const;
+    /// Get area of a part of the slider with a handle at `value`
+    QRect getSubControlRect(int value, QStyle::SubControl control) const;
+    /// Get slider value at a horizontal widget position
+    int valueAt(int x) const;
+    /// Move the dragged handle to a horizontal widget position
+    void moveHandle(int x);
+
+    int minimum;
+    int maximum;
+    int lower_value;
+    int upper_value;
+    EHandle dragged;
+};
@@ -2,6 +2,12 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 
 #include "reader.h"
+#include "vtkAlgorithm.h"
+#include "vtkCallbackCommand.h"
+#include "vtkCommand.h"
+#include "vtkSmartPointer.h"
+#include <algorithm>
+#include <filesystem>
 
 Reader::Reader(const std::string & file_name) : file_name(file_name) {}
 
@@ -10,3 +16,73 @@ Reader::getFileName() const
 {
     return this->file_name;
 }
+
+bool
+Reader::isObjectLoaded(const BlockInformation & info)
+{
+    return true;
+}
+
+vtkAlgorithmOutput *
+Reader::loadObject(const BlockInformation & info)
+{
+    return nullptr;
+}
+
+void
+Reader::setProgressCallback(ProgressCallback callback)
+{
+    this->progress_callback = callback;
+}
+
+void
+Reader::setBlockLoadedCallback(BlockLoadedCallback callback)
+{
+    this->block_loaded_callback = callback;
+}
+
+void
+Reader::observeProgress(vtkAlgorithm * algorithm)
+{
+    auto cmd = vtkSmartPointer<vtkCallbackCommand>::New();
+    cmd->SetClientData(this);
+    cmd->SetCallback([](vtkObject *, unsigned long, void * client_data, void * call_data) {
+        auto * reader = static_cast<Reader *>(client_data);
+        reader->reportProgress(*static_cast<double *>(call_data));
+    });
+    algorithm->AddObserver(vtkCommand::ProgressEvent, cmd);
+}
+
+void
+Reader::reportProgress(double fraction)
+{
+    if (!this->progress_callback)
+        return;
+
+    std::lock_guard<std::mutex> lock(this->progress_mutex);
+    if (this->progress.file_size == 0) {
+        std::error_code ec;
+        this->progress.file_size = std::filesystem::file_size(this->file_name, ec);
+        if (ec)
+            return;
+    }
+    // VTK resets progress to zero before executing an algorithm, do not go backwards
+    auto bytes_read = static_cast<std::uint64_t>(fraction * this->progress.file_size);
+    if (bytes_read > this->progress.bytes_read) {
+        this->progress.bytes_read = std::min(bytes_read, this->progress.file_size);
+        this->progress_callback(this->progress);
+    }
+}
+
+void
+Reader::reportBlockLoaded(const BlockInformation & info, vtkDataObject * data, int total_blocks)
+{
+    // blocks are handed out without holding the lock, so that their processing can overlap
+    if (this->block_loaded_callback)
+        this->block_loaded_callback(info, data);
+    std::lock_guard<std::mutex> lock(this->progress_mutex);
+    this->progress.blocks_done++;
+    this->progress.total_blocks = total_blocks;
+    if (this->progress_callback)
+        this->progress_callback(this->progress);
+}
@@ -3,11 +3,16 @@
 
 #pragma once
 
+#include <cstdint>
+#include <functional>
+#include <mutex>
 #include <string>
 #include <vector>
 #include "vtkAlgorithmOutput.h"
 
 class vtkPolyData;
+class vtkAlgorithm;
+class vtkDataObject;
 
 /// Base class for file readers
 ///
@@ -28,6 +33,28 @@ public:
         int num_components;
     };
 
+    /// Progress of loading a file
+    struct LoadProgress {
+        /// Number of bytes read from the file
+        std::uint64_t bytes_read = 0;
+        /// Size of the file in bytes
+        std::uint64_t file_size = 0;
+        /// Number of blocks loaded so far
+        int blocks_done = 0;
+        /// Total number of blocks (0 if the reader does not report blocks as they are loaded)
+        int total_blocks = 0;
+    };
+
+    /// Callback reporting loading progress
+    using ProgressCallback = std::function<void(const LoadProgress & progress)>;
+
+    /// Callback reporting a block that finished loading
+    ///
+    /// @param info Block information (the same as returned by `getBlocks` after loading)
+    /// @param data Block data, it will not be modified by the reader anymore
+    using BlockLoadedCallback = std::function<void(const BlockInformation & info,
+                                                   vtkDataObject * data)>;
+
 public:
     explicit Reader(const std::string & file_name);
     virtual ~Reader() = default;
@@ -50,6 +77,50 @@ public:
 
     virtual int getDimensionality() const = 0;
 
+    /// Query if an object (block, side set, node set) was loaded by `load`
+    ///
+    /// @param info Object information
+    /// @return `true` if the object is in the output of `getVtkOutputPort`, `false` if it has to be
+    ///         loaded by `loadObject`
+    virtual bool isObjectLoaded(const BlockInformation & info);
+
+    /// Load an object that was not loaded by `load`
+    ///
+    /// @param info Object information
+    /// @return Output port with the object data, `nullptr` if the object cannot be loaded
+    virtual vtkAlgorithmOutput * loadObject(const BlockInformation & info);
+
+    /// Set the callback reporting loading progress
+    ///
+    /// The callback is invoked from the thread calling `load`
+    void setProgressCallback(ProgressCallback callback);
+
+    /// Set the callback reporting blocks as they finish loading
+    ///
+    /// Readers that cannot hand out blocks before `load` returns never invoke it. The callback can
+    /// be invoked concurrently from worker threads.
+    void setBlockLoadedCallback(BlockLoadedCallback callback);
+
 protected:
+    /// Report progress of a VTK algorithm reading the file as loading progress
+    void observeProgress(vtkAlgorithm * algorithm);
+    /// Report loading progress
+    ///
+    /// @param fraction Fraction of the file that was read
+    void reportProgress(double fraction);
+    /// Report a block that finished loading
+    ///
+    /// @param info Block information
+    /// @param data Block data
+    /// @param total_blocks Total number of blocks that will be reported
+    void reportBlockLoaded(const BlockInformation & info, vtkDataObject * data, int total_blocks);
+
     std::string file_name;
+    ProgressCallback progress_callback;
+    BlockLoadedCallback block_loaded_callback;
+
+private:
+    /// Guards `progress` and serializes the progress callback
+    std::mutex progress_mutex;
+    LoadProgress progress;
 };
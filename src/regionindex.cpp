@@ -0,0 +1,268 @@
+// SPDX-FileCopyrightText: 2024 David Andrs <andrsd@gmail.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "regionindex.h"
+#include "vtkDataSet.h"
+#include "vtkUnstructuredGrid.h"
+#include "vtkIdList.h"
+#include "vtkMatrix4x4.h"
+#include "vtkSMPTools.h"
+#include "vtkSMPThreadLocal.h"
+#include "vtkSMPThreadLocalObject.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+/// Average number of points in a bucket
+const vtkIdType POINTS_PER_BUCKET = 128;
+
+enum Classification { OUTSIDE, INSIDE, PARTIAL };
+
+/// Point projected by a homogeneous transformation
+struct Projected {
+    double x, y, z, w;
+};
+
+Projected
+project(const double m[16], double x, double y, double z)
+{
+    return { m[0] * x + m[1] * y + m[2] * z + m[3],
+             m[4] * x + m[5] * y + m[6] * z + m[7],
+             m[8] * x + m[9] * y + m[10] * z + m[11],
+             m[12] * x + m[13] * y + m[14] * z + m[15] };
+}
+
+/// Crossing number test of a point against a polygon
+bool
+isInsidePolygon(const std::vector<std::array<double, 2>> & polygon, double x, double y)
+{
+    bool inside = false;
+    auto n = polygon.size();
+    for (std::size_t i = 0, j = n - 1; i < n; j = i++) {
+        auto & a = polygon[i];
+        auto & b = polygon[j];
+        if (((a[1] > y) != (b[1] > y)) && (x < (b[0] - a[0]) * (y - a[1]) / (b[1] - a[1]) + a[0]))
+            inside = !inside;
+    }
+    return inside;
+}
+
+} // namespace
+
+std::shared_ptr<RegionIndex>
+RegionIndex::fromPoints(vtkDataSet * data_set)
+{
+    vtkIdType n = data_set->GetNumberOfPoints();
+    std::vector<float> coords(3 * n);
+    vtkSMPTools::For(0, n, [&](vtkIdType begin, vtkIdType end) {
+        for (vtkIdType i = begin; i < end; i++) {
+            double x[3];
+            data_set->GetPoint(i, x);
+            for (int j = 0; j < 3; j++)
+                coords[3 * i + j] = x[j];
+        }
+    });
+    return std::make_shared<RegionIndex>(coords);
+}
+
+std::shared_ptr<RegionIndex>
+RegionIndex::fromCellCentroids(vtkUnstructuredGrid * grid)
+{
+    vtkIdType n = grid->GetNumberOfCells();
+    std::vector<float> coords(3 * n);
+    vtkSMPThreadLocalObject<vtkIdList> cell_pts;
+    vtkSMPTools::For(0, n, [&](vtkIdType begin, vtkIdType end) {
+        auto ids = cell_pts.Local();
+        for (vtkIdType i = begin; i < end; i++) {
+            vtkIdType npts;
+            const vtkIdType * pts;
+            grid->GetCellPoints(i, npts, pts, ids);
+            double c[3] = { 0., 0., 0. };
+            for (vtkIdType k = 0; k < npts; k++) {
+                double x[3];
+                grid->GetPoint(pts[k], x);
+                for (int j = 0; j < 3; j++)
+                    c[j] += x[j];
+            }
+            for (int j = 0; j < 3; j++)
+                coords[3 * i + j] = npts > 0 ? c[j] / npts : 0.;
+        }
+    });
+    return std::make_shared<RegionIndex>(coords);
+}
+
+RegionIndex::RegionIndex(const std::vector<float> & coords) : n_points(coords.size() / 3)
+{
+    double lo[3], hi[3];
+    for (int j = 0; j < 3; j++) {
+        lo[j] = std::numeric_limits<double>::max();
+        hi[j] = std::numeric_limits<double>::lowest();
+    }
+    for (vtkIdType i = 0; i < this->n_points; i++) {
+        for (int j = 0; j < 3; j++) {
+            lo[j] = std::min<double>(lo[j], coords[3 * i + j]);
+            hi[j] = std::max<double>(hi[j], coords[3 * i + j]);
+        }
+    }
+
+    // buckets are roughly cubes, flat directions get a single layer of buckets
+    vtkIdType n_buckets = std::max<vtkIdType>(1, this->n_points / POINTS_PER_BUCKET);
+    double volume = 1.;
+    int n_dims = 0;
+    for (int j = 0; j < 3; j++) {
+        if (hi[j] > lo[j]) {
+            volume *= hi[j] - lo[j];
+            n_dims++;
+        }
+    }
+    double h = n_dims > 0 ? std::pow(volume / n_buckets, 1. / n_dims) : 1.;
+    for (int j = 0; j < 3; j++) {
+        auto extent = hi[j] > lo[j] ? hi[j] - lo[j] : 0.;
+        this->dims[j] = std::max(1, (int) std::lround(extent / h));
+        this->origin[j] = this->n_points > 0 ? lo[j] : 0.;
+        this->spacing[j] = extent > 0. ? extent / this->dims[j] : 1.;
+    }
+
+    auto bucket_of = [&](vtkIdType i) {
+        vtkIdType idx[3];
+        for (int j = 0; j < 3; j++) {
+            auto k = (vtkIdType) ((coords[3 * i + j] - this->origin[j]) / this->spacing[j]);
+            idx[j] = std::clamp<vtkIdType>(k, 0, this->dims[j] - 1);
+        }
+        return idx[0] + this->dims[0] * (idx[1] + this->dims[1] * idx[2]);
+    };
+
+    // counting sort of points by bucket
+    vtkIdType total_buckets = (vtkIdType) this->dims[0] * this->dims[1] * this->dims[2];
+    std::vector<vtkIdType> bucket(this->n_points);
+    vtkSMPTools::For(0, this->n_points, [&](vtkIdType begin, vtkIdType end) {
+        for (vtkIdType i = begin; i < end; i++)
+            bucket[i] = bucket_of(i);
+    });
+    this->bucket_offsets.assign(total_buckets + 1, 0);
+    for (auto b : bucket)
+        this->bucket_offsets[b + 1]++;
+    for (vtkIdType b = 0; b < total_buckets; b++)
+        this->bucket_offsets[b + 1] += this->bucket_offsets[b];
+
+    this->ids.resize(this->n_points);
+    this->coords.resize(3 * this->n_points);
+    std::vector<vtkIdType> pos(this->bucket_offsets.begin(), this->bucket_offsets.end() - 1);
+    for (vtkIdType i = 0; i < this->n_points; i++) {
+        auto k = pos[bucket[i]]++;
+        this->ids[k] = i;
+        for (int j = 0; j < 3; j++)
+            this->coords[3 * k + j] = coords[3 * i + j];
+    }
+
+    this->bucket_bounds.resize(total_buckets);
+    vtkSMPTools::For(0, total_buckets, [&](vtkIdType begin, vtkIdType end) {
+        for (vtkIdType b = begin; b < end; b++) {
+            auto & bnds = this->bucket_bounds[b];
+            for (int j = 0; j < 3; j++) {
+                bnds[2 * j] = std::numeric_limits<float>::max();
+                bnds[2 * j + 1] = std::numeric_limits<float>::lowest();
+            }
+            for (auto k = this->bucket_offsets[b]; k < this->bucket_offsets[b + 1]; k++) {
+                for (int j = 0; j < 3; j++) {
+                    bnds[2 * j] = std::min(bnds[2 * j], this->coords[3 * k + j]);
+                    bnds[2 * j + 1] = std::max(bnds[2 * j + 1], this->coords[3 * k + j]);
+                }
+            }
+        }
+    });
+}
+
+vtkIdType
+RegionIndex::getNumberOfPoints() const
+{
+    return this->n_points;
+}
+
+std::vector<vtkIdType>
+RegionIndex::query(vtkMatrix4x4 * transform, const Region & region) const
+{
+    if (region.polygon.size() < 3)
+        return {};
+
+    double m[16];
+    vtkMatrix4x4::DeepCopy(m, transform);
+
+    double rx[2] = { std::numeric_limits<double>::max(), std::numeric_limits<double>::lowest() };
+    double ry[2] = { std::numeric_limits<double>::max(), std::numeric_limits<double>::lowest() };
+    for (auto & pt : region.polygon) {
+        rx[0] = std::min(rx[0], pt[0]);
+        rx[1] = std::max(rx[1], pt[0]);
+        ry[0] = std::min(ry[0], pt[1]);
+        ry[1] = std::max(ry[1], pt[1]);
+    }
+
+    auto is_inside = [&](const Projected & p) {
+        if (p.w <= 0.)
+            return false;
+        auto x = p.x / p.w;
+        auto y = p.y / p.w;
+        auto z = p.z / p.w;
+        if (z < -1. || z > 1. || x < rx[0] || x > rx[1] || y < ry[0] || y > ry[1])
+            return false;
+        return region.box || isInsidePolygon(region.polygon, x, y);
+    };
+
+    auto classify = [&](const std::array<float, 6> & bnds) {
+        double lo[3] = { std::numeric_limits<double>::max(),
+                         std::numeric_limits<double>::max(),
+                         std::numeric_limits<double>::max() };
+        double hi[3] = { std::numeric_limits<double>::lowest(),
+                         std::numeric_limits<double>::lowest(),
+                         std::numeric_limits<double>::lowest() };
+        for (int c = 0; c < 8; c++) {
+            auto p = project(m, bnds[c & 1], bnds[2 + ((c >> 1) & 1)], bnds[4 + ((c >> 2) & 1)]);
+            // corners behind the camera do not project in a useful way
+            if (p.w <= 0.)
+                return PARTIAL;
+            double q[3] = { p.x / p.w, p.y / p.w, p.z / p.w };
+            for (int j = 0; j < 3; j++) {
+                lo[j] = std::min(lo[j], q[j]);
+                hi[j] = std::max(hi[j], q[j]);
+            }
+        }
+        if (hi[0] < rx[0] || lo[0] > rx[1] || hi[1] < ry[0] || lo[1] > ry[1] || hi[2] < -1. ||
+            lo[2] > 1.)
+            return OUTSIDE;
+        if (region.box && lo[0] >= rx[0] && hi[0] <= rx[1] && lo[1] >= ry[0] && hi[1] <= ry[1] &&
+            lo[2] >= -1. && hi[2] <= 1.)
+            return INSIDE;
+        return PARTIAL;
+    };
+
+    vtkIdType n_buckets = this->bucket_bounds.size();
+    vtkSMPThreadLocal<std::vector<vtkIdType>> found;
+    vtkSMPTools::For(0, n_buckets, [&](vtkIdType begin, vtkIdType end) {
+        auto & local = found.Local();
+        for (vtkIdType b = begin; b < end; b++) {
+            auto first = this->bucket_offsets[b];
+            auto last = this->bucket_offsets[b + 1];
+            if (first == last)
+                continue;
+
+            auto cls = classify(this->bucket_bounds[b]);
+            if (cls == INSIDE)
+                local.insert(local.end(), this->ids.begin() + first, this->ids.begin() + last);
+            else if (cls == PARTIAL) {
+                for (auto k = first; k < last; k++) {
+                    auto * x = &this->coords[3 * k];
+                    if (is_inside(project(m, x[0], x[1], x[2])))
+                        local.push_back(this->ids[k]);
+                }
+            }
+        }
+    });
+
+    std::vector<vtkIdType> result;
+    for (auto & local : found)
+        result.insert(result.end(), local.begin(), local.end());
+    vtkSMPTools::Sort(result.begin(), result.end());
+    return result;
+}
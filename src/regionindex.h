@@ -0,0 +1,62 @@
+// SPDX-FileCopyrightText: 2024 David Andrs <andrsd@gmail.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <array>
+#include <memory>
+#include <vector>
+#include "vtkType.h"
+
+class vtkDataSet;
+class vtkUnstructuredGrid;
+class vtkMatrix4x4;
+
+/// Spatial index of points (mesh nodes or cell centroids) answering screen region queries
+///
+/// Points are bucketed into a uniform grid. A query projects the bounding box of each bucket onto
+/// the screen first and tests individual points only in buckets that straddle the region
+/// boundary. Buckets are processed in parallel.
+class RegionIndex {
+public:
+    /// Region on the screen
+    struct Region {
+        /// Polygon vertices (x, y) in normalized device coordinates
+        std::vector<std::array<double, 2>> polygon;
+        /// `true` if the polygon is an axis-aligned box
+        bool box = true;
+    };
+
+    /// Build the index of points of a data set
+    static std::shared_ptr<RegionIndex> fromPoints(vtkDataSet * data_set);
+    /// Build the index of cell centroids of an unstructured grid
+    static std::shared_ptr<RegionIndex> fromCellCentroids(vtkUnstructuredGrid * grid);
+
+    /// @param coords Coordinates (x, y, z) of points ordered by their ids
+    explicit RegionIndex(const std::vector<float> & coords);
+
+    /// Get number of indexed points
+    vtkIdType getNumberOfPoints() const;
+
+    /// Find points inside a region
+    ///
+    /// @param transform Transformation from point coordinates to normalized device coordinates
+    /// @param region Region to query
+    /// @return Sorted ids of points that project inside the region and lie between the near and
+    ///         the far clipping plane
+    std::vector<vtkIdType> query(vtkMatrix4x4 * transform, const Region & region) const;
+
+protected:
+    vtkIdType n_points;
+    int dims[3];
+    double origin[3];
+    double spacing[3];
+    /// Start of each bucket in `ids` and `coords`
+    std::vector<vtkIdType> bucket_offsets;
+    /// Point ids ordered by bucket
+    std::vector<vtkIdType> ids;
+    /// Point coordinates ordered by bucket
+    std::vector<float> coords;
+    /// Bounding box of points in each bucket (xmin, xmax, ymin, ymax, zmin, zmax)
+    std::vector<std::array<float, 6>> bucket_bounds;
+};
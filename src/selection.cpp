@@ -3,37 +3,63 @@
 
 #include "selection.h"
 #include "vtkActor.h"
-#include "vtkDataSetMapper.h"
-#include "vtkCompositeDataGeometryFilter.h"
-#include "vtkGeometryFilter.h"
-#include "vtkExtractSelection.h"
-#include "vtkUnstructuredGrid.h"
-#include "vtkSelection.h"
-#include "vtkSelectionNode.h"
-#include "vtkAlgorithmOutput.h"
-#include "vtkMultiBlockDataSet.h"
-
-Selection::Selection(vtkAlgorithmOutput * input_data) :
-    geometry(nullptr),
-    extract_selection(vtkSmartPointer<vtkExtractSelection>::New()),
-    selected(vtkSmartPointer<vtkUnstructuredGrid>::New()),
-    mapper(vtkSmartPointer<vtkDataSetMapper>::New()),
-    actor(vtkSmartPointer<vtkActor>::New()),
-    selection(vtkSmartPointer<vtkSelection>::New())
+#include "vtkPolyDataMapper.h"
+#include "vtkPolyData.h"
+#include "vtkPoints.h"
+#include "vtkCellArray.h"
+#include "vtkCellTypes.h"
+#include "vtkIdList.h"
+#include "vtkDataSet.h"
+#include "vtkMatrix4x4.h"
+#include "vtkExtractCells.h"
+#include "vtkAppendPolyData.h"
+#include "vtkboundaryextractor.h"
+#include <algorithm>
+
+namespace {
+
+/// Transform points of a poly data into world coordinates
+void
+transformPoints(vtkPolyData * poly_data, vtkMatrix4x4 * matrix)
+{
+    auto n = poly_data->GetNumberOfPoints();
+    auto points = vtkSmartPointer<vtkPoints>::New();
+    points->SetDataTypeToDouble();
+    points->SetNumberOfPoints(n);
+    for (vtkIdType i = 0; i < n; i++) {
+        double in[4] = { 0., 0., 0., 1. };
+        double out[4];
+        poly_data->GetPoint(i, in);
+        matrix->MultiplyPoint(in, out);
+        points->SetPoint(i, out[0] / out[3], out[1] / out[3], out[2] / out[3]);
+    }
+    poly_data->SetPoints(points);
+}
+
+} // namespace
+
+Selection::Selection() :
+    points(vtkSmartPointer<vtkPoints>::New()),
+    verts(vtkSmartPointer<vtkCellArray>::New()),
+    lines(vtkSmartPointer<vtkCellArray>::New()),
+    polys(vtkSmartPointer<vtkCellArray>::New()),
+    point_ids(vtkSmartPointer<vtkIdList>::New()),
+    selected(vtkSmartPointer<vtkPolyData>::New()),
+    matrix(vtkSmartPointer<vtkMatrix4x4>::New()),
+    mapper(vtkSmartPointer<vtkPolyDataMapper>::New()),
+    actor(vtkSmartPointer<vtkActor>::New())
 {
-    auto * algoritm = input_data->GetProducer();
-    auto * data_object = algoritm->GetOutputDataObject(0);
-    if (dynamic_cast<vtkMultiBlockDataSet *>(data_object))
-        this->geometry = vtkSmartPointer<vtkCompositeDataGeometryFilter>::New();
-    else
-        this->geometry = vtkSmartPointer<vtkGeometryFilter>::New();
-    this->geometry->SetInputConnection(0, input_data);
-    this->geometry->Update();
-    this->extract_selection->SetInputData(0, this->geometry->GetOutput());
+    this->points->SetDataTypeToDouble();
+    this->selected->SetPoints(this->points);
+    this->selected->SetVerts(this->verts);
+    this->selected->SetLines(this->lines);
+    this->selected->SetPolys(this->polys);
     this->mapper->SetInputData(this->selected);
     this->mapper->SetScalarModeToUsePointFieldData();
     this->mapper->InterpolateScalarsBeforeMappingOn();
     this->actor->SetMapper(this->mapper);
+    this->actor->SetUserMatrix(this->matrix);
+    this->actor->PickableOff();
 }
 
 Selection::~Selection() {}
@@ -44,7 +70,7 @@ Selection::getActor() const
     return this->actor;
 }
 
-vtkUnstructuredGrid *
+vtkPolyData *
 Selection::getSelected() const
 {
     return this->selected;
@@ -53,51 +79,142 @@ Selection::getSelected() const
 void
 Selection::clear()
 {
-    this->selected->Initialize();
-    this->mapper->SetInputData(this->selected);
+    reset();
+    modified();
 }
 
 void
-Selection::selectPoint(const vtkIdType & point_id)
+Selection::selectPoint(vtkDataSet * data_set, vtkIdType point_id)
 {
-    auto ids = vtkSmartPointer<vtkIdTypeArray>::New();
-    ids->SetNumberOfComponents(1);
-    ids->InsertNextValue(point_id);
-
-    auto selection_node = vtkSmartPointer<vtkSelectionNode>::New();
-    selection_node->SetFieldType(vtkSelectionNode::POINT);
-    selection_node->SetContentType(vtkSelectionNode::INDICES);
-    selection_node->SetSelectionList(ids);
-
-    setSelection(selection_node);
+    reset();
+    this->points->SetNumberOfPoints(1);
+    this->points->SetPoint(0, data_set->GetPoint(point_id));
+    this->verts->InsertNextCell(1);
+    this->verts->InsertCellPoint(0);
+    modified();
 }
 
 void
-Selection::selectCell(const vtkIdType & cell_id)
+Selection::selectCell(vtkDataSet * data_set, vtkIdType cell_id)
 {
-    auto ids = vtkSmartPointer<vtkIdTypeArray>::New();
-    ids->SetNumberOfComponents(1);
-    ids->InsertNextValue(cell_id);
-
-    auto selection_node = vtkSmartPointer<vtkSelectionNode>::New();
-    selection_node->SetFieldType(vtkSelectionNode::CELL);
-    selection_node->SetContentType(vtkSelectionNode::INDICES);
-    selection_node->SetSelectionList(ids);
+    reset();
+    data_set->GetCellPoints(cell_id, this->point_ids);
+    auto n = this->point_ids->GetNumberOfIds();
+    this->points->SetNumberOfPoints(n);
+    for (vtkIdType i = 0; i < n; i++)
+        this->points->SetPoint(i, data_set->GetPoint(this->point_ids->GetId(i)));
+
+    vtkCellArray * cells;
+    switch (vtkCellTypes::GetDimension(data_set->GetCellType(cell_id))) {
+    case 0:
+        cells = this->verts;
+        break;
+    case 1:
+        cells = this->lines;
+        break;
+    default:
+        cells = this->polys;
+        break;
+    }
+    cells->InsertNextCell(n);
+    for (vtkIdType i = 0; i < n; i++)
+        cells->InsertCellPoint(i);
+    modified();
+}
 
-    setSelection(selection_node);
+void
+Selection::selectPoints(const std::vector<Part> & parts)
+{
+    reset();
+    vtkIdType n = 0;
+    for (auto & part : parts)
+        n += part.ids.size();
+    this->points->SetNumberOfPoints(n);
+    this->verts->AllocateExact(n, n);
+
+    vtkIdType k = 0;
+    for (auto & part : parts) {
+        for (auto id : part.ids) {
+            double in[4] = { 0., 0., 0., 1. };
+            double out[4];
+            part.data_set->GetPoint(id, in);
+            if (part.matrix != nullptr)
+                part.matrix->MultiplyPoint(in, out);
+            else
+                std::copy(in, in + 4, out);
+            this->points->SetPoint(k, out[0] / out[3], out[1] / out[3], out[2] / out[3]);
+            this->verts->InsertNextCell(1, &k);
+            k++;
+        }
+    }
+    this->matrix->Identity();
+    this->actor->Modified();
+    modified();
 }
 
 void
-Selection::setSelection(vtkSelectionNode * selection_node)
+Selection::selectCells(const std::vector<Part> & parts)
 {
-    this->selection = vtkSmartPointer<vtkSelection>::New();
-    this->selection->AddNode(selection_node);
+    auto append = vtkSmartPointer<vtkAppendPolyData>::New();
+    for (auto & part : parts) {
+        if (part.ids.empty())
+            continue;
+
+        auto extract = vtkSmartPointer<vtkExtractCells>::New();
+        extract->SetInputData(part.data_set);
+        extract->SetCellIds(part.ids.data(), (vtkIdType) part.ids.size());
+        extract->AssumeSortedAndUniqueIdsOn();
+        auto boundary = vtkSmartPointer<vtkBoundaryExtractor>::New();
+        boundary->SetInputConnection(extract->GetOutputPort());
+        boundary->Update();
+
+        // only the geometry is shown
+        auto surface = vtkSmartPointer<vtkPolyData>::New();
+        surface->CopyStructure(boundary->GetOutput());
+        if (part.matrix != nullptr)
+            transformPoints(surface, part.matrix);
+        append->AddInputData(surface);
+    }
+
+    if (append->GetNumberOfInputConnections(0) == 0) {
+        clear();
+        return;
+    }
+
+    append->Update();
+    this->selected->ShallowCopy(append->GetOutput());
+    this->matrix->Identity();
+    this->actor->Modified();
+    modified();
+}
 
-    this->extract_selection->SetInputData(1, this->selection);
-    this->extract_selection->Update();
+void
+Selection::setMatrix(vtkMatrix4x4 * matrix)
+{
+    this->matrix->DeepCopy(matrix);
+    this->actor->Modified();
+}
 
-    this->selected = vtkSmartPointer<vtkUnstructuredGrid>::New();
-    this->selected->ShallowCopy(this->extract_selection->GetOutput());
+void
+Selection::reset()
+{
+    this->points->Reset();
+    this->verts->Reset();
+    this->lines->Reset();
+    this->polys->Reset();
+    if (this->selected->GetPoints() != this->points) {
+        this->selected->Initialize();
+        this->selected->SetPoints(this->points);
+        this->selected->SetVerts(this->verts);
+        this->selected->SetLines(this->lines);
+        this->selected->SetPolys(this->polys);
+    }
+}
 
-    this->mapper->SetInputData(this->selected);
+void
+Selection::modified()
+{
+    this->points->Modified();
+    this->selected->DeleteCells();
+    this->selected->Modified();
 }
@@ -3,36 +3,74 @@
 
 #pragma once
 
+#include <vector>
 #include "vtkType.h"
 #include "vtkSmartPointer.h"
 
 class vtkActor;
-class vtkDataSetMapper;
-class vtkPolyDataAlgorithm;
-class vtkExtractSelection;
-class vtkUnstructuredGrid;
-class vtkSelection;
-class vtkSelectionNode;
-class vtkAlgorithmOutput;
+class vtkPolyDataMapper;
+class vtkPolyData;
+class vtkPoints;
+class vtkCellArray;
+class vtkIdList;
+class vtkDataSet;
+class vtkMatrix4x4;
 
+/// Selected cell or point
+///
+/// The geometry of the selected entity is copied from the surface it was picked on into a small
+/// poly data that is reused for all selections. Selections of many cells or points are gathered
+/// from all parts into a single poly data, so that they are rendered by a single actor.
 class Selection {
 public:
-    explicit Selection(vtkAlgorithmOutput * input_data);
+    /// Entities selected in one data set
+    struct Part {
+        /// Data set the entities belong to
+        vtkDataSet * data_set;
+        /// Sorted ids of the selected entities in `data_set`
+        std::vector<vtkIdType> ids;
+        /// Transformation of `data_set` (`nullptr` means identity)
+        vtkMatrix4x4 * matrix;
+    };
+
+    Selection();
     virtual ~Selection();
 
     vtkActor * getActor() const;
-    vtkUnstructuredGrid * getSelected() const;
+    vtkPolyData * getSelected() const;
     void clear();
-    void selectPoint(const vtkIdType & point_id);
-    void selectCell(const vtkIdType & cell_id);
+    /// Select a point
+    ///
+    /// @param data_set Data set the point belongs to
+    /// @param point_id Id of the point in `data_set`
+    void selectPoint(vtkDataSet * data_set, vtkIdType point_id);
+    /// Select a cell
+    ///
+    /// @param data_set Data set the cell belongs to
+    /// @param cell_id Id of the cell in `data_set`
+    void selectCell(vtkDataSet * data_set, vtkIdType cell_id);
+    /// Select points of several data sets
+    void selectPoints(const std::vector<Part> & parts);
+    /// Select cells of several data sets
+    ///
+    /// Only the boundary of the selected cells is shown.
+    void selectCells(const std::vector<Part> & parts);
+    /// Set transformation of the selection (the same as of the actor the data set is rendered by)
+    void setMatrix(vtkMatrix4x4 * matrix);
 
 protected:
-    void setSelection(vtkSelectionNode * selection_node);
+    /// Make the selected poly data use the reusable points and cells again
+    void reset();
+    /// Let the pipeline know that the selected geometry changed
+    void modified();
 
-    vtkSmartPointer<vtkPolyDataAlgorithm> geometry;
-    vtkSmartPointer<vtkExtractSelection> extract_selection;
-    vtkSmartPointer<vtkUnstructuredGrid> selected;
-    vtkSmartPointer<vtkDataSetMapper> mapper;
+    vtkSmartPointer<vtkPoints> points;
+    vtkSmartPointer<vtkCellArray> verts;
+    vtkSmartPointer<vtkCellArray> lines;
+    vtkSmartPointer<vtkCellArray> polys;
+    vtkSmartPointer<vtkIdList> point_ids;
+    vtkSmartPointer<vtkPolyData> selected;
+    vtkSmartPointer<vtkMatrix4x4> matrix;
+    vtkSmartPointer<vtkPolyDataMapper> mapper;
     vtkSmartPointer<vtkActor> actor;
-    vtkSmartPointer<vtkSelection> selection;
 };
@@ -11,19 +11,32 @@
 #include <QAction>
 #include <QActionGroup>
 #include <QSettings>
+#include <QRect>
+#include <QStringList>
 #include "common/infowidget.h"
 #include "blockobject.h"
 #include "sidesetobject.h"
 #include "nodesetobject.h"
 #include "selection.h"
+#include "regionindex.h"
 #include "vtkPropPicker.h"
-#include "vtkCellPicker.h"
-#include "vtkPointPicker.h"
+#include "vtkMatrix4x4.h"
 #include "vtkActor.h"
 #include "vtkUnstructuredGrid.h"
 #include "vtkRenderer.h"
 #include "vtkProperty.h"
 #include "vtkAlgorithmOutput.h"
+#include "vtkPolyData.h"
+#include "vtkPointData.h"
+#include "vtkCellData.h"
+#include "vtkIdTypeArray.h"
+#include "vtkboundaryextractor.h"
+#include "vtkCamera.h"
+#include "vtkPoints.h"
+#include "vtkCellArray.h"
+#include "vtkActor2D.h"
+#include "vtkPolyDataMapper2D.h"
+#include "vtkProperty2D.h"
 
 QColor SelectTool::SELECTION_CLR = QColor(255, 173, 79);
 QColor SelectTool::SELECTION_EDGE_CLR = QColor(179, 95, 0);
@@ -31,6 +44,11 @@ QColor SelectTool::HIGHLIGHT_CLR = QColor(255, 211, 79);
 
 namespace {
 
+/// Shortest distance in pixels between two subsequent points of a lasso
+const int LASSO_SPACING = 3;
+/// Most ids listed per block in the info about a region selection
+const std::size_t MAX_LISTED_IDS = 10;
+
 QString
 cellTypeToName(int cell_type)
 {
@@ -55,6 +73,22 @@ cellTypeToName(int cell_type)
     // clang-format on
 }
 
+/// Get the id of the entity a surface entity was extracted from
+///
+/// @param data Point or cell data of the surface
+/// @param name Name of the array with the original ids
+/// @param id Id of the surface entity
+/// @return Original id, -1 if it is not known
+vtkIdType
+getOriginalId(vtkDataSetAttributes * data, const char * name, vtkIdType id)
+{
+    auto * ids = vtkIdTypeArray::SafeDownCast(data->GetArray(name));
+    if (ids != nullptr)
+        return ids->GetValue(id);
+    else
+        return -1;
+}
+
 } // namespace
 
 SelectTool::SelectTool(MainWindow * main_wnd) :
@@ -68,8 +102,16 @@ SelectTool::SelectTool(MainWindow * main_wnd) :
     selection(nullptr),
     selected_block(nullptr),
     highlight(nullptr),
-    highlighted_block(nullptr)
+    highlighted_block(nullptr),
+    hover_picker(nullptr),
+    dragging(false),
+    lasso(false)
 {
+    this->hover_picker = new HoverPicker(
+        [this](const QPoint & pt, HoverPicker::Request & request) {
+            return preparePick(pt, request);
+        },
+        [this](const HoverPicker::Result & result) { onHoverPicked(result); });
 }
 
 SelectTool::~SelectTool()
@@ -77,6 +119,7 @@ SelectTool::~SelectTool()
     delete this->selected_mesh_ent_info;
     delete this->deselect_sc;
     delete this->mode_select_action_group;
+    delete this->hover_picker;
 }
 
 const std::shared_ptr<BlockObject>
@@ -104,10 +147,18 @@ SelectTool::setupMenu(QMenu * menu)
     this->select_mode =
         static_cast<EModeSelect>(settings->value("tools/select_mode", MODE_SELECT_NONE).toInt());
 
-    QList<QString> names(
-        { QString("None"), QString("Blocks"), QString("Cells"), QString("Points") });
-    QList<EModeSelect> modes(
-        { MODE_SELECT_NONE, MODE_SELECT_BLOCKS, MODE_SELECT_CELLS, MODE_SELECT_POINTS });
+    QList<QString> names({ QString("None"),
+                           QString("Blocks"),
+                           QString("Cells"),
+                           QString("Points"),
+                           QString("Cells in region"),
+                           QString("Points in region") });
+    QList<EModeSelect> modes({ MODE_SELECT_NONE,
+                               MODE_SELECT_BLOCKS,
+                               MODE_SELECT_CELLS,
+                               MODE_SELECT_POINTS,
+                               MODE_SELECT_CELL_REGION,
+                               MODE_SELECT_POINT_REGION });
     for (int i = 0; i < names.size(); i++) {
         auto name = names[i];
         auto mode = modes[i];
@@ -128,16 +179,32 @@ SelectTool::setupMenu(QMenu * menu)
 void
 SelectTool::update()
 {
-    auto output_port = this->model->getVtkOutputPort();
-
-    this->selection = std::make_shared<Selection>(output_port);
+    this->selection = std::make_shared<Selection>();
     setSelectionProperties();
     auto renderer = this->view->getRenderer();
     renderer->AddActor(this->selection->getActor());
 
-    this->highlight = std::make_shared<Selection>(output_port);
+    this->highlight = std::make_shared<Selection>();
     setHighlightProperties();
     renderer->AddActor(this->highlight->getActor());
+
+    this->rubber_band_points = vtkSmartPointer<vtkPoints>::New();
+    this->rubber_band_lines = vtkSmartPointer<vtkCellArray>::New();
+    this->rubber_band = vtkSmartPointer<vtkPolyData>::New();
+    this->rubber_band->SetPoints(this->rubber_band_points);
+    this->rubber_band->SetLines(this->rubber_band_lines);
+    auto mapper = vtkSmartPointer<vtkPolyDataMapper2D>::New();
+    mapper->SetInputData(this->rubber_band);
+    this->rubber_band_actor = vtkSmartPointer<vtkActor2D>::New();
+    this->rubber_band_actor->SetMapper(mapper);
+    this->rubber_band_actor->PickableOff();
+    this->rubber_band_actor->VisibilityOff();
+    auto * property = this->rubber_band_actor->GetProperty();
+    property->SetColor(SELECTION_EDGE_CLR.redF(),
+                       SELECTION_EDGE_CLR.greenF(),
+                       SELECTION_EDGE_CLR.blueF());
+    property->SetLineWidth(this->main_window->HIDPI(1.5));
+    renderer->AddActor2D(this->rubber_band_actor);
 }
 
 void
@@ -235,19 +302,28 @@ SelectTool::onSelectModeTriggered(QAction * action)
 {
     action->setChecked(true);
     this->select_mode = static_cast<EModeSelect>(action->data().toInt());
+    this->hover_picker->cancel();
+    this->dragging = false;
+    if (this->rubber_band_actor)
+        this->rubber_band_actor->VisibilityOff();
+    if (this->highlight)
+        this->highlight->clear();
     if (this->select_mode == MODE_SELECT_NONE) {
         deselectBlocks();
         onDeselect();
-        if (this->highlight)
-            this->highlight->clear();
     }
 }
 
 void
 SelectTool::clear()
 {
+    this->hover_picker->cancel();
     this->selection = nullptr;
     this->highlight = nullptr;
+    this->dragging = false;
+    this->rubber_band_actor = nullptr;
+    this->cell_indices.clear();
+    this->point_indices.clear();
 }
 
 void
@@ -270,15 +346,23 @@ SelectTool::selectBlock(const QPoint & pt)
 void
 SelectTool::selectCell(const QPoint & pt)
 {
-    auto picker = vtkSmartPointer<vtkCellPicker>::New();
-    if (picker->Pick(pt.x(), pt.y(), 0, this->view->getRenderer())) {
-        auto cell_id = picker->GetCellId();
-        this->selection->selectCell(cell_id);
+    HoverPicker::Result result;
+    if (pickCell(pt, result)) {
+        selectPicked(this->selection.get(), result);
         setSelectionProperties();
 
-        auto * unstr_grid = this->selection->getSelected();
-        auto * cell = unstr_grid->GetCell(0);
-        auto cell_type = cell->GetCellType();
+        // report the cell the picked face belongs to
+        auto cell_id = result.cell_id;
+        int cell_type = result.data_set->GetCellType(cell_id);
+        auto orig_id = getOriginalId(result.data_set->GetCellData(),
+                                     vtkBoundaryExtractor::GetOriginalCellIdsName(),
+                                     cell_id);
+        auto block = this->model->getBlock(result.block_id);
+        auto * grid = block ? block->getUnstructuredGrid() : nullptr;
+        if (orig_id != -1 && grid != nullptr && orig_id < grid->GetNumberOfCells()) {
+            cell_id = orig_id;
+            cell_type = grid->GetCellType(orig_id);
+        }
         QString nfo =
             QString("Element ID: %1\nType: %2").arg(cell_id).arg(cellTypeToName(cell_type));
         showSelectedMeshEntity(nfo);
@@ -288,14 +372,20 @@ SelectTool::selectCell(const QPoint & pt)
 void
 SelectTool::selectPoint(const QPoint & pt)
 {
-    auto picker = vtkSmartPointer<vtkPointPicker>::New();
-    if (picker->Pick(pt.x(), pt.y(), 0, this->view->getRenderer())) {
-        auto point_id = picker->GetPointId();
-        this->selection->selectPoint(point_id);
+    // the point closest to the pick position in the picked cell
+    HoverPicker::Result result;
+    if (pickCell(pt, result)) {
+        selectPicked(this->selection.get(), result);
         setSelectionProperties();
 
-        auto * unstr_grid = this->selection->getSelected();
-        auto * points = unstr_grid->GetPoints();
+        auto point_id = result.point_id;
+        auto orig_id = getOriginalId(result.data_set->GetPointData(),
+                                     vtkBoundaryExtractor::GetOriginalPointIdsName(),
+                                     point_id);
+        if (orig_id != -1)
+            point_id = orig_id;
+
+        auto * points = this->selection->getSelected()->GetPoints();
         if (points) {
             double * coords = points->GetPoint(0);
             char format = 'f';
@@ -319,7 +409,8 @@ SelectTool::setSelectionProperties()
 {
     auto * actor = this->selection->getActor();
     auto * property = actor->GetProperty();
-    if (this->select_mode == MODE_SELECT_POINTS) {
+    if (this->select_mode == MODE_SELECT_POINTS ||
+        this->select_mode == MODE_SELECT_POINT_REGION) {
         property->SetRepresentationToPoints();
         property->SetRenderPointsAsSpheres(true);
         property->SetVertexVisibility(true);
@@ -330,7 +421,8 @@ SelectTool::setSelectionProperties()
         property->SetAmbient(1);
         property->SetDiffuse(0);
     }
-    else if (this->select_mode == MODE_SELECT_CELLS) {
+    else if (this->select_mode == MODE_SELECT_CELLS ||
+             this->select_mode == MODE_SELECT_CELL_REGION) {
         property->SetRepresentationToSurface();
         property->SetRenderPointsAsSpheres(false);
         property->SetVertexVisibility(false);
@@ -375,27 +467,33 @@ SelectTool::highlightBlock(const QPoint & pt)
 void
 SelectTool::highlightCell(const QPoint & pt)
 {
-    auto picker = vtkSmartPointer<vtkCellPicker>::New();
-    if (picker->Pick(pt.x(), pt.y(), 0, this->view->getRenderer())) {
-        auto cell_id = picker->GetCellId();
-        this->highlight->selectCell(cell_id);
-        setHighlightProperties();
-    }
-    else
-        this->highlight->clear();
+    // picked in the background, see `onHoverPicked`
+    this->hover_picker->request(pt);
 }
 
 void
 SelectTool::highlightPoint(const QPoint & pt)
 {
-    auto picker = vtkSmartPointer<vtkPointPicker>::New();
-    if (picker->Pick(pt.x(), pt.y(), 0, this->view->getRenderer())) {
-        auto point_id = picker->GetPointId();
-        this->highlight->selectPoint(point_id);
+    // picked in the background, see `onHoverPicked`
+    this->hover_picker->request(pt);
+}
+
+void
+SelectTool::onHoverPicked(const HoverPicker::Result & result)
+{
+    if (this->highlight == nullptr)
+        return;
+
+    if (this->select_mode != MODE_SELECT_CELLS && this->select_mode != MODE_SELECT_POINTS)
+        return;
+
+    if (result.cell_id == -1)
+        this->highlight->clear();
+    else {
+        selectPicked(this->highlight.get(), result);
         setHighlightProperties();
     }
-    else
-        this->highlight->clear();
+    this->view->render();
 }
 
 void
@@ -434,6 +532,38 @@ SelectTool::saveSettings(QSettings * settings)
     settings->setValue("tools/select_mode", this->select_mode);
 }
 
+void
+SelectTool::onLeftButtonPress(const QPoint & pt, const Qt::KeyboardModifiers & mods)
+{
+    if (!isRegionMode() || this->rubber_band_actor == nullptr)
+        return;
+
+    this->dragging = true;
+    this->lasso = mods.testFlag(Qt::ShiftModifier);
+    this->region_path.clear();
+    this->region_path.push_back(pt);
+}
+
+void
+SelectTool::onLeftButtonRelease(const QPoint & pt)
+{
+    if (!this->dragging)
+        return;
+
+    updateRegion(pt);
+    this->dragging = false;
+    this->rubber_band_actor->VisibilityOff();
+    auto polygon = getRegionPolygon();
+    auto bbox = QRect(polygon.front(), polygon.front());
+    for (auto & p : polygon)
+        bbox |= QRect(p, p);
+    if (bbox.width() > 1 && bbox.height() > 1) {
+        onDeselect();
+        selectRegion();
+    }
+    this->view->render();
+}
+
 void
 SelectTool::onClicked(const QPoint & pt)
 {
@@ -449,10 +579,196 @@ SelectTool::onClicked(const QPoint & pt)
 void
 SelectTool::onMouseMove(const QPoint & pt)
 {
-    if (this->select_mode == MODE_SELECT_BLOCKS)
+    if (this->dragging) {
+        updateRegion(pt);
+        this->view->render();
+    }
+    else if (this->select_mode == MODE_SELECT_BLOCKS)
         highlightBlock(pt);
     else if (this->select_mode == MODE_SELECT_CELLS)
         highlightCell(pt);
     else if (this->select_mode == MODE_SELECT_POINTS)
         highlightPoint(pt);
 }
+
+bool
+SelectTool::preparePick(const QPoint & pt, HoverPicker::Request & request)
+{
+    for (auto & [id, block] : this->model->getBlocks()) {
+        if (!block->visible())
+            continue;
+        // locators are never built here, the cursor would stall
+        auto locator = block->getCellLocator();
+        if (locator == nullptr) {
+            if (block->isBuildingCellLocator())
+                request.incomplete = true;
+            continue;
+        }
+
+        HoverPicker::Target target = { id, locator, nullptr };
+        auto * actor = block->getActor();
+        if (!actor->GetIsIdentity()) {
+            target.transform = vtkSmartPointer<vtkMatrix4x4>::New();
+            vtkMatrix4x4::Invert(actor->GetMatrix(), target.transform);
+        }
+        request.targets.push_back(target);
+    }
+    if (request.targets.empty())
+        return false;
+
+    // the pick ray goes from the near to the far clipping plane
+    auto * renderer = this->view->getRenderer();
+    double * ends[] = { request.p1, request.p2 };
+    for (int i = 0; i < 2; i++) {
+        double world[4];
+        renderer->SetDisplayPoint(pt.x(), pt.y(), i);
+        renderer->DisplayToWorld();
+        renderer->GetWorldPoint(world);
+        for (int j = 0; j < 3; j++)
+            ends[i][j] = world[j] / world[3];
+    }
+    return true;
+}
+
+void
+SelectTool::selectPicked(Selection * sel, const HoverPicker::Result & result)
+{
+    if (this->select_mode == MODE_SELECT_CELLS)
+        sel->selectCell(result.data_set, result.cell_id);
+    else if (this->select_mode == MODE_SELECT_POINTS)
+        sel->selectPoint(result.data_set, result.point_id);
+
+    auto block = this->model->getBlock(result.block_id);
+    if (block)
+        sel->setMatrix(block->getActor()->GetMatrix());
+}
+
+bool
+SelectTool::pickCell(const QPoint & pt, HoverPicker::Result & result)
+{
+    HoverPicker::Request request;
+    if (!preparePick(pt, request))
+        return false;
+    result = HoverPicker::pick(request);
+    return result.cell_id != -1;
+}
+
+bool
+SelectTool::isRegionMode() const
+{
+    return this->select_mode == MODE_SELECT_CELL_REGION ||
+           this->select_mode == MODE_SELECT_POINT_REGION;
+}
+
+void
+SelectTool::updateRegion(const QPoint & pt)
+{
+    if (this->lasso) {
+        auto d = pt - this->region_path.back();
+        if (d.manhattanLength() < LASSO_SPACING)
+            return;
+        this->region_path.push_back(pt);
+    }
+    else {
+        this->region_path.resize(1);
+        this->region_path.push_back(pt);
+    }
+    updateRubberBand();
+}
+
+std::vector<QPoint>
+SelectTool::getRegionPolygon() const
+{
+    if (this->lasso || this->region_path.size() < 2)
+        return this->region_path;
+
+    auto & p1 = this->region_path.front();
+    auto & p2 = this->region_path.back();
+    return { p1, QPoint(p2.x(), p1.y()), p2, QPoint(p1.x(), p2.y()) };
+}
+
+void
+SelectTool::updateRubberBand()
+{
+    auto polygon = getRegionPolygon();
+    vtkIdType n = polygon.size();
+    this->rubber_band_points->SetNumberOfPoints(n);
+    for (vtkIdType i = 0; i < n; i++)
+        this->rubber_band_points->SetPoint(i, polygon[i].x(), polygon[i].y(), 0.);
+    this->rubber_band_lines->Reset();
+    this->rubber_band_lines->InsertNextCell(n + 1);
+    for (vtkIdType i = 0; i < n; i++)
+        this->rubber_band_lines->InsertCellPoint(i);
+    this->rubber_band_lines->InsertCellPoint(0);
+    this->rubber_band_points->Modified();
+    this->rubber_band->Modified();
+    this->rubber_band_actor->VisibilityOn();
+}
+
+void
+SelectTool::selectRegion()
+{
+    auto * renderer = this->view->getRenderer();
+    auto * origin = renderer->GetOrigin();
+    auto * size = renderer->GetSize();
+    RegionIndex::Region region;
+    region.box = !this->lasso;
+    for (auto & pt : getRegionPolygon()) {
+        double x = 2. * (pt.x() - origin[0]) / size[0] - 1.;
+        double y = 2. * (pt.y() - origin[1]) / size[1] - 1.;
+        region.polygon.push_back({ x, y });
+    }
+
+    auto cells = this->select_mode == MODE_SELECT_CELL_REGION;
+    auto * camera = renderer->GetActiveCamera();
+    auto * projection =
+        camera->GetCompositeProjectionTransformMatrix(renderer->GetTiledAspectRatio(), -1, 1);
+    auto transform = vtkSmartPointer<vtkMatrix4x4>::New();
+    std::vector<Selection::Part> parts;
+    vtkIdType total = 0;
+    QString listing;
+    for (auto & [id, block] : this->model->getBlocks()) {
+        if (!block->visible() || block->getUnstructuredGrid() == nullptr)
+            continue;
+
+        auto * matrix = block->getActor()->GetMatrix();
+        vtkMatrix4x4::Multiply4x4(projection, matrix, transform);
+        auto ids = getRegionIndex(id, cells)->query(transform, region);
+        if (ids.empty())
+            continue;
+
+        QStringList str_ids;
+        for (std::size_t i = 0; i < ids.size() && i < MAX_LISTED_IDS; i++)
+            str_ids << QString::number(ids[i]);
+        if (ids.size() > MAX_LISTED_IDS)
+            str_ids << "...";
+        listing += QString("\nBlock %1: %2").arg(id).arg(str_ids.join(", "));
+        total += ids.size();
+        parts.push_back({ block->getUnstructuredGrid(), std::move(ids), matrix });
+    }
+
+    if (cells)
+        this->selection->selectCells(parts);
+    else
+        this->selection->selectPoints(parts);
+    setSelectionProperties();
+
+    auto nfo = QString("%1: %2")
+                   .arg(cells ? "Elements" : "Nodes")
+                   .arg(QLocale::system().toString(total));
+    showSelectedMeshEntity(nfo + listing);
+}
+
+std::shared_ptr<RegionIndex>
+SelectTool::getRegionIndex(int block_id, bool cells)
+{
+    auto & indices = cells ? this->cell_indices : this->point_indices;
+    auto it = indices.find(block_id);
+    if (it != indices.end())
+        return it->second;
+
+    auto * grid = this->model->getBlock(block_id)->getUnstructuredGrid();
+    auto index = cells ? RegionIndex::fromCellCentroids(grid) : RegionIndex::fromPoints(grid);
+    indices[block_id] = index;
+    return index;
+}
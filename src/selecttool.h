@@ -4,6 +4,8 @@
 #pragma once
 
 #include <QObject>
+#include <map>
+#include "hoverpicker.h"
 
 class MainWindow;
 class Model;
@@ -16,6 +18,11 @@ class QActionGroup;
 class QSettings;
 class BlockObject;
 class Selection;
+class RegionIndex;
+class vtkPoints;
+class vtkCellArray;
+class vtkPolyData;
+class vtkActor2D;
 
 class SelectTool : public QObject {
 protected:
@@ -23,7 +30,9 @@ protected:
         MODE_SELECT_NONE = 0,
         MODE_SELECT_BLOCKS = 1,
         MODE_SELECT_CELLS = 2,
-        MODE_SELECT_POINTS = 3
+        MODE_SELECT_POINTS = 3,
+        MODE_SELECT_CELL_REGION = 4,
+        MODE_SELECT_POINT_REGION = 5
     };
 
 public:
@@ -35,6 +44,8 @@ public:
     void update();
     void clear();
     void saveSettings(QSettings * settings);
+    void onLeftButtonPress(const QPoint & pt, const Qt::KeyboardModifiers & mods);
+    void onLeftButtonRelease(const QPoint & pt);
     void onClicked(const QPoint & pt);
     void onMouseMove(const QPoint & pt);
     const std::shared_ptr<BlockObject> getSelectedBlock() const;
@@ -58,6 +69,28 @@ protected:
     void highlightCell(const QPoint & pt);
     void highlightPoint(const QPoint & pt);
     void setHighlightProperties();
+    /// Prepare a pick of the visible blocks at a screen position
+    ///
+    /// @return `false` if there is nothing to pick
+    bool preparePick(const QPoint & pt, HoverPicker::Request & request);
+    /// Pick a cell of the visible blocks
+    ///
+    /// @return `true` if a cell was picked
+    bool pickCell(const QPoint & pt, HoverPicker::Result & result);
+    void onHoverPicked(const HoverPicker::Result & result);
+    /// Select the picked cell or point (depending on the select mode)
+    void selectPicked(Selection * sel, const HoverPicker::Result & result);
+    /// Is a region (box or lasso) selection mode active
+    bool isRegionMode() const;
+    /// Extend the region being dragged to a screen position
+    void updateRegion(const QPoint & pt);
+    /// Get the polygon of the dragged region in display coordinates
+    std::vector<QPoint> getRegionPolygon() const;
+    void updateRubberBand();
+    /// Select cells or points of the visible blocks inside the dragged region
+    void selectRegion();
+    /// Get the index of cell centroids or points of a block (built on first use)
+    std::shared_ptr<RegionIndex> getRegionIndex(int block_id, bool cells);
 
     MainWindow * main_window;
     Model *& model;
@@ -71,6 +104,23 @@ protected:
     std::shared_ptr<BlockObject> selected_block;
     std::shared_ptr<Selection> highlight;
     std::shared_ptr<BlockObject> highlighted_block;
+    /// Picks cells and points under the mouse cursor
+    HoverPicker * hover_picker;
+    /// Is a region being dragged
+    bool dragging;
+    /// Is the dragged region a lasso (otherwise it is a box)
+    bool lasso;
+    /// Screen positions the region was dragged through
+    std::vector<QPoint> region_path;
+    /// Outline of the dragged region
+    vtkSmartPointer<vtkPoints> rubber_band_points;
+    vtkSmartPointer<vtkCellArray> rubber_band_lines;
+    vtkSmartPointer<vtkPolyData> rubber_band;
+    vtkSmartPointer<vtkActor2D> rubber_band_actor;
+    /// Indices of cell centroids per block id
+    std::map<int, std::shared_ptr<RegionIndex>> cell_indices;
+    /// Indices of points per block id
+    std::map<int, std::shared_ptr<RegionIndex>> point_indices;
 
 public:
     static QColor SELECTION_CLR;
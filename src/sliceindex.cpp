@@ -0,0 +1,156 @@
+// SPDX-FileCopyrightText: 2024 David Andrs <andrsd@gmail.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "sliceindex.h"
+#include "vtkUnstructuredGrid.h"
+#include "vtkIdList.h"
+#include "vtkMath.h"
+#include "vtkSMPTools.h"
+#include "vtkSMPThreadLocalObject.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+/// Tolerance of the comparison of normals
+const double NORMAL_TOLERANCE = 1e-12;
+
+} // namespace
+
+std::shared_ptr<SliceIndex>
+SliceIndex::fromCells(vtkUnstructuredGrid * grid, const double normal[3])
+{
+    double n[3] = { normal[0], normal[1], normal[2] };
+    vtkMath::Normalize(n);
+
+    // every point is projected once, not once per cell it belongs to
+    vtkIdType n_points = grid->GetNumberOfPoints();
+    std::vector<double> offsets(n_points);
+    vtkSMPTools::For(0, n_points, [&](vtkIdType begin, vtkIdType end) {
+        for (vtkIdType i = begin; i < end; i++) {
+            double x[3];
+            grid->GetPoint(i, x);
+            offsets[i] = vtkMath::Dot(n, x);
+        }
+    });
+
+    vtkIdType n_cells = grid->GetNumberOfCells();
+    std::vector<double> intervals(2 * n_cells);
+    vtkSMPThreadLocalObject<vtkIdList> cell_pts;
+    vtkSMPTools::For(0, n_cells, [&](vtkIdType begin, vtkIdType end) {
+        auto ids = cell_pts.Local();
+        for (vtkIdType i = begin; i < end; i++) {
+            vtkIdType npts;
+            const vtkIdType * pts;
+            grid->GetCellPoints(i, npts, pts, ids);
+            double lo = std::numeric_limits<double>::max();
+            double hi = std::numeric_limits<double>::lowest();
+            for (vtkIdType k = 0; k < npts; k++) {
+                lo = std::min(lo, offsets[pts[k]]);
+                hi = std::max(hi, offsets[pts[k]]);
+            }
+            intervals[2 * i] = lo;
+            intervals[2 * i + 1] = hi;
+        }
+    });
+    return std::make_shared<SliceIndex>(n, intervals);
+}
+
+SliceIndex::SliceIndex(const double normal[3], const std::vector<double> & intervals) :
+    normal { normal[0], normal[1], normal[2] },
+    n_cells(intervals.size() / 2),
+    n_buckets(1),
+    lowest(0.),
+    spacing(1.)
+{
+    double lo = std::numeric_limits<double>::max();
+    double hi = std::numeric_limits<double>::lowest();
+    double total_width = 0.;
+    vtkIdType n_valid = 0;
+    for (vtkIdType i = 0; i < this->n_cells; i++) {
+        if (intervals[2 * i] > intervals[2 * i + 1])
+            continue;
+        lo = std::min(lo, intervals[2 * i]);
+        hi = std::max(hi, intervals[2 * i + 1]);
+        total_width += intervals[2 * i + 1] - intervals[2 * i];
+        n_valid++;
+    }
+
+    // buckets as wide as an average cell, so that a cell is listed in about two of them
+    if (n_valid > 0) {
+        this->lowest = lo;
+        auto range = hi - lo;
+        if (range > 0.) {
+            auto width = total_width / n_valid;
+            auto n = width > 0. ? std::ceil(range / width) : (double) n_valid;
+            auto max_buckets = std::min<vtkIdType>(n_valid, std::numeric_limits<int>::max());
+            this->n_buckets = (int) std::clamp(n, 1., (double) max_buckets);
+            this->spacing = range / this->n_buckets;
+        }
+    }
+
+    auto bucket_of = [this](double offset) {
+        auto k = std::floor((offset - this->lowest) / this->spacing);
+        return (vtkIdType) std::clamp<double>(k, 0., this->n_buckets - 1);
+    };
+
+    // counting sort of cells by bucket, cells are visited by their ids, so buckets stay sorted
+    this->bucket_offsets.assign(this->n_buckets + 1, 0);
+    for (vtkIdType i = 0; i < this->n_cells; i++) {
+        if (intervals[2 * i] > intervals[2 * i + 1])
+            continue;
+        for (auto b = bucket_of(intervals[2 * i]); b <= bucket_of(intervals[2 * i + 1]); b++)
+            this->bucket_offsets[b + 1]++;
+    }
+    for (int b = 0; b < this->n_buckets; b++)
+        this->bucket_offsets[b + 1] += this->bucket_offsets[b];
+
+    auto n_entries = this->bucket_offsets[this->n_buckets];
+    this->ids.resize(n_entries);
+    this->intervals.resize(2 * n_entries);
+    std::vector<vtkIdType> pos(this->bucket_offsets.begin(), this->bucket_offsets.end() - 1);
+    for (vtkIdType i = 0; i < this->n_cells; i++) {
+        if (intervals[2 * i] > intervals[2 * i + 1])
+            continue;
+        for (auto b = bucket_of(intervals[2 * i]); b <= bucket_of(intervals[2 * i + 1]); b++) {
+            auto k = pos[b]++;
+            this->ids[k] = i;
+            this->intervals[2 * k] = intervals[2 * i];
+            this->intervals[2 * k + 1] = intervals[2 * i + 1];
+        }
+    }
+}
+
+vtkIdType
+SliceIndex::getNumberOfCells() const
+{
+    return this->n_cells;
+}
+
+bool
+SliceIndex::hasNormal(const double normal[3]) const
+{
+    double n[3] = { normal[0], normal[1], normal[2] };
+    if (vtkMath::Normalize(n) == 0.)
+        return false;
+    return std::abs(std::abs(vtkMath::Dot(n, this->normal)) - 1.) <= NORMAL_TOLERANCE;
+}
+
+std::vector<vtkIdType>
+SliceIndex::query(const double origin[3]) const
+{
+    std::vector<vtkIdType> cell_ids;
+    auto offset = vtkMath::Dot(this->normal, origin);
+    auto k = std::floor((offset - this->lowest) / this->spacing);
+    if (!(k >= 0. && k <= this->n_buckets))
+        return cell_ids;
+
+    // the highest offset belongs to the last bucket
+    auto b = std::min((vtkIdType) k, (vtkIdType) this->n_buckets - 1);
+    for (auto i = this->bucket_offsets[b]; i < this->bucket_offsets[b + 1]; i++) {
+        if (this->intervals[2 * i] <= offset && offset <= this->intervals[2 * i + 1])
+            cell_ids.push_back(this->ids[i]);
+    }
+    return cell_ids;
+}
@@ -0,0 +1,59 @@
+// SPDX-FileCopyrightText: 2024 David Andrs <andrsd@gmail.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <memory>
+#include <vector>
+#include "vtkType.h"
+
+class vtkUnstructuredGrid;
+
+/// Index of cells by their extent along a direction, answering which cells a plane cuts
+///
+/// Each cell is projected onto the normal of the planes, which gives the interval of plane offsets
+/// cutting the cell. The range of offsets is split into uniform buckets about as wide as an
+/// average cell and each cell is listed in all buckets its interval overlaps. A query tests only
+/// the cells of a single bucket, so moving a plane along its normal costs time proportional to the
+/// number of cells near the plane instead of the number of all cells.
+class SliceIndex {
+public:
+    /// Build the index of cells of an unstructured grid
+    ///
+    /// @param normal Normal of the planes, does not have to be of unit length
+    static std::shared_ptr<SliceIndex> fromCells(vtkUnstructuredGrid * grid,
+                                                 const double normal[3]);
+
+    /// @param normal Unit normal of the planes
+    /// @param intervals Lowest and highest offset (pairs) of planes cutting each cell, ordered by
+    ///        cell ids. Cells with the lowest offset above the highest one are never cut.
+    SliceIndex(const double normal[3], const std::vector<double> & intervals);
+
+    /// Get number of indexed cells
+    vtkIdType getNumberOfCells() const;
+
+    /// Check if the index can answer queries for planes with a normal
+    ///
+    /// @return `true` if the normal points in the direction of the index normal or the opposite one
+    bool hasNormal(const double normal[3]) const;
+
+    /// Find cells cut by the plane going through a point
+    ///
+    /// @return Sorted ids of cells cut by the plane with the index normal going through `origin`
+    std::vector<vtkIdType> query(const double origin[3]) const;
+
+protected:
+    double normal[3];
+    vtkIdType n_cells;
+    int n_buckets;
+    /// Offset of the start of the first bucket
+    double lowest;
+    /// Width of a bucket
+    double spacing;
+    /// Start of each bucket in `ids` and `intervals`
+    std::vector<vtkIdType> bucket_offsets;
+    /// Cell ids ordered by bucket (and by id in each bucket)
+    std::vector<vtkIdType> ids;
+    /// Intervals of cells in `ids` (pairs of the lowest and the highest offset)
+    std::vector<double> intervals;
+};
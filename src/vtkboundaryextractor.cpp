@@ -0,0 +1,514 @@
+// SPDX-FileCopyrightText: 2024 David Andrs <andrsd@gmail.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "vtkboundaryextractor.h"
+#include "vtkObjectFactory.h"
+#include "vtkInformation.h"
+#include "vtkInformationVector.h"
+#include "vtkUnstructuredGrid.h"
+#include "vtkPolyData.h"
+#include "vtkGeometryFilter.h"
+#include "vtkPoints.h"
+#include "vtkPointData.h"
+#include "vtkCellData.h"
+#include "vtkCellArray.h"
+#include "vtkCellType.h"
+#include "vtkIdList.h"
+#include "vtkIdTypeArray.h"
+#include "vtkUnsignedCharArray.h"
+#include "vtkSMPTools.h"
+#include "vtkSMPThreadLocal.h"
+#include "vtkSMPThreadLocalObject.h"
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+vtkStandardNewMacro(vtkBoundaryExtractor);
+
+namespace {
+
+const char * ORIGINAL_CELL_IDS = "vtkOriginalCellIds";
+const char * ORIGINAL_POINT_IDS = "vtkOriginalPointIds";
+
+/// Number of cells processed as one chunk
+const vtkIdType CHUNK_SIZE = 65536;
+/// Number of buckets faces are distributed into (by their smallest point id)
+const vtkIdType N_BUCKETS = 1024;
+/// Faces are encoded as `cell_id * MAX_FACES + face_index`
+const vtkIdType MAX_FACES = 8;
+
+/// Faces of a linear 3D cell (same ordering and orientation as VTK cells use)
+struct FaceTable {
+    int n_faces;
+    int sizes[6];
+    int pts[6][4];
+};
+
+// clang-format off
+const FaceTable TETRA_FACES = {
+    4, { 3, 3, 3, 3 },
+    { { 0, 1, 3 }, { 1, 2, 3 }, { 2, 0, 3 }, { 0, 2, 1 } }
+};
+const FaceTable HEX_FACES = {
+    6, { 4, 4, 4, 4, 4, 4 },
+    { { 0, 4, 7, 3 }, { 1, 2, 6, 5 }, { 0, 1, 5, 4 },
+      { 3, 7, 6, 2 }, { 0, 3, 2, 1 }, { 4, 5, 6, 7 } }
+};
+const FaceTable VOXEL_FACES = {
+    6, { 4, 4, 4, 4, 4, 4 },
+    { { 0, 4, 6, 2 }, { 1, 3, 7, 5 }, { 0, 1, 5, 4 },
+      { 2, 6, 7, 3 }, { 1, 0, 2, 3 }, { 4, 5, 7, 6 } }
+};
+const FaceTable WEDGE_FACES = {
+    5, { 3, 3, 4, 4, 4 },
+    { { 0, 1, 2 }, { 3, 5, 4 }, { 0, 3, 4, 1 }, { 1, 4, 5, 2 }, { 2, 5, 3, 0 } }
+};
+const FaceTable PYRAMID_FACES = {
+    5, { 4, 3, 3, 3, 3 },
+    { { 0, 3, 2, 1 }, { 0, 1, 4 }, { 1, 2, 4 }, { 2, 3, 4 }, { 3, 0, 4 } }
+};
+// clang-format on
+
+/// Get faces of a cell type
+///
+/// @return Faces of the cell type, `nullptr` if the cell type is not a linear 3D cell
+const FaceTable *
+getFaceTable(int cell_type)
+{
+    // clang-format off
+    switch (cell_type) {
+        case VTK_TETRA: return &TETRA_FACES;
+        case VTK_HEXAHEDRON: return &HEX_FACES;
+        case VTK_VOXEL: return &VOXEL_FACES;
+        case VTK_WEDGE: return &WEDGE_FACES;
+        case VTK_PYRAMID: return &PYRAMID_FACES;
+        default: return nullptr;
+    }
+    // clang-format on
+}
+
+/// Get the bucket of a face, given by its smallest point id, so that copies of a face shared by
+/// two cells end up in the same bucket
+vtkIdType
+getBucket(const FaceTable * table, int face, const vtkIdType * pts)
+{
+    auto min_id = pts[table->pts[face][0]];
+    for (int i = 1; i < table->sizes[face]; i++)
+        min_id = std::min(min_id, pts[table->pts[face][i]]);
+    return min_id % N_BUCKETS;
+}
+
+/// Face of a 3D cell
+struct Face {
+    /// Sorted point ids, unused entries are -1
+    vtkIdType key[4];
+    /// `cell_id * MAX_FACES + face_index`
+    vtkIdType code;
+
+    bool
+    operator<(const Face & other) const
+    {
+        return std::lexicographical_compare(this->key, this->key + 4, other.key, other.key + 4);
+    }
+
+    bool
+    hasSameKey(const Face & other) const
+    {
+        return std::equal(this->key, this->key + 4, other.key);
+    }
+};
+
+/// Cells collected by one thread
+struct LocalCells {
+    /// Codes of 2D cells
+    std::vector<vtkIdType> polys;
+    /// Ids of 1D cells
+    std::vector<vtkIdType> lines;
+    /// Ids of 0D cells
+    std::vector<vtkIdType> verts;
+    vtkSmartPointer<vtkIdList> ids;
+};
+
+/// Offsets and connectivity of output cells
+struct Cells {
+    vtkSmartPointer<vtkIdTypeArray> offsets;
+    vtkSmartPointer<vtkIdTypeArray> connectivity;
+};
+
+/// Build output cells from encoded faces and cells
+///
+/// @param input Input grid
+/// @param codes Encoded faces/cells
+/// @param scale `MAX_FACES` if codes encode faces, 1 if they are cell ids
+Cells
+buildCells(vtkUnstructuredGrid * input, const std::vector<vtkIdType> & codes, vtkIdType scale)
+{
+    vtkIdType n = codes.size();
+    auto offsets = vtkSmartPointer<vtkIdTypeArray>::New();
+    offsets->SetNumberOfValues(n + 1);
+    auto * off = offsets->GetPointer(0);
+    off[0] = 0;
+    vtkSMPTools::For(0, n, [&](vtkIdType begin, vtkIdType end) {
+        for (vtkIdType i = begin; i < end; i++) {
+            auto cell_id = codes[i] / scale;
+            auto * table = getFaceTable(input->GetCellType(cell_id));
+            if (table)
+                off[i + 1] = table->sizes[codes[i] % scale];
+            else
+                off[i + 1] = input->GetCellSize(cell_id);
+        }
+    });
+    for (vtkIdType i = 0; i < n; i++)
+        off[i + 1] += off[i];
+
+    auto connectivity = vtkSmartPointer<vtkIdTypeArray>::New();
+    connectivity->SetNumberOfValues(off[n]);
+    auto * conn = connectivity->GetPointer(0);
+    vtkSMPThreadLocalObject<vtkIdList> cell_pts;
+    vtkSMPTools::For(0, n, [&](vtkIdType begin, vtkIdType end) {
+        auto ids = cell_pts.Local();
+        for (vtkIdType i = begin; i < end; i++) {
+            auto cell_id = codes[i] / scale;
+            vtkIdType npts;
+            const vtkIdType * pts;
+            input->GetCellPoints(cell_id, npts, pts, ids);
+            auto * table = getFaceTable(input->GetCellType(cell_id));
+            auto * dst = conn + off[i];
+            if (table) {
+                auto face = codes[i] % scale;
+                for (int k = 0; k < table->sizes[face]; k++)
+                    dst[k] = pts[table->pts[face][k]];
+            }
+            else
+                std::copy(pts, pts + npts, dst);
+        }
+    });
+
+    return { offsets, connectivity };
+}
+
+vtkSmartPointer<vtkCellArray>
+createCellArray(const Cells & cells)
+{
+    auto cell_array = vtkSmartPointer<vtkCellArray>::New();
+    cell_array->SetData(cells.offsets, cells.connectivity);
+    return cell_array;
+}
+
+/// Create a list with ids 0, ..., n - 1
+vtkSmartPointer<vtkIdList>
+createIdentityList(vtkIdType n)
+{
+    auto ids = vtkSmartPointer<vtkIdList>::New();
+    ids->SetNumberOfIds(n);
+    std::iota(ids->GetPointer(0), ids->GetPointer(0) + n, 0);
+    return ids;
+}
+
+} // namespace
+
+vtkBoundaryExtractor::vtkBoundaryExtractor()
+{
+    this->Fallback = vtkSmartPointer<vtkGeometryFilter>::New();
+    this->Fallback->PassThroughCellIdsOn();
+    this->Fallback->SetOriginalCellIdsName(ORIGINAL_CELL_IDS);
+    this->Fallback->PassThroughPointIdsOn();
+    this->Fallback->SetOriginalPointIdsName(ORIGINAL_POINT_IDS);
+}
+
+vtkBoundaryExtractor::~vtkBoundaryExtractor() {}
+
+const char *
+vtkBoundaryExtractor::GetOriginalCellIdsName()
+{
+    return ORIGINAL_CELL_IDS;
+}
+
+const char *
+vtkBoundaryExtractor::GetOriginalPointIdsName()
+{
+    return ORIGINAL_POINT_IDS;
+}
+
+int
+vtkBoundaryExtractor::RequestData(vtkInformation * request,
+                                  vtkInformationVector ** inputVector,
+                                  vtkInformationVector * outputVector)
+{
+    // get the info objects
+    auto in_info = inputVector[0]->GetInformationObject(0);
+    auto out_info = outputVector->GetInformationObject(0);
+
+    // get the input and output
+    auto input = vtkDataSet::SafeDownCast(in_info->Get(vtkDataObject::DATA_OBJECT()));
+    auto output = vtkPolyData::SafeDownCast(out_info->Get(vtkDataObject::DATA_OBJECT()));
+
+    auto grid = vtkUnstructuredGrid::SafeDownCast(input);
+    if (grid != nullptr && IsSupported(grid)) {
+        ExtractBoundary(grid, output);
+    }
+    else {
+        vtkSmartPointer<vtkDataSet> copy;
+        copy.TakeReference(input->NewInstance());
+        copy->ShallowCopy(input);
+        this->Fallback->SetInputData(copy);
+        this->Fallback->Update();
+        output->ShallowCopy(this->Fallback->GetOutput());
+        this->Fallback->SetInputData(nullptr);
+    }
+
+    return 1;
+}
+
+int
+vtkBoundaryExtractor::FillInputPortInformation(int, vtkInformation * info)
+{
+    info->Set(vtkAlgorithm::INPUT_REQUIRED_DATA_TYPE(), "vtkDataSet");
+    return 1;
+}
+
+bool
+vtkBoundaryExtractor::IsSupported(vtkUnstructuredGrid * input)
+{
+    if (input->GetPoints() == nullptr)
+        return false;
+    if (input->GetCellGhostArray() != nullptr || input->GetPointGhostArray() != nullptr)
+        return false;
+
+    auto * types = input->GetDistinctCellTypesArray();
+    for (vtkIdType i = 0; i < types->GetNumberOfValues(); i++) {
+        switch (types->GetValue(i)) {
+            case VTK_EMPTY_CELL:
+            case VTK_VERTEX:
+            case VTK_POLY_VERTEX:
+            case VTK_LINE:
+            case VTK_POLY_LINE:
+            case VTK_TRIANGLE:
+            case VTK_QUAD:
+            case VTK_POLYGON:
+            case VTK_TETRA:
+            case VTK_HEXAHEDRON:
+            case VTK_VOXEL:
+            case VTK_WEDGE:
+            case VTK_PYRAMID:
+                break;
+            default:
+                return false;
+        }
+    }
+    return true;
+}
+
+void
+vtkBoundaryExtractor::ExtractBoundary(vtkUnstructuredGrid * input, vtkPolyData * output)
+{
+    vtkIdType n_pts = input->GetNumberOfPoints();
+    vtkIdType n_cells = input->GetNumberOfCells();
+    vtkIdType n_chunks = (n_cells + CHUNK_SIZE - 1) / CHUNK_SIZE;
+
+    // Faces of 3D cells are distributed into buckets by `getBucket`. Only face codes (8 bytes a
+    // face) are stored, they are counted first, so that they can be written into a single array,
+    // and the keys are rebuilt when a bucket is processed. Lower-dimensional cells are collected.
+    std::vector<vtkIdType> counts(n_chunks * N_BUCKETS, 0);
+    vtkSMPThreadLocal<LocalCells> locals;
+    vtkSMPTools::For(0, n_chunks, 1, [&](vtkIdType begin, vtkIdType end) {
+        auto & local = locals.Local();
+        if (local.ids == nullptr)
+            local.ids = vtkSmartPointer<vtkIdList>::New();
+
+        for (vtkIdType ch = begin; ch < end; ch++) {
+            auto * chunk_counts = &counts[ch * N_BUCKETS];
+            auto first = ch * CHUNK_SIZE;
+            auto last = std::min(first + CHUNK_SIZE, n_cells);
+            for (vtkIdType cell_id = first; cell_id < last; cell_id++) {
+                int cell_type = input->GetCellType(cell_id);
+                if (auto * table = getFaceTable(cell_type)) {
+                    vtkIdType npts;
+                    const vtkIdType * pts;
+                    input->GetCellPoints(cell_id, npts, pts, local.ids);
+                    for (int f = 0; f < table->n_faces; f++)
+                        chunk_counts[getBucket(table, f, pts)]++;
+                }
+                else if (cell_type == VTK_TRIANGLE || cell_type == VTK_QUAD ||
+                         cell_type == VTK_POLYGON)
+                    local.polys.push_back(cell_id * MAX_FACES);
+                else if (cell_type == VTK_LINE || cell_type == VTK_POLY_LINE)
+                    local.lines.push_back(cell_id);
+                else if (cell_type == VTK_VERTEX || cell_type == VTK_POLY_VERTEX)
+                    local.verts.push_back(cell_id);
+            }
+        }
+    });
+
+    // faces are ordered by bucket and by chunk in each bucket, `counts` become start positions
+    std::vector<vtkIdType> bucket_offsets(N_BUCKETS + 1, 0);
+    vtkIdType n_faces = 0;
+    for (vtkIdType b = 0; b < N_BUCKETS; b++) {
+        bucket_offsets[b] = n_faces;
+        for (vtkIdType ch = 0; ch < n_chunks; ch++) {
+            auto count = counts[ch * N_BUCKETS + b];
+            counts[ch * N_BUCKETS + b] = n_faces;
+            n_faces += count;
+        }
+    }
+    bucket_offsets[N_BUCKETS] = n_faces;
+
+    std::vector<vtkIdType> face_codes(n_faces);
+    vtkSMPThreadLocalObject<vtkIdList> cell_pts;
+    vtkSMPTools::For(0, n_chunks, 1, [&](vtkIdType begin, vtkIdType end) {
+        auto ids = cell_pts.Local();
+
+        for (vtkIdType ch = begin; ch < end; ch++) {
+            auto * pos = &counts[ch * N_BUCKETS];
+            auto first = ch * CHUNK_SIZE;
+            auto last = std::min(first + CHUNK_SIZE, n_cells);
+            for (vtkIdType cell_id = first; cell_id < last; cell_id++) {
+                if (auto * table = getFaceTable(input->GetCellType(cell_id))) {
+                    vtkIdType npts;
+                    const vtkIdType * pts;
+                    input->GetCellPoints(cell_id, npts, pts, ids);
+                    for (int f = 0; f < table->n_faces; f++)
+                        face_codes[pos[getBucket(table, f, pts)]++] = cell_id * MAX_FACES + f;
+                }
+            }
+        }
+    });
+    std::vector<vtkIdType>().swap(counts);
+
+    std::vector<LocalCells *> all_locals;
+    for (auto & local : locals)
+        all_locals.push_back(&local);
+
+    // faces that appear only once in a bucket are on the boundary
+    std::vector<std::vector<vtkIdType>> boundary(N_BUCKETS);
+    vtkSMPTools::For(0, N_BUCKETS, 1, [&](vtkIdType begin, vtkIdType end) {
+        auto ids = cell_pts.Local();
+        std::vector<Face> faces;
+        for (vtkIdType b = begin; b < end; b++) {
+            faces.clear();
+            for (auto k = bucket_offsets[b]; k < bucket_offsets[b + 1]; k++) {
+                auto cell_id = face_codes[k] / MAX_FACES;
+                int f = face_codes[k] % MAX_FACES;
+                auto * table = getFaceTable(input->GetCellType(cell_id));
+                vtkIdType npts;
+                const vtkIdType * pts;
+                input->GetCellPoints(cell_id, npts, pts, ids);
+
+                Face face;
+                int n = table->sizes[f];
+                for (int i = 0; i < 4; i++)
+                    face.key[i] = i < n ? pts[table->pts[f][i]] : -1;
+                std::sort(face.key, face.key + n);
+                face.code = face_codes[k];
+                faces.push_back(face);
+            }
+            std::sort(faces.begin(), faces.end());
+            for (std::size_t i = 0; i < faces.size();) {
+                auto j = i + 1;
+                while (j < faces.size() && faces[j].hasSameKey(faces[i]))
+                    j++;
+                if (j - i == 1)
+                    boundary[b].push_back(faces[i].code);
+                i = j;
+            }
+        }
+    });
+    std::vector<vtkIdType>().swap(face_codes);
+
+    // output cells are ordered by the input cells they come from
+    std::vector<vtkIdType> poly_codes;
+    std::vector<vtkIdType> line_ids;
+    std::vector<vtkIdType> vert_ids;
+    for (auto & codes : boundary)
+        poly_codes.insert(poly_codes.end(), codes.begin(), codes.end());
+    boundary.clear();
+    for (auto * local : all_locals) {
+        poly_codes.insert(poly_codes.end(), local->polys.begin(), local->polys.end());
+        line_ids.insert(line_ids.end(), local->lines.begin(), local->lines.end());
+        vert_ids.insert(vert_ids.end(), local->verts.begin(), local->verts.end());
+    }
+    vtkSMPTools::Sort(poly_codes.begin(), poly_codes.end());
+    vtkSMPTools::Sort(line_ids.begin(), line_ids.end());
+    vtkSMPTools::Sort(vert_ids.begin(), vert_ids.end());
+
+    auto verts = buildCells(input, vert_ids, 1);
+    auto lines = buildCells(input, line_ids, 1);
+    auto polys = buildCells(input, poly_codes, MAX_FACES);
+
+    // renumber points compactly, keeping their order
+    std::vector<vtkIdType> point_map(n_pts, -1);
+    vtkIdTypeArray * connectivities[] = { verts.connectivity,
+                                          lines.connectivity,
+                                          polys.connectivity };
+    for (auto * conn : connectivities) {
+        for (vtkIdType i = 0; i < conn->GetNumberOfValues(); i++)
+            point_map[conn->GetValue(i)] = 0;
+    }
+    auto src_pts = vtkSmartPointer<vtkIdList>::New();
+    vtkIdType n_new_pts = 0;
+    for (vtkIdType i = 0; i < n_pts; i++) {
+        if (point_map[i] == 0) {
+            point_map[i] = n_new_pts++;
+            src_pts->InsertNextId(i);
+        }
+    }
+    for (auto * conn : connectivities) {
+        auto * ids = conn->GetPointer(0);
+        vtkSMPTools::For(0, conn->GetNumberOfValues(), [&](vtkIdType begin, vtkIdType end) {
+            for (vtkIdType i = begin; i < end; i++)
+                ids[i] = point_map[ids[i]];
+        });
+    }
+
+    auto dst_pts = createIdentityList(n_new_pts);
+    auto new_pts = vtkSmartPointer<vtkPoints>::New();
+    new_pts->SetDataType(input->GetPoints()->GetDataType());
+    new_pts->InsertPoints(dst_pts, src_pts, input->GetPoints());
+    output->SetPoints(new_pts);
+
+    auto in_pd = input->GetPointData();
+    auto out_pd = output->GetPointData();
+    out_pd->CopyAllocate(in_pd, n_new_pts);
+    out_pd->CopyData(in_pd, src_pts, dst_pts);
+
+    auto orig_pt_ids = vtkSmartPointer<vtkIdTypeArray>::New();
+    orig_pt_ids->SetName(ORIGINAL_POINT_IDS);
+    orig_pt_ids->SetNumberOfValues(n_new_pts);
+    std::copy(src_pts->GetPointer(0),
+              src_pts->GetPointer(0) + n_new_pts,
+              orig_pt_ids->GetPointer(0));
+    out_pd->AddArray(orig_pt_ids);
+
+    // polydata cells are ordered verts, lines, polys
+    vtkIdType n_verts = vert_ids.size();
+    vtkIdType n_lines = line_ids.size();
+    vtkIdType n_polys = poly_codes.size();
+    if (n_verts > 0)
+        output->SetVerts(createCellArray(verts));
+    if (n_lines > 0)
+        output->SetLines(createCellArray(lines));
+    if (n_polys > 0)
+        output->SetPolys(createCellArray(polys));
+
+    vtkIdType n_out_cells = n_verts + n_lines + n_polys;
+    auto src_cells = vtkSmartPointer<vtkIdList>::New();
+    src_cells->SetNumberOfIds(n_out_cells);
+    auto * src = src_cells->GetPointer(0);
+    std::copy(vert_ids.begin(), vert_ids.end(), src);
+    std::copy(line_ids.begin(), line_ids.end(), src + n_verts);
+    vtkSMPTools::For(0, n_polys, [&](vtkIdType begin, vtkIdType end) {
+        for (vtkIdType i = begin; i < end; i++)
+            src[n_verts + n_lines + i] = poly_codes[i] / MAX_FACES;
+    });
+
+    auto in_cd = input->GetCellData();
+    auto out_cd = output->GetCellData();
+    out_cd->CopyAllocate(in_cd, n_out_cells);
+    out_cd->CopyData(in_cd, src_cells, createIdentityList(n_out_cells));
+
+    auto orig_ids = vtkSmartPointer<vtkIdTypeArray>::New();
+    orig_ids->SetName(ORIGINAL_CELL_IDS);
+    orig_ids->SetNumberOfValues(n_out_cells);
+    std::copy(src, src + n_out_cells, orig_ids->GetPointer(0));
+    out_cd->AddArray(orig_ids);
+}
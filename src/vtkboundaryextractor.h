@@ -0,0 +1,55 @@
+// SPDX-FileCopyrightText: 2024 David Andrs <andrsd@gmail.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include "vtkPolyDataAlgorithm.h"
+#include "vtkSmartPointer.h"
+
+class vtkInformation;
+class vtkInformationVector;
+class vtkUnstructuredGrid;
+class vtkPolyData;
+class vtkGeometryFilter;
+
+/// Extract the boundary surface of a data set
+///
+/// Faces of linear 3D cells of an unstructured grid are hashed in parallel and only faces that
+/// are not shared by two cells are kept. 2D, 1D and 0D cells are passed to the output as they are.
+/// Output points are compactly renumbered and their input ids are stored in the
+/// `vtkOriginalPointIds` point array. Cell data is copied from the cell that a face belongs to and
+/// the id of that cell is stored in the `vtkOriginalCellIds` cell array.
+///
+/// Other inputs (non-linear cells, polyhedra, ghost cells, other data set types) are handled by
+/// `vtkGeometryFilter`, which also produces both id arrays.
+class vtkBoundaryExtractor : public vtkPolyDataAlgorithm {
+public:
+    vtkTypeMacro(vtkBoundaryExtractor, vtkPolyDataAlgorithm);
+
+    static vtkBoundaryExtractor * New();
+
+    /// Name of the cell array with ids of the input cells
+    static const char * GetOriginalCellIdsName();
+    /// Name of the point array with ids of the input points
+    static const char * GetOriginalPointIdsName();
+
+protected:
+    vtkBoundaryExtractor();
+    ~vtkBoundaryExtractor() override;
+
+    int RequestData(vtkInformation * request,
+                    vtkInformationVector ** inputVector,
+                    vtkInformationVector * outputVector) override;
+    int FillInputPortInformation(int port, vtkInformation * info) override;
+
+    /// Query if the unstructured grid can be processed by `ExtractBoundary`
+    static bool IsSupported(vtkUnstructuredGrid * input);
+    void ExtractBoundary(vtkUnstructuredGrid * input, vtkPolyData * output);
+
+    /// Used for inputs that are not supported
+    vtkSmartPointer<vtkGeometryFilter> Fallback;
+
+private:
+    vtkBoundaryExtractor(const vtkBoundaryExtractor &) = delete;
+    void operator=(const vtkBoundaryExtractor &) = delete;
+};
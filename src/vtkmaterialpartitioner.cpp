@@ -0,0 +1,254 @@
+// SPDX-FileCopyrightText: 2024 David Andrs <andrsd@gmail.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "vtkmaterialpartitioner.h"
+#include "vtkObjectFactory.h"
+#include "vtkInformation.h"
+#include "vtkInformationVector.h"
+#include "vtkMultiBlockDataSet.h"
+#include "vtkDataSet.h"
+#include "vtkPointSet.h"
+#include "vtkPoints.h"
+#include "vtkCellData.h"
+#include "vtkCellArray.h"
+#include "vtkIdList.h"
+#include "vtkIdTypeArray.h"
+#include "vtkUnsignedCharArray.h"
+#include "vtkUnstructuredGrid.h"
+#include "vtkSMPTools.h"
+#include "vtkSMPThreadLocal.h"
+#include "vtkSMPThreadLocalObject.h"
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
+vtkStandardNewMacro(vtkMaterialPartitioner);
+
+namespace {
+
+/// Number of cells processed as one chunk
+const vtkIdType CHUNK_SIZE = 65536;
+
+} // namespace
+
+vtkMaterialPartitioner::vtkMaterialPartitioner()
+{
+    this->FieldName = "MaterialIds";
+}
+
+vtkMaterialPartitioner::~vtkMaterialPartitioner() {}
+
+void
+vtkMaterialPartitioner::SetFieldName(const std::string & name)
+{
+    if (this->FieldName != name) {
+        this->FieldName = name;
+        this->Modified();
+    }
+}
+
+vtkUnstructuredGrid *
+vtkMaterialPartitioner::GetMaterialBlock(int materialId)
+{
+    auto it = this->BlockIndex.find(materialId);
+    if (it == this->BlockIndex.end())
+        return nullptr;
+    auto output = vtkMultiBlockDataSet::SafeDownCast(this->GetOutputDataObject(0));
+    if (output == nullptr)
+        return nullptr;
+    return vtkUnstructuredGrid::SafeDownCast(output->GetBlock(it->second));
+}
+
+int
+vtkMaterialPartitioner::RequestData(vtkInformation * request,
+                                    vtkInformationVector ** inputVector,
+                                    vtkInformationVector * outputVector)
+{
+    // get the info objects
+    auto in_info = inputVector[0]->GetInformationObject(0);
+    auto out_info = outputVector->GetInformationObject(0);
+
+    // get the input and output
+    auto input = vtkDataSet::SafeDownCast(in_info->Get(vtkDataObject::DATA_OBJECT()));
+    auto output = vtkMultiBlockDataSet::SafeDownCast(out_info->Get(vtkDataObject::DATA_OBJECT()));
+
+    this->BlockIndex.clear();
+
+    auto cd = input->GetCellData();
+    auto mat_ids = cd->GetArray(this->FieldName.c_str());
+    if (mat_ids == nullptr) {
+        vtkErrorMacro("Cell array '" << this->FieldName << "' not found");
+        return 0;
+    }
+
+    vtkIdType n_pts = input->GetNumberOfPoints();
+    vtkIdType n_cells = input->GetNumberOfCells();
+    vtkIdType n_chunks = (n_cells + CHUNK_SIZE - 1) / CHUNK_SIZE;
+
+    // material id of each cell and distinct material ids of each chunk
+    std::vector<int> cell_mat(n_cells);
+    std::vector<std::vector<int>> chunk_mats(n_chunks);
+    vtkSMPTools::For(0, n_chunks, 1, [&](vtkIdType begin, vtkIdType end) {
+        for (vtkIdType ch = begin; ch < end; ch++) {
+            auto first = ch * CHUNK_SIZE;
+            auto last = std::min(first + CHUNK_SIZE, n_cells);
+            for (vtkIdType i = first; i < last; i++)
+                cell_mat[i] = (int) mat_ids->GetComponent(i, 0);
+            auto & mats = chunk_mats[ch];
+            mats.assign(cell_mat.begin() + first, cell_mat.begin() + last);
+            std::sort(mats.begin(), mats.end());
+            mats.erase(std::unique(mats.begin(), mats.end()), mats.end());
+        }
+    });
+
+    std::vector<int> materials;
+    for (auto & mats : chunk_mats) {
+        std::vector<int> merged;
+        std::set_union(materials.begin(),
+                       materials.end(),
+                       mats.begin(),
+                       mats.end(),
+                       std::back_inserter(merged));
+        materials.swap(merged);
+    }
+    vtkIdType n_mats = materials.size();
+
+    // counting sort of cells by material: count cells per (chunk, material), then scatter cell ids
+    // so that cells of each material are contiguous and keep their order
+    std::vector<vtkIdType> counts(n_chunks * n_mats, 0);
+    vtkSMPTools::For(0, n_chunks, 1, [&](vtkIdType begin, vtkIdType end) {
+        for (vtkIdType ch = begin; ch < end; ch++) {
+            auto first = ch * CHUNK_SIZE;
+            auto last = std::min(first + CHUNK_SIZE, n_cells);
+            auto * cnt = counts.data() + ch * n_mats;
+            for (vtkIdType i = first; i < last; i++) {
+                auto k = std::lower_bound(materials.begin(), materials.end(), cell_mat[i]) -
+                         materials.begin();
+                cell_mat[i] = k;
+                cnt[k]++;
+            }
+        }
+    });
+
+    std::vector<vtkIdType> mat_offsets(n_mats + 1, 0);
+    vtkIdType running = 0;
+    for (vtkIdType k = 0; k < n_mats; k++) {
+        mat_offsets[k] = running;
+        for (vtkIdType ch = 0; ch < n_chunks; ch++) {
+            auto n = counts[ch * n_mats + k];
+            counts[ch * n_mats + k] = running;
+            running += n;
+        }
+    }
+    mat_offsets[n_mats] = running;
+
+    std::vector<vtkIdType> order(n_cells);
+    vtkSMPTools::For(0, n_chunks, 1, [&](vtkIdType begin, vtkIdType end) {
+        for (vtkIdType ch = begin; ch < end; ch++) {
+            auto first = ch * CHUNK_SIZE;
+            auto last = std::min(first + CHUNK_SIZE, n_cells);
+            auto * pos = counts.data() + ch * n_mats;
+            for (vtkIdType i = first; i < last; i++)
+                order[pos[cell_mat[i]]++] = i;
+        }
+    });
+
+    // build the grids, one material per task
+    // make the first cell queries from this thread, so that lazily built cell structures exist
+    // before the workers use them
+    if (n_cells > 0) {
+        auto ids = vtkSmartPointer<vtkIdList>::New();
+        input->GetCellType(0);
+        input->GetCellPoints(0, ids);
+    }
+
+    int points_type = VTK_DOUBLE;
+    if (auto ps = vtkPointSet::SafeDownCast(input))
+        if (ps->GetPoints())
+            points_type = ps->GetPoints()->GetDataType();
+
+    std::vector<vtkSmartPointer<vtkUnstructuredGrid>> grids(n_mats);
+    // maps old point ids into new, entries are reset to -1 after each material
+    vtkSMPThreadLocal<std::vector<vtkIdType>> point_maps;
+    vtkSMPThreadLocalObject<vtkIdList> cell_pts;
+    vtkSMPTools::For(0, n_mats, 1, [&](vtkIdType begin, vtkIdType end) {
+        auto & point_map = point_maps.Local();
+        if (point_map.empty())
+            point_map.assign(n_pts, -1);
+        auto ids = cell_pts.Local();
+
+        for (vtkIdType k = begin; k < end; k++) {
+            auto first = mat_offsets[k];
+            auto n = mat_offsets[k + 1] - first;
+
+            auto offsets = vtkSmartPointer<vtkIdTypeArray>::New();
+            offsets->SetNumberOfValues(n + 1);
+            auto types = vtkSmartPointer<vtkUnsignedCharArray>::New();
+            types->SetNumberOfValues(n);
+            std::vector<vtkIdType> conn;
+            std::vector<vtkIdType> old_ids;
+            for (vtkIdType j = 0; j < n; j++) {
+                auto cell_id = order[first + j];
+                input->GetCellPoints(cell_id, ids);
+                types->SetValue(j, input->GetCellType(cell_id));
+                offsets->SetValue(j, conn.size());
+                for (vtkIdType i = 0; i < ids->GetNumberOfIds(); i++) {
+                    auto pt_id = ids->GetId(i);
+                    if (point_map[pt_id] < 0) {
+                        point_map[pt_id] = old_ids.size();
+                        old_ids.push_back(pt_id);
+                    }
+                    conn.push_back(point_map[pt_id]);
+                }
+            }
+            offsets->SetValue(n, conn.size());
+
+            auto connectivity = vtkSmartPointer<vtkIdTypeArray>::New();
+            connectivity->SetNumberOfValues(conn.size());
+            std::copy(conn.begin(), conn.end(), connectivity->GetPointer(0));
+            auto cells = vtkSmartPointer<vtkCellArray>::New();
+            cells->SetData(offsets, connectivity);
+
+            auto new_pts = vtkSmartPointer<vtkPoints>::New();
+            new_pts->SetDataType(points_type);
+            new_pts->SetNumberOfPoints(old_ids.size());
+            for (std::size_t i = 0; i < old_ids.size(); i++) {
+                double x[3];
+                input->GetPoint(old_ids[i], x);
+                new_pts->SetPoint(i, x);
+                point_map[old_ids[i]] = -1;
+            }
+
+            auto grid = vtkSmartPointer<vtkUnstructuredGrid>::New();
+            grid->SetPoints(new_pts);
+            grid->SetCells(types, cells);
+
+            // As this filter is doing a subsetting operation, set the Copy Tuple flag
+            // for GlobalIds array so that, if present, it will be copied to the output.
+            auto output_cd = grid->GetCellData();
+            output_cd->CopyGlobalIdsOn();
+            output_cd->CopyAllocate(cd, n);
+            for (vtkIdType j = 0; j < n; j++)
+                output_cd->CopyData(cd, order[first + j], j);
+            output_cd->Squeeze();
+
+            grids[k] = grid;
+        }
+    });
+
+    output->SetNumberOfBlocks(n_mats);
+    for (vtkIdType k = 0; k < n_mats; k++) {
+        output->SetBlock(k, grids[k]);
+        output->GetMetaData(k)->Set(vtkCompositeDataSet::NAME(), std::to_string(materials[k]));
+        this->BlockIndex[materials[k]] = k;
+    }
+
+    return 1;
+}
+
+int
+vtkMaterialPartitioner::FillInputPortInformation(int, vtkInformation * info)
+{
+    info->Set(vtkAlgorithm::INPUT_REQUIRED_DATA_TYPE(), "vtkDataSet");
+    return 1;
+}
@@ -0,0 +1,50 @@
+// SPDX-FileCopyrightText: 2024 David Andrs <andrsd@gmail.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include "vtkMultiBlockDataSetAlgorithm.h"
+#include <map>
+#include <string>
+
+class vtkInformation;
+class vtkInformationVector;
+class vtkUnstructuredGrid;
+
+/// Split a data set into unstructured grids by material id
+///
+/// Cells are bucketed by the value of the material id cell array in a single (parallel) pass.
+/// The output has one block per material id present in the input, ordered by material id. Each
+/// block has its own compactly numbered points and a copy of the cell data.
+class vtkMaterialPartitioner : public vtkMultiBlockDataSetAlgorithm {
+public:
+    vtkTypeMacro(vtkMaterialPartitioner, vtkMultiBlockDataSetAlgorithm);
+
+    static vtkMaterialPartitioner * New();
+
+    /// Set the name of the cell array with material ids (`MaterialIds` by default)
+    void SetFieldName(const std::string & name);
+
+    /// Get the grid of a material
+    ///
+    /// @param materialId Material id
+    /// @return Grid with the cells of the material, `nullptr` if there are no such cells
+    vtkUnstructuredGrid * GetMaterialBlock(int materialId);
+
+protected:
+    vtkMaterialPartitioner();
+    ~vtkMaterialPartitioner() override;
+
+    int RequestData(vtkInformation * request,
+                    vtkInformationVector ** inputVector,
+                    vtkInformationVector * outputVector) override;
+    int FillInputPortInformation(int port, vtkInformation * info) override;
+
+    std::string FieldName;
+    /// Material id -> output block index
+    std::map<int, unsigned int> BlockIndex;
+
+private:
+    vtkMaterialPartitioner(const vtkMaterialPartitioner &) = delete;
+    void operator=(const vtkMaterialPartitioner &) = delete;
+};
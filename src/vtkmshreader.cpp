@@ -15,6 +15,14 @@
 #include "vtkDataSetAttributes.h"
 #include "vtkStringArray.h"
 #include "vtkUnstructuredGrid.h"
+#include "vtkCellArray.h"
+#include "vtkBoundingBox.h"
+#include "vtkIdTypeArray.h"
+#include "vtkDoubleArray.h"
+#include "vtkSMPTools.h"
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
 
 vtkObjectFactoryNewMacro(vtkMshReader);
 
@@ -74,6 +82,12 @@ vtkMshReader::SetFileName(VTK_FILEPATH const char * fname)
     }
 }
 
+void
+vtkMshReader::SetBlockReadyCallback(BlockReadyCallback callback)
+{
+    this->BlockReady = callback;
+}
+
 int
 vtkMshReader::GetDimensionality()
 {
@@ -189,6 +203,10 @@ vtkMshReader::RequestInformation(vtkInformation * vtkNotUsed(request),
 
     try {
         this->Msh = new gmshparsercpp::MshFile(this->FileName);
+        this->Msh->set_num_threads(std::thread::hardware_concurrency());
+        this->Msh->set_progress_callback([this](std::size_t bytesRead, std::size_t fileSize) {
+            this->UpdateProgress((double) bytesRead / fileSize);
+        });
         this->Msh->parse();
         ProcessMsh();
 
@@ -254,17 +272,21 @@ vtkMshReader::RequestData(vtkInformation * vtkNotUsed(request),
         else if ((int) this->Msh->get_version() == 2) {
             for (int dim = this->Dimension; dim > 0; dim--) {
                 for (auto & blk : this->ElemBlkByDim[dim]) {
-                    physBlocksByDim[dim][blk->tag].push_back(blk->tag);
+                    auto & blockIds = physBlocksByDim[dim][blk->tag];
+                    if (blockIds.empty())
+                        blockIds.push_back(blk->tag);
                 }
             }
         }
 
-        // Map: { dim -> { blokId -> ElementBlock }}
-        std::map<int, std::map<int, const gmshparsercpp::MshFile::ElementBlock *>> blocksByDimById;
+        // Map: { dim -> { blokId -> [ElementBlock, ...] }}
+        // NOTE: blocks are homogeneous, so one id can map to several blocks (one per element type)
+        std::map<int, std::map<int, std::vector<const gmshparsercpp::MshFile::ElementBlock *>>>
+            blocksByDimById;
         for (int dim = this->Dimension; dim > 0; dim--) {
             for (auto & blk : this->ElemBlkByDim[dim]) {
                 auto id = blk->tag;
-                blocksByDimById[dim][id] = blk;
+                blocksByDimById[dim][id].push_back(blk);
             }
         }
 
@@ -274,34 +296,76 @@ vtkMshReader::RequestData(vtkInformation * vtkNotUsed(request),
         std::array<int, nBlockTypes> dims = { this->Dimension, this->Dimension - 1 };
         output->SetNumberOfBlocks(nBlockTypes);
 
+        // collect the groups first, so their grids can be built concurrently
+        struct Group {
+            int blockType;
+            int objectIndex;
+            std::string name;
+            std::vector<const gmshparsercpp::MshFile::ElementBlock *> blocks;
+            vtkSmartPointer<vtkUnstructuredGrid> grid;
+        };
+        std::vector<Group> groups;
         for (int i = 0; i < nBlockTypes; i++) {
             ObjectType objType = objTypes[i];
             int dim = dims[i];
-
-            auto mbds = vtkSmartPointer<vtkMultiBlockDataSet>::New();
-            mbds->SetNumberOfBlocks(physBlocksByDim[dim].size());
-            output->SetBlock(i, mbds);
-            output->GetMetaData(i)->Set(vtkCompositeDataSet::NAME(), conn_types_names[i]);
-            mbds->FastDelete();
-
-            long idx = 0;
             for (auto & [physId, blockIds] : physBlocksByDim[dim]) {
                 std::vector<const gmshparsercpp::MshFile::ElementBlock *> blocks;
                 for (auto & blkId : blockIds) {
-                    if (blocksByDimById[dim].count(blkId) == 1)
-                        blocks.push_back(blocksByDimById[dim][blkId]);
+                    auto it = blocksByDimById[dim].find(blkId);
+                    if (it != blocksByDimById[dim].end())
+                        blocks.insert(blocks.end(), it->second.begin(), it->second.end());
                 }
 
                 if (!blocks.empty()) {
                     std::string blockName = GetMshPhysBlockName(physId);
+                    int objIdx = this->ObjectIds[objType].size();
                     this->ObjectIds[objType].push_back(physId);
                     this->ObjectNames[objType].push_back(blockName);
+                    groups.push_back({ i, objIdx, blockName, blocks, {} });
+                }
+            }
+        }
 
-                    auto ug = CreateUnstructuredGrid(blocks);
-                    mbds->SetBlock(idx, ug);
-                    mbds->GetMetaData(idx)->Set(vtkCompositeDataSet::NAME(), blockName);
-                    ug->FastDelete();
+        // Large groups use the dense point map one after another, the rest is built in parallel
+        auto nPoints = this->AllPoints->GetNumberOfPoints();
+        std::vector<std::size_t> smallGroups;
+        for (std::size_t i = 0; i < groups.size(); i++) {
+            std::size_t connSize = 0;
+            for (auto & blk : groups[i].blocks)
+                connSize += blk->connectivity.size();
+            if (connSize * 8 >= (std::size_t) nPoints) {
+                groups[i].grid.TakeReference(
+                    CreateUnstructuredGrid(groups[i].blocks, &this->PointMap));
+                if (this->BlockReady)
+                    this->BlockReady(objTypes[groups[i].blockType],
+                                     groups[i].objectIndex,
+                                     groups[i].grid);
+            }
+            else
+                smallGroups.push_back(i);
+        }
+        vtkSMPTools::For(0, smallGroups.size(), 1, [&](vtkIdType begin, vtkIdType end) {
+            for (vtkIdType i = begin; i < end; i++) {
+                auto & grp = groups[smallGroups[i]];
+                grp.grid.TakeReference(CreateUnstructuredGrid(grp.blocks, nullptr));
+                if (this->BlockReady)
+                    this->BlockReady(objTypes[grp.blockType], grp.objectIndex, grp.grid);
+            }
+        });
 
+        for (int i = 0; i < nBlockTypes; i++) {
+            auto mbds = vtkSmartPointer<vtkMultiBlockDataSet>::New();
+            mbds->SetNumberOfBlocks(std::count_if(groups.begin(), groups.end(), [i](auto & grp) {
+                return grp.blockType == i;
+            }));
+            output->SetBlock(i, mbds);
+            output->GetMetaData(i)->Set(vtkCompositeDataSet::NAME(), conn_types_names[i]);
+
+            unsigned int idx = 0;
+            for (auto & grp : groups) {
+                if (grp.blockType == i) {
+                    mbds->SetBlock(idx, grp.grid);
+                    mbds->GetMetaData(idx)->Set(vtkCompositeDataSet::NAME(), grp.name);
                     idx++;
                 }
             }
@@ -340,19 +404,26 @@ vtkMshReader::ProcessMsh()
     for (const auto & eb : this->Msh->get_element_blocks())
         this->ElemBlkByDim[eb.dimension].push_back(&eb);
 
+    auto maxNodeTag = this->Msh->get_max_node_tag();
+    for (const auto & eb : this->Msh->get_element_blocks()) {
+        for (auto & nid : eb.connectivity)
+            if (nid < 0 || nid > maxNodeTag || this->TagToPoint[nid] < 0)
+                throw std::domain_error("Element references non-existent node " +
+                                        std::to_string(nid));
+    }
+    this->PointMap.assign(this->AllPoints->GetNumberOfPoints(), -1);
+
     // count total number of elements and nodes
-    std::map<int, int> nodeCnt;
+    std::vector<char> nodeUsed(this->AllPoints->GetNumberOfPoints(), 0);
     this->TotalNumOfElems = 0;
     if (this->Dimension >= 0) {
         for (const auto & eb : this->ElemBlkByDim[this->Dimension]) {
-            this->TotalNumOfElems += eb->elements.size();
-            for (auto & e : eb->elements) {
-                for (auto & nid : e.node_tags)
-                    nodeCnt[nid]++;
-            }
+            this->TotalNumOfElems += eb->size();
+            for (auto & nid : eb->connectivity)
+                nodeUsed[this->TagToPoint[nid]] = 1;
         }
     }
-    this->TotalNumOfNodes = nodeCnt.size();
+    this->TotalNumOfNodes = std::count(nodeUsed.begin(), nodeUsed.end(), 1);
 }
 
 void
@@ -366,16 +437,29 @@ vtkMshReader::ReadPhysicalEntities()
 void
 vtkMshReader::BuildCoordinates()
 {
-    this->AllPoints = vtkSmartPointer<vtkPoints>::New();
+    vtkIdType nPoints = 0;
+    for (const auto & nd : this->Msh->get_nodes())
+        nPoints += nd.size();
+
+    // points are stored densely in the order of the file, `TagToPoint` maps node tags to them
+    auto coords = vtkSmartPointer<vtkDoubleArray>::New();
+    coords->SetNumberOfComponents(3);
+    coords->SetNumberOfTuples(nPoints);
+    auto maxNodeTag = this->Msh->get_max_node_tag();
+    this->TagToPoint.assign(maxNodeTag + 1, -1);
+    double * dst = coords->GetPointer(0);
+    vtkIdType pointId = 0;
     for (const auto & nd : this->Msh->get_nodes()) {
-        if (!nd.tags.empty()) {
-            for (std::size_t j = 0; j < nd.tags.size(); j++) {
-                const auto & id = nd.tags[j];
-                const auto & c = nd.coordinates[j];
-                this->AllPoints->InsertPoint(id, c.x, c.y, c.z);
-            }
+        std::copy(nd.coordinates.begin(), nd.coordinates.end(), dst + 3 * pointId);
+        for (auto & id : nd.tags) {
+            if (id < 0 || id > maxNodeTag)
+                throw std::domain_error("Node tag " + std::to_string(id) + " is out of range");
+            this->TagToPoint[id] = pointId++;
         }
     }
+
+    this->AllPoints = vtkSmartPointer<vtkPoints>::New();
+    this->AllPoints->SetData(coords);
 }
 
 const std::vector<gmshparsercpp::MshFile::MultiDEntity> *
@@ -394,32 +478,22 @@ vtkMshReader::GetEntitiesByDim(int dim)
     }
 }
 
-vtkPoints *
-vtkMshReader::BuildLocalPoints(const std::map<long, vtkIdType> & nodeMap)
+vtkSmartPointer<vtkPoints>
+vtkMshReader::BuildLocalPoints(const std::vector<vtkIdType> & pointIds)
 {
+    auto coords = vtkSmartPointer<vtkDoubleArray>::New();
+    coords->SetNumberOfComponents(3);
+    coords->SetNumberOfTuples(pointIds.size());
+    auto src = vtkDoubleArray::SafeDownCast(this->AllPoints->GetData())->GetPointer(0);
+    auto dst = coords->GetPointer(0);
+    for (std::size_t lid = 0; lid < pointIds.size(); lid++)
+        std::copy(src + 3 * pointIds[lid], src + 3 * pointIds[lid] + 3, dst + 3 * lid);
+
     auto pts = vtkSmartPointer<vtkPoints>::New();
-    pts->SetNumberOfPoints(nodeMap.size());
-    for (auto & [gid, lid] : nodeMap) {
-        auto coord = this->AllPoints->GetPoint(gid);
-        pts->SetPoint(lid, coord);
-    }
+    pts->SetData(coords);
     return pts;
 }
 
-vtkIdType
-vtkMshReader::GetLocalPointId(std::map<long, vtkIdType> & nodeMap, int nodeId)
-{
-    vtkIdType pointId;
-    auto it = nodeMap.find(nodeId);
-    if (it == nodeMap.end()) {
-        pointId = nodeMap.size();
-        nodeMap[nodeId] = pointId;
-    }
-    else
-        pointId = it->second;
-    return pointId;
-}
-
 int
 vtkMshReader::GetNumberOfObjects(int objectType)
 {
@@ -459,38 +533,101 @@ vtkMshReader::GetObjectNameStr(int objectType, int objectIndex)
 
 vtkUnstructuredGrid *
 vtkMshReader::CreateUnstructuredGrid(
-    const std::vector<const gmshparsercpp::MshFile::ElementBlock *> & blocks)
+    const std::vector<const gmshparsercpp::MshFile::ElementBlock *> & blocks,
+    std::vector<vtkIdType> * pointMap)
 {
-    auto ug = vtkSmartPointer<vtkUnstructuredGrid>::New();
-
     vtkIdType numCells = 0;
-    for (auto & blk : blocks)
-        numCells += blk->elements.size();
+    vtkIdType connSize = 0;
+    for (auto & blk : blocks) {
+        if (msh_cell_type_to_vtk.count(blk->element_type) == 1) {
+            numCells += blk->size();
+            connSize += blk->connectivity.size();
+        }
+    }
+
+    auto types = vtkSmartPointer<vtkUnsignedCharArray>::New();
+    types->SetNumberOfValues(numCells);
+    auto offsets = vtkSmartPointer<vtkIdTypeArray>::New();
+    offsets->SetNumberOfValues(numCells + 1);
+    auto conn = vtkSmartPointer<vtkIdTypeArray>::New();
+    conn->SetNumberOfValues(connSize);
 
-    ug->Allocate(numCells);
+    auto typesPtr = types->GetPointer(0);
+    auto offsetsPtr = offsets->GetPointer(0);
+    auto connPtr = conn->GetPointer(0);
 
-    std::map<long, vtkIdType> localNodeMap;
+    // connectivity is first written with indices into `AllPoints`
+    vtkIdType cellId = 0;
+    vtkIdType connId = 0;
     for (auto & blk : blocks) {
-        if (msh_cell_type_to_vtk.count(blk->element_type) == 1) {
-            auto cellType = msh_cell_type_to_vtk[blk->element_type];
-            for (const auto & elem : blk->elements) {
-                auto nNodeTags = elem.node_tags.size();
-                std::vector<vtkIdType> cellNodes(nNodeTags);
-                for (std::size_t i = 0; i < nNodeTags; i++) {
-                    const auto & nid = elem.node_tags[i];
-                    vtkIdType pointId = GetLocalPointId(localNodeMap, nid);
-                    cellNodes[i] = pointId;
-                }
-                ug->InsertNextCell(cellType, nNodeTags, cellNodes.data());
+        auto it = msh_cell_type_to_vtk.find(blk->element_type);
+        if (it != msh_cell_type_to_vtk.end()) {
+            auto cellType = it->second;
+            auto nNodeTags = blk->nodes_per_element;
+            const int * nodeTags = blk->connectivity.data();
+            for (std::size_t j = 0; j < blk->size(); j++) {
+                typesPtr[cellId] = cellType;
+                offsetsPtr[cellId] = connId;
+                cellId++;
+                for (int i = 0; i < nNodeTags; i++, nodeTags++)
+                    connPtr[connId++] = this->TagToPoint[*nodeTags];
             }
         }
         else {
             // unknown element type, so skip this block
         }
     }
+    offsetsPtr[numCells] = connId;
+
+    // collect used points in increasing order
+    std::vector<vtkIdType> usedPoints;
+    if (pointMap) {
+        auto & map = *pointMap;
+        for (vtkIdType i = 0; i < connSize; i++) {
+            if (map[connPtr[i]] < 0) {
+                map[connPtr[i]] = 0;
+                usedPoints.push_back(connPtr[i]);
+            }
+        }
+        std::sort(usedPoints.begin(), usedPoints.end());
+    }
+    else {
+        usedPoints.assign(connPtr, connPtr + connSize);
+        std::sort(usedPoints.begin(), usedPoints.end());
+        usedPoints.erase(std::unique(usedPoints.begin(), usedPoints.end()), usedPoints.end());
+    }
+
+    auto ug = vtkUnstructuredGrid::New();
+    if ((vtkIdType) usedPoints.size() == this->AllPoints->GetNumberOfPoints()) {
+        // block uses every point, so it can share them
+        ug->SetPoints(this->AllPoints);
+    }
+    else {
+        // NOTE: blocks that use only some of the points get their own compact copy. Sharing the
+        // whole point array would make every mapper upload all points for each block.
+        if (pointMap) {
+            auto & map = *pointMap;
+            for (std::size_t lid = 0; lid < usedPoints.size(); lid++)
+                map[usedPoints[lid]] = lid;
+            for (vtkIdType i = 0; i < connSize; i++)
+                connPtr[i] = map[connPtr[i]];
+        }
+        else {
+            for (vtkIdType i = 0; i < connSize; i++)
+                connPtr[i] = std::lower_bound(usedPoints.begin(), usedPoints.end(), connPtr[i]) -
+                             usedPoints.begin();
+        }
+        ug->SetPoints(BuildLocalPoints(usedPoints));
+    }
+    if (pointMap) {
+        // reset the entries we used, so the table can be used by the next grid
+        for (auto & pointId : usedPoints)
+            (*pointMap)[pointId] = -1;
+    }
 
-    auto pts = BuildLocalPoints(localNodeMap);
-    ug->SetPoints(pts);
+    auto cells = vtkSmartPointer<vtkCellArray>::New();
+    cells->SetData(offsets, conn);
+    ug->SetCells(types, cells);
 
     return ug;
 }
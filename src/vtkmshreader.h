@@ -8,6 +8,7 @@
 #include "vtkSmartPointer.h"
 #include "gmshparsercpp/MshFile.h"
 #include <deque>
+#include <functional>
 
 class vtkMutableDirectedGraph;
 class vtkUnstructuredGrid;
@@ -35,6 +36,16 @@ public:
 
     enum ObjectType { ELEM_BLOCK = 0, SIDE_SET = 1 };
 
+    /// Callback invoked when the grid of an object is built
+    ///
+    /// It is invoked during `RequestData` and possibly from several threads at once. Object
+    /// ids and names are already known at that point.
+    using BlockReadyCallback =
+        std::function<void(int objectType, int objectIndex, vtkUnstructuredGrid * grid)>;
+
+    /// Set the callback invoked when the grid of an object is built
+    void SetBlockReadyCallback(BlockReadyCallback callback);
+
     int GetNumberOfObjects(int objectType);
     int GetObjectId(int objectType, int objectIndex);
     const char * GetObjectNameStr(int objectType, int objectIndex);
@@ -55,10 +66,18 @@ protected:
     void BuildCoordinates();
     void ProcessMsh();
     const std::vector<gmshparsercpp::MshFile::MultiDEntity> * GetEntitiesByDim(int dim);
-    vtkPoints * BuildLocalPoints(const std::map<long, vtkIdType> & nodeMap);
-    vtkIdType GetLocalPointId(std::map<long, vtkIdType> & nodeMap, int nodeId);
-    vtkUnstructuredGrid * CreateUnstructuredGrid(
-        const std::vector<const gmshparsercpp::MshFile::ElementBlock *> & blocks);
+    vtkSmartPointer<vtkPoints> BuildLocalPoints(const std::vector<vtkIdType> & pointIds);
+    /// Build an unstructured grid from element blocks
+    ///
+    /// This is safe to call concurrently as long as each call gets its own `pointMap`
+    ///
+    /// @param blocks Element blocks to put into the grid
+    /// @param pointMap Table indexed by point ids with all entries set to -1 (restored on return),
+    ///        or `nullptr` to remap point ids by sorting (cheaper for small blocks)
+    /// @return New grid, the caller takes ownership
+    vtkUnstructuredGrid *
+    CreateUnstructuredGrid(const std::vector<const gmshparsercpp::MshFile::ElementBlock *> & blocks,
+                           std::vector<vtkIdType> * pointMap);
     std::string GetMshPhysBlockName(int physId);
 
     char * FileName;
@@ -72,14 +91,20 @@ protected:
     std::map<long, const gmshparsercpp::MshFile::PhysicalName *> PhysEntByTag;
     ///
     std::vector<std::vector<const gmshparsercpp::MshFile::ElementBlock *>> ElemBlkByDim;
-    ///
+    /// All points in the order they appear in the file
     vtkSmartPointer<vtkPoints> AllPoints;
+    /// Node tag -> index into `AllPoints` (-1 for unused tags)
+    std::vector<vtkIdType> TagToPoint;
+    /// Index into `AllPoints` -> local point id (-1 when not assigned), reused by all blocks
+    std::vector<vtkIdType> PointMap;
     ///
     std::map<int, std::vector<int>> ObjectIds;
     std::map<int, std::vector<std::string>> ObjectNames;
     ///
     vtkIdType TotalNumOfNodes;
     vtkIdType TotalNumOfElems;
+    ///
+    BlockReadyCallback BlockReady;
 
 private:
     vtkMshReader(const vtkMshReader &) = delete;
@@ -0,0 +1,190 @@
+#include <QtTest/QtTest>
+#include "vtkboundaryextractor.h"
+#include "vtkUnstructuredGrid.h"
+#include "vtkPolyData.h"
+#include "vtkPoints.h"
+#include "vtkCellData.h"
+#include "vtkDoubleArray.h"
+#include "vtkIdTypeArray.h"
+#include "vtkCellType.h"
+#include "vtkGeometryFilter.h"
+#include "vtkPointData.h"
+#include "vtkIdList.h"
+#include "vtkSmartPointer.h"
+#include <algorithm>
+#include <set>
+
+namespace {
+
+/// Output cell as the input cell it comes from and sorted ids of its input points
+using SurfaceCell = std::pair<vtkIdType, std::vector<vtkIdType>>;
+
+std::multiset<SurfaceCell>
+getSurfaceCells(vtkPolyData * surface)
+{
+    auto * cell_ids = vtkIdTypeArray::SafeDownCast(
+        surface->GetCellData()->GetArray(vtkBoundaryExtractor::GetOriginalCellIdsName()));
+    auto * point_ids = vtkIdTypeArray::SafeDownCast(
+        surface->GetPointData()->GetArray(vtkBoundaryExtractor::GetOriginalPointIdsName()));
+    std::multiset<SurfaceCell> cells;
+    if (cell_ids == nullptr || point_ids == nullptr)
+        return cells;
+
+    auto ids = vtkSmartPointer<vtkIdList>::New();
+    for (vtkIdType i = 0; i < surface->GetNumberOfCells(); i++) {
+        surface->GetCellPoints(i, ids);
+        std::vector<vtkIdType> pts;
+        for (vtkIdType k = 0; k < ids->GetNumberOfIds(); k++)
+            pts.push_back(point_ids->GetValue(ids->GetId(k)));
+        std::sort(pts.begin(), pts.end());
+        cells.insert({ cell_ids->GetValue(i), pts });
+    }
+    return cells;
+}
+
+vtkSmartPointer<vtkPolyData>
+extractWithGeometryFilter(vtkUnstructuredGrid * grid)
+{
+    auto filter = vtkSmartPointer<vtkGeometryFilter>::New();
+    filter->PassThroughCellIdsOn();
+    filter->SetOriginalCellIdsName(vtkBoundaryExtractor::GetOriginalCellIdsName());
+    filter->PassThroughPointIdsOn();
+    filter->SetOriginalPointIdsName(vtkBoundaryExtractor::GetOriginalPointIdsName());
+    filter->SetInputData(grid);
+    filter->Update();
+    return filter->GetOutput();
+}
+
+} // namespace
+
+class BoundaryExtractorTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void
+    testTwoHexes()
+    {
+        // two unit hexes sharing the face at x = 1
+        auto points = vtkSmartPointer<vtkPoints>::New();
+        for (int k = 0; k < 2; k++)
+            for (int j = 0; j < 2; j++)
+                for (int i = 0; i < 3; i++)
+                    points->InsertNextPoint(i, j, k);
+        // extra point not used by any cell
+        points->InsertNextPoint(10, 10, 10);
+
+        auto grid = vtkSmartPointer<vtkUnstructuredGrid>::New();
+        grid->SetPoints(points);
+        for (vtkIdType i = 0; i < 2; i++) {
+            vtkIdType pts[8] = { i, i + 1, i + 4, i + 3, i + 6, i + 7, i + 10, i + 9 };
+            grid->InsertNextCell(VTK_HEXAHEDRON, 8, pts);
+        }
+        auto values = vtkSmartPointer<vtkDoubleArray>::New();
+        values->SetName("value");
+        values->InsertNextValue(1.);
+        values->InsertNextValue(2.);
+        grid->GetCellData()->AddArray(values);
+
+        auto extractor = vtkSmartPointer<vtkBoundaryExtractor>::New();
+        extractor->SetInputData(grid);
+        extractor->Update();
+        auto * surface = extractor->GetOutput();
+
+        QCOMPARE(surface->GetNumberOfPolys(), (vtkIdType) 10);
+        QCOMPARE(surface->GetNumberOfPoints(), (vtkIdType) 12);
+
+        auto * orig_ids = vtkIdTypeArray::SafeDownCast(
+            surface->GetCellData()->GetArray(vtkBoundaryExtractor::GetOriginalCellIdsName()));
+        QVERIFY(orig_ids != nullptr);
+        auto * surf_values =
+            vtkDoubleArray::SafeDownCast(surface->GetCellData()->GetArray("value"));
+        QVERIFY(surf_values != nullptr);
+        for (vtkIdType i = 0; i < surface->GetNumberOfCells(); i++) {
+            auto cell_id = orig_ids->GetValue(i);
+            QCOMPARE(cell_id, (vtkIdType) (i < 5 ? 0 : 1));
+            QCOMPARE(surf_values->GetValue(i), cell_id + 1.);
+        }
+    }
+
+    void
+    testMixedCells()
+    {
+        // hex and voxel side by side, a pyramid on the hex, a wedge on the voxel, a tet on
+        // a face of the pyramid, and separate quad, line and vertex
+        double coords[][3] = { { 0, 0, 0 },   { 1, 0, 0 },     { 2, 0, 0 },   { 0, 1, 0 },
+                               { 1, 1, 0 },   { 2, 1, 0 },     { 0, 0, 1 },   { 1, 0, 1 },
+                               { 2, 0, 1 },   { 0, 1, 1 },     { 1, 1, 1 },   { 2, 1, 1 },
+                               { .5, .5, 2 }, { 1.5, 0, 2 },   { 1.5, 1, 2 }, { .5, -1, 1.5 },
+                               { 5, 0, 0 },   { 6, 0, 0 },     { 6, 1, 0 },   { 5, 1, 0 },
+                               { 5, 3, 0 },   { 6, 3, 0 },     { 7, 7, 7 } };
+        auto points = vtkSmartPointer<vtkPoints>::New();
+        for (auto & x : coords)
+            points->InsertNextPoint(x);
+
+        auto grid = vtkSmartPointer<vtkUnstructuredGrid>::New();
+        grid->SetPoints(points);
+        vtkIdType hex[] = { 0, 1, 4, 3, 6, 7, 10, 9 };
+        grid->InsertNextCell(VTK_HEXAHEDRON, 8, hex);
+        vtkIdType quad[] = { 16, 17, 18, 19 };
+        grid->InsertNextCell(VTK_QUAD, 4, quad);
+        vtkIdType voxel[] = { 1, 2, 4, 5, 7, 8, 10, 11 };
+        grid->InsertNextCell(VTK_VOXEL, 8, voxel);
+        vtkIdType pyramid[] = { 6, 7, 10, 9, 12 };
+        grid->InsertNextCell(VTK_PYRAMID, 5, pyramid);
+        vtkIdType line[] = { 20, 21 };
+        grid->InsertNextCell(VTK_LINE, 2, line);
+        vtkIdType wedge[] = { 7, 8, 13, 10, 11, 14 };
+        grid->InsertNextCell(VTK_WEDGE, 6, wedge);
+        vtkIdType tet[] = { 6, 7, 12, 15 };
+        grid->InsertNextCell(VTK_TETRA, 4, tet);
+        vtkIdType vertex[] = { 22 };
+        grid->InsertNextCell(VTK_VERTEX, 1, vertex);
+
+        auto extractor = vtkSmartPointer<vtkBoundaryExtractor>::New();
+        extractor->SetInputData(grid);
+        extractor->Update();
+        auto * surface = extractor->GetOutput();
+
+        // 4 hex, 4 voxel, 3 pyramid, 4 wedge and 3 tet faces, and the quad
+        QCOMPARE(surface->GetNumberOfPolys(), (vtkIdType) 19);
+        QCOMPARE(surface->GetNumberOfLines(), (vtkIdType) 1);
+        QCOMPARE(surface->GetNumberOfVerts(), (vtkIdType) 1);
+
+        auto expected = extractWithGeometryFilter(grid);
+        QCOMPARE(surface->GetNumberOfCells(), expected->GetNumberOfCells());
+        auto cells = getSurfaceCells(surface);
+        QCOMPARE(cells.size(), (std::size_t) surface->GetNumberOfCells());
+        QVERIFY(cells == getSurfaceCells(expected));
+    }
+
+    void
+    testFallback()
+    {
+        // a quadratic tet is not supported, it is passed to vtkGeometryFilter
+        auto points = vtkSmartPointer<vtkPoints>::New();
+        double coords[][3] = { { 0, 0, 0 }, { 1, 0, 0 },    { 0, 1, 0 },    { 0, 0, 1 },
+                               { .5, 0, 0 }, { .5, .5, 0 }, { 0, .5, 0 },   { 0, 0, .5 },
+                               { .5, 0, .5 }, { 0, .5, .5 } };
+        for (auto & x : coords)
+            points->InsertNextPoint(x);
+        auto grid = vtkSmartPointer<vtkUnstructuredGrid>::New();
+        grid->SetPoints(points);
+        vtkIdType tet[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+        grid->InsertNextCell(VTK_QUADRATIC_TETRA, 10, tet);
+
+        auto extractor = vtkSmartPointer<vtkBoundaryExtractor>::New();
+        extractor->SetInputData(grid);
+        extractor->Update();
+        auto * surface = extractor->GetOutput();
+
+        auto expected = extractWithGeometryFilter(grid);
+        QCOMPARE(surface->GetNumberOfCells(), expected->GetNumberOfCells());
+        auto cells = getSurfaceCells(surface);
+        QCOMPARE(cells.size(), (std::size_t) 4);
+        QVERIFY(cells == getSurfaceCells(expected));
+    }
+};
+
+QTEST_MAIN(BoundaryExtractorTest)
+
+#include "BoundaryExtractor_test.moc"
@@ -0,0 +1,168 @@
+#include <QtTest/QtTest>
+#include <map>
+#include "vtkmaterialpartitioner.h"
+#include "vtkUnstructuredGrid.h"
+#include "vtkMultiBlockDataSet.h"
+#include "vtkInformation.h"
+#include "vtkPoints.h"
+#include "vtkCellData.h"
+#include "vtkCellType.h"
+#include "vtkDoubleArray.h"
+#include "vtkIntArray.h"
+#include "vtkIdList.h"
+#include "vtkSmartPointer.h"
+
+namespace {
+
+/// Add material ids and cell values (`100 + cell id`) to a grid
+void
+addCellData(vtkUnstructuredGrid * grid, const std::vector<int> & materials)
+{
+    auto mat_ids = vtkSmartPointer<vtkIntArray>::New();
+    mat_ids->SetName("MaterialIds");
+    auto values = vtkSmartPointer<vtkDoubleArray>::New();
+    values->SetName("value");
+    for (std::size_t i = 0; i < materials.size(); i++) {
+        mat_ids->InsertNextValue(materials[i]);
+        values->InsertNextValue(100. + i);
+    }
+    grid->GetCellData()->AddArray(mat_ids);
+    grid->GetCellData()->AddArray(values);
+}
+
+/// Check the grid of a material against the cells of the input with that material
+///
+/// Cells have to keep their order and points have to be numbered in the order the cells use them.
+void
+checkMaterial(vtkUnstructuredGrid * input, vtkMaterialPartitioner * partitioner, int material)
+{
+    auto * grid = partitioner->GetMaterialBlock(material);
+    QVERIFY(grid != nullptr);
+    auto * mat_ids = input->GetCellData()->GetArray("MaterialIds");
+    auto * values = input->GetCellData()->GetArray("value");
+    auto * out_mat_ids = grid->GetCellData()->GetArray("MaterialIds");
+    auto * out_values = grid->GetCellData()->GetArray("value");
+    QVERIFY(out_mat_ids != nullptr);
+    QVERIFY(out_values != nullptr);
+    QCOMPARE(grid->GetPoints()->GetDataType(), input->GetPoints()->GetDataType());
+
+    // old point id -> new point id
+    std::map<vtkIdType, vtkIdType> point_map;
+    auto in_pts = vtkSmartPointer<vtkIdList>::New();
+    auto out_pts = vtkSmartPointer<vtkIdList>::New();
+    vtkIdType j = 0;
+    for (vtkIdType i = 0; i < input->GetNumberOfCells(); i++) {
+        if ((int) mat_ids->GetComponent(i, 0) != material)
+            continue;
+        QVERIFY(j < grid->GetNumberOfCells());
+        QCOMPARE(grid->GetCellType(j), input->GetCellType(i));
+        QCOMPARE(out_mat_ids->GetComponent(j, 0), (double) material);
+        QCOMPARE(out_values->GetComponent(j, 0), values->GetComponent(i, 0));
+
+        input->GetCellPoints(i, in_pts);
+        grid->GetCellPoints(j, out_pts);
+        QCOMPARE(out_pts->GetNumberOfIds(), in_pts->GetNumberOfIds());
+        for (vtkIdType k = 0; k < in_pts->GetNumberOfIds(); k++) {
+            auto n_mapped = (vtkIdType) point_map.size();
+            auto it = point_map.emplace(in_pts->GetId(k), n_mapped).first;
+            QCOMPARE(out_pts->GetId(k), it->second);
+        }
+        j++;
+    }
+    QCOMPARE(grid->GetNumberOfCells(), j);
+
+    QCOMPARE(grid->GetNumberOfPoints(), (vtkIdType) point_map.size());
+    for (auto & [old_id, new_id] : point_map) {
+        double x[3], y[3];
+        input->GetPoint(old_id, x);
+        grid->GetPoint(new_id, y);
+        QCOMPARE(y[0], x[0]);
+        QCOMPARE(y[1], x[1]);
+        QCOMPARE(y[2], x[2]);
+    }
+}
+
+} // namespace
+
+class MaterialPartitionerTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void
+    testInterleavedMaterials()
+    {
+        // strip of 8 quads and a triangle, points 0-8 at the bottom and 9-17 at the top
+        auto points = vtkSmartPointer<vtkPoints>::New();
+        points->SetDataTypeToFloat();
+        for (int j = 0; j <= 1; j++)
+            for (int i = 0; i <= 8; i++)
+                points->InsertNextPoint(i, j, 0);
+        points->InsertNextPoint(9, 0, 0);
+        auto grid = vtkSmartPointer<vtkUnstructuredGrid>::New();
+        grid->SetPoints(points);
+        for (vtkIdType i = 0; i < 8; i++) {
+            vtkIdType quad[] = { i, i + 1, i + 10, i + 9 };
+            grid->InsertNextCell(VTK_QUAD, 4, quad);
+        }
+        vtkIdType tri[] = { 8, 18, 17 };
+        grid->InsertNextCell(VTK_TRIANGLE, 3, tri);
+        // 3, 4 and 6 are missing
+        addCellData(grid, { 5, 2, 5, 7, 2, 2, 7, 5, 2 });
+
+        auto partitioner = vtkSmartPointer<vtkMaterialPartitioner>::New();
+        partitioner->SetInputData(grid);
+        partitioner->Update();
+
+        auto * output = vtkMultiBlockDataSet::SafeDownCast(partitioner->GetOutputDataObject(0));
+        QVERIFY(output != nullptr);
+        QCOMPARE(output->GetNumberOfBlocks(), 3u);
+        const char * names[] = { "2", "5", "7" };
+        for (unsigned int k = 0; k < 3; k++)
+            QCOMPARE(QString(output->GetMetaData(k)->Get(vtkCompositeDataSet::NAME())),
+                     QString(names[k]));
+
+        for (int material : { 2, 5, 7 })
+            checkMaterial(grid, partitioner, material);
+        QCOMPARE(partitioner->GetMaterialBlock(2)->GetNumberOfCells(), (vtkIdType) 4);
+        QCOMPARE(partitioner->GetMaterialBlock(7)->GetNumberOfPoints(), (vtkIdType) 8);
+
+        for (int material : { 0, 3, 4, 6, 8 })
+            QVERIFY(partitioner->GetMaterialBlock(material) == nullptr);
+    }
+
+    void
+    testManyChunks()
+    {
+        // line segments along the x-axis, more than two chunks of cells
+        const vtkIdType n_cells = 150000;
+        auto points = vtkSmartPointer<vtkPoints>::New();
+        points->SetDataTypeToDouble();
+        for (vtkIdType i = 0; i <= n_cells; i++)
+            points->InsertNextPoint(i, 0, 0);
+        auto grid = vtkSmartPointer<vtkUnstructuredGrid>::New();
+        grid->SetPoints(points);
+        grid->AllocateExact(n_cells, 2);
+        std::vector<int> materials;
+        for (vtkIdType i = 0; i < n_cells; i++) {
+            vtkIdType line[] = { i, i + 1 };
+            grid->InsertNextCell(VTK_LINE, 2, line);
+            // a material missing from the first chunk, the others spread over all chunks
+            materials.push_back(i < 70000 ? 2 * ((i * 7919) % 4) : 2 * ((i * 7919) % 5));
+        }
+        addCellData(grid, materials);
+
+        auto partitioner = vtkSmartPointer<vtkMaterialPartitioner>::New();
+        partitioner->SetInputData(grid);
+        partitioner->Update();
+
+        auto * output = vtkMultiBlockDataSet::SafeDownCast(partitioner->GetOutputDataObject(0));
+        QCOMPARE(output->GetNumberOfBlocks(), 5u);
+        for (int material : { 0, 2, 4, 6, 8 })
+            checkMaterial(grid, partitioner, material);
+        QVERIFY(partitioner->GetMaterialBlock(1) == nullptr);
+    }
+};
+
+QTEST_MAIN(MaterialPartitionerTest)
+
+#include "MaterialPartitioner_test.moc"
@@ -0,0 +1,301 @@
+#include <QtTest/QtTest>
+#include <QTemporaryDir>
+#include "meshcache.h"
+#include "vtkCellArray.h"
+#include "vtkCellData.h"
+#include "vtkCellType.h"
+#include "vtkDataArray.h"
+#include "vtkDoubleArray.h"
+#include "vtkFloatArray.h"
+#include "vtkInformation.h"
+#include "vtkIntArray.h"
+#include "vtkMultiBlockDataSet.h"
+#include "vtkPointData.h"
+#include "vtkPoints.h"
+#include "vtkSmartPointer.h"
+#include "vtkUnsignedCharArray.h"
+#include "vtkUnstructuredGrid.h"
+
+namespace {
+
+/// Maximum size of the cache used by the tests
+const qint64 MAX_SIZE = 1 << 30;
+
+/// Grid with a hexahedron, a wedge, a triangle and a vertex, `shift` makes grids differ
+vtkSmartPointer<vtkUnstructuredGrid>
+buildGrid(double shift)
+{
+    auto points = vtkSmartPointer<vtkPoints>::New();
+    points->SetDataTypeToDouble();
+    for (int k = 0; k <= 1; k++) {
+        points->InsertNextPoint(shift, 0, k);
+        points->InsertNextPoint(shift + 1, 0, k);
+        points->InsertNextPoint(shift + 1, 1, k);
+        points->InsertNextPoint(shift, 1, k);
+    }
+    points->InsertNextPoint(shift + 2, 0, 0);
+    points->InsertNextPoint(shift + 2, 0, 1);
+
+    auto grid = vtkSmartPointer<vtkUnstructuredGrid>::New();
+    grid->SetPoints(points);
+    vtkIdType hex[] = { 0, 1, 2, 3, 4, 5, 6, 7 };
+    grid->InsertNextCell(VTK_HEXAHEDRON, 8, hex);
+    vtkIdType wedge[] = { 1, 8, 2, 5, 9, 6 };
+    grid->InsertNextCell(VTK_WEDGE, 6, wedge);
+    vtkIdType tri[] = { 8, 9, 2 };
+    grid->InsertNextCell(VTK_TRIANGLE, 3, tri);
+    vtkIdType vertex[] = { 9 };
+    grid->InsertNextCell(VTK_VERTEX, 1, vertex);
+
+    auto temperature = vtkSmartPointer<vtkDoubleArray>::New();
+    temperature->SetName("temperature");
+    auto velocity = vtkSmartPointer<vtkFloatArray>::New();
+    velocity->SetName("velocity");
+    velocity->SetNumberOfComponents(3);
+    for (vtkIdType i = 0; i < grid->GetNumberOfPoints(); i++) {
+        temperature->InsertNextValue(shift + 0.5 * i);
+        velocity->InsertNextTuple3(i, -i, shift);
+    }
+    grid->GetPointData()->AddArray(temperature);
+    grid->GetPointData()->AddArray(velocity);
+
+    auto material = vtkSmartPointer<vtkIntArray>::New();
+    material->SetName("material");
+    for (vtkIdType i = 0; i < grid->GetNumberOfCells(); i++)
+        material->InsertNextValue(10 * i + (int) shift);
+    grid->GetCellData()->AddArray(material);
+    return grid;
+}
+
+/// Contents with a named grid, a missing block, an unnamed grid and an empty grid
+MeshCache::Contents
+buildContents()
+{
+    auto mb = vtkSmartPointer<vtkMultiBlockDataSet>::New();
+    mb->SetNumberOfBlocks(4);
+    mb->SetBlock(0, buildGrid(0.));
+    mb->GetMetaData(0u)->Set(vtkCompositeDataSet::NAME(), "left");
+    mb->SetBlock(2, buildGrid(3.));
+    mb->SetBlock(3, vtkSmartPointer<vtkUnstructuredGrid>::New());
+
+    MeshCache::Contents contents;
+    contents.data = mb;
+    contents.blocks = { { "left", 1, 0, 10, 1, -1 }, { "right", 1, 1, 20, 3, 2 } };
+    contents.side_sets = { { "bottom", 3, 0, 100, 5, -1 } };
+    contents.total_elements = 8;
+    contents.total_nodes = 20;
+    contents.dimensionality = 3;
+    return contents;
+}
+
+QString
+writeMeshFile(const QTemporaryDir & dir)
+{
+    auto file_name = dir.filePath("mesh.msh");
+    QFile file(file_name);
+    file.open(QIODevice::WriteOnly);
+    file.write("$MeshFormat\n4.1 0 8\n$EndMeshFormat\n");
+    file.close();
+    return file_name;
+}
+
+QByteArray
+readFile(const QString & file_name)
+{
+    QFile file(file_name);
+    file.open(QIODevice::ReadOnly);
+    return file.readAll();
+}
+
+void
+writeFile(const QString & file_name, const QByteArray & contents)
+{
+    QFile file(file_name);
+    file.open(QIODevice::WriteOnly | QIODevice::Truncate);
+    file.write(contents);
+}
+
+void
+compareArrays(vtkDataArray * arr, vtkDataArray * expected)
+{
+    QVERIFY(arr != nullptr);
+    QCOMPARE(QString(arr->GetName()), QString(expected->GetName()));
+    QCOMPARE(arr->GetDataType(), expected->GetDataType());
+    QCOMPARE(arr->GetNumberOfComponents(), expected->GetNumberOfComponents());
+    QCOMPARE(arr->GetNumberOfTuples(), expected->GetNumberOfTuples());
+    for (vtkIdType i = 0; i < expected->GetNumberOfTuples(); i++)
+        for (int j = 0; j < expected->GetNumberOfComponents(); j++)
+            QCOMPARE(arr->GetComponent(i, j), expected->GetComponent(i, j));
+}
+
+void
+compareAttributes(vtkFieldData * fd, vtkFieldData * expected)
+{
+    QCOMPARE(fd->GetNumberOfArrays(), expected->GetNumberOfArrays());
+    for (int i = 0; i < expected->GetNumberOfArrays(); i++)
+        compareArrays(fd->GetArray(i), expected->GetArray(i));
+}
+
+void
+compareGrids(vtkDataObject * obj, vtkUnstructuredGrid * expected)
+{
+    auto * grid = vtkUnstructuredGrid::SafeDownCast(obj);
+    QVERIFY(grid != nullptr);
+    QCOMPARE(grid->GetNumberOfPoints(), expected->GetNumberOfPoints());
+    QCOMPARE(grid->GetNumberOfCells(), expected->GetNumberOfCells());
+    if (expected->GetNumberOfPoints() > 0)
+        compareArrays(grid->GetPoints()->GetData(), expected->GetPoints()->GetData());
+    if (expected->GetNumberOfCells() > 0) {
+        compareArrays(grid->GetCells()->GetOffsetsArray(), expected->GetCells()->GetOffsetsArray());
+        compareArrays(grid->GetCells()->GetConnectivityArray(),
+                      expected->GetCells()->GetConnectivityArray());
+        compareArrays(grid->GetCellTypesArray(), expected->GetCellTypesArray());
+    }
+    compareAttributes(grid->GetPointData(), expected->GetPointData());
+    compareAttributes(grid->GetCellData(), expected->GetCellData());
+}
+
+void
+compareInfos(const std::vector<Reader::BlockInformation> & infos,
+             const std::vector<Reader::BlockInformation> & expected)
+{
+    QCOMPARE(infos.size(), expected.size());
+    for (std::size_t i = 0; i < expected.size(); i++) {
+        QCOMPARE(infos[i].name, expected[i].name);
+        QCOMPARE(infos[i].object_type, expected[i].object_type);
+        QCOMPARE(infos[i].object_index, expected[i].object_index);
+        QCOMPARE(infos[i].number, expected[i].number);
+        QCOMPARE(infos[i].multiblock_index, expected[i].multiblock_index);
+        QCOMPARE(infos[i].material_index, expected[i].material_index);
+    }
+}
+
+} // namespace
+
+class MeshCacheTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void
+    initTestCase()
+    {
+        // entries go into a test location, not into the user's cache
+        QStandardPaths::setTestModeEnabled(true);
+        QDir(MeshCache::getDirectory()).removeRecursively();
+    }
+
+    void
+    cleanupTestCase()
+    {
+        QDir(MeshCache::getDirectory()).removeRecursively();
+    }
+
+    void
+    testRoundTrip()
+    {
+        QTemporaryDir dir;
+        auto file_name = writeMeshFile(dir);
+
+        MeshCache cache(file_name, MAX_SIZE);
+        QVERIFY(!cache.hasEntry());
+        auto contents = buildContents();
+        QVERIFY(cache.write(contents));
+        QVERIFY(cache.hasEntry());
+
+        MeshCache::Contents loaded;
+        QVERIFY(cache.read(loaded));
+        QCOMPARE(loaded.total_elements, contents.total_elements);
+        QCOMPARE(loaded.total_nodes, contents.total_nodes);
+        QCOMPARE(loaded.dimensionality, contents.dimensionality);
+        compareInfos(loaded.blocks, contents.blocks);
+        compareInfos(loaded.side_sets, contents.side_sets);
+        compareInfos(loaded.node_sets, contents.node_sets);
+
+        auto * mb = vtkMultiBlockDataSet::SafeDownCast(loaded.data);
+        auto * expected = vtkMultiBlockDataSet::SafeDownCast(contents.data);
+        QVERIFY(mb != nullptr);
+        QCOMPARE(mb->GetNumberOfBlocks(), 4u);
+        QVERIFY(mb->HasMetaData(0u));
+        QCOMPARE(QString(mb->GetMetaData(0u)->Get(vtkCompositeDataSet::NAME())), QString("left"));
+        QVERIFY(!mb->HasMetaData(2u) || !mb->GetMetaData(2u)->Has(vtkCompositeDataSet::NAME()));
+        QVERIFY(mb->GetBlock(1) == nullptr);
+        for (unsigned int i : { 0u, 2u, 3u })
+            compareGrids(mb->GetBlock(i), vtkUnstructuredGrid::SafeDownCast(expected->GetBlock(i)));
+
+        cache.remove();
+        QVERIFY(!cache.hasEntry());
+    }
+
+    void
+    testCorruptedEntry()
+    {
+        QTemporaryDir dir;
+        auto file_name = writeMeshFile(dir);
+        MeshCache cache(file_name, MAX_SIZE);
+        QVERIFY(cache.write(buildContents()));
+        auto entry_file_name = cache.getEntryFileName();
+        auto entry = readFile(entry_file_name);
+
+        // every truncation is detected
+        for (qsizetype n = 0; n < entry.size(); n++) {
+            writeFile(entry_file_name, entry.left(n));
+            MeshCache::Contents contents;
+            QVERIFY2(!cache.read(contents), qPrintable(QString("truncated to %1 bytes").arg(n)));
+            QVERIFY(contents.data == nullptr);
+        }
+
+        // the header and the key take 40 bytes, counts and sizes following them become huge
+        auto corrupted = entry;
+        for (qsizetype i = 40; i < corrupted.size(); i++)
+            corrupted[i] = '\xff';
+        writeFile(entry_file_name, corrupted);
+        MeshCache::Contents contents;
+        QVERIFY(cache.hasEntry());
+        QVERIFY(!cache.read(contents));
+
+        corrupted = entry;
+        corrupted[0] = 'X';
+        writeFile(entry_file_name, corrupted);
+        QVERIFY(!cache.hasEntry());
+        QVERIFY(!cache.read(contents));
+
+        writeFile(entry_file_name, entry);
+        QVERIFY(cache.read(contents));
+        cache.remove();
+    }
+
+    void
+    testSourceChanged()
+    {
+        QTemporaryDir dir;
+        auto file_name = writeMeshFile(dir);
+        QVERIFY(MeshCache(file_name, MAX_SIZE).write(buildContents()));
+        QVERIFY(MeshCache(file_name, MAX_SIZE).hasEntry());
+
+        // modification time
+        {
+            QFile file(file_name);
+            file.open(QIODevice::ReadWrite);
+            auto mtime = QFileInfo(file_name).lastModified().addSecs(-60);
+            QVERIFY(file.setFileTime(mtime, QFileDevice::FileModificationTime));
+        }
+        QVERIFY(!MeshCache(file_name, MAX_SIZE).hasEntry());
+
+        // size
+        QVERIFY(MeshCache(file_name, MAX_SIZE).write(buildContents()));
+        QVERIFY(MeshCache(file_name, MAX_SIZE).hasEntry());
+        {
+            QFile file(file_name);
+            file.open(QIODevice::Append);
+            file.write("$Comments\n$EndComments\n");
+        }
+        MeshCache cache(file_name, MAX_SIZE);
+        QVERIFY(!cache.hasEntry());
+        MeshCache::Contents contents;
+        QVERIFY(!cache.read(contents));
+    }
+};
+
+QTEST_MAIN(MeshCacheTest)
+
+#include "MeshCache_test.moc"
@@ -0,0 +1,378 @@
+#include <QtTest/QtTest>
+#include <QTemporaryDir>
+#include <algorithm>
+#include <cstring>
+#include <initializer_list>
+#include <string>
+#include "gmshparsercpp/MshFile.h"
+
+using namespace gmshparsercpp;
+
+namespace {
+
+const char * MSH_V4_ASCII = "$MeshFormat\n"
+                            "4.1 0 8\n"
+                            "$EndMeshFormat\n"
+                            "$PhysicalNames\n"
+                            "1\n"
+                            "2 1 \"surface\"\n"
+                            "$EndPhysicalNames\n"
+                            "$Entities\n"
+                            "0 0 1 0\n"
+                            "1 0 0 0 1 1 0 1 1 0\n"
+                            "$EndEntities\n"
+                            "$Nodes\n"
+                            "1 4 1 4\n"
+                            "2 1 0 4\n"
+                            "1\n"
+                            "2\n"
+                            "3\n"
+                            "4\n"
+                            "0 0 0\n"
+                            "1 0 0\n"
+                            "1 1 0\n"
+                            "0 1 0\n"
+                            "$EndNodes\n"
+                            "$Elements\n"
+                            "1 2 1 2\n"
+                            "2 1 2 2\n"
+                            "1 1 2 3\n"
+                            "2 1 3 4\n"
+                            "$EndElements\n";
+
+const char * MSH_V2_ASCII = "$MeshFormat\n"
+                            "2.2 0 8\n"
+                            "$EndMeshFormat\n"
+                            "$Nodes\n"
+                            "3\n"
+                            "1 0 0 0\n"
+                            "2 1.5e+00 0 0\n"
+                            "3 0 2.5 0\n"
+                            "$EndNodes\n"
+                            "$Elements\n"
+                            "1\n"
+                            "1 2 2 7 1 1 2 3\n"
+                            "$EndElements\n";
+
+/// Builds contents of MSH files with binary sections in memory
+class MshBuilder {
+public:
+    /// @param swap Write binary values in the byte order opposite to ours
+    explicit MshBuilder(bool swap) : swap(swap) {}
+
+    MshBuilder &
+    text(const char * str)
+    {
+        this->data.append(str);
+        return *this;
+    }
+
+    template <typename T>
+    MshBuilder &
+    blob(std::initializer_list<T> vals)
+    {
+        for (auto val : vals) {
+            char bytes[sizeof(T)];
+            std::memcpy(bytes, &val, sizeof(T));
+            if (this->swap)
+                std::reverse(bytes, bytes + sizeof(T));
+            this->data.append(bytes, sizeof(T));
+        }
+        return *this;
+    }
+
+    QByteArray data;
+
+private:
+    bool swap;
+};
+
+/// `MSH_V4_ASCII` with binary sections
+QByteArray
+buildMshV4Binary(bool swap)
+{
+    MshBuilder msh(swap);
+    msh.text("$MeshFormat\n4.1 1 8\n").blob<int>({ 1 }).text("\n$EndMeshFormat\n");
+    msh.text("$PhysicalNames\n1\n2 1 \"surface\"\n$EndPhysicalNames\n");
+    msh.text("$Entities\n").blob<size_t>({ 0, 0, 1, 0 });
+    msh.blob<int>({ 1 }).blob<double>({ 0, 0, 0, 1, 1, 0 });
+    msh.blob<size_t>({ 1 }).blob<int>({ 1 }).blob<size_t>({ 0 });
+    msh.text("\n$EndEntities\n");
+    msh.text("$Nodes\n").blob<size_t>({ 1, 4, 1, 4 });
+    msh.blob<int>({ 2, 1, 0 }).blob<size_t>({ 4 });
+    msh.blob<size_t>({ 1, 2, 3, 4 });
+    msh.blob<double>({ 0, 0, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0 });
+    msh.text("\n$EndNodes\n");
+    msh.text("$Elements\n").blob<size_t>({ 1, 2, 1, 2 });
+    msh.blob<int>({ 2, 1, 2 }).blob<size_t>({ 2 });
+    msh.blob<size_t>({ 1, 1, 2, 3, 2, 1, 3, 4 });
+    msh.text("\n$EndElements\n");
+    return msh.data;
+}
+
+/// `MSH_V2_ASCII` with binary sections
+QByteArray
+buildMshV2Binary()
+{
+    MshBuilder msh(false);
+    msh.text("$MeshFormat\n2.2 1 8\n").blob<int>({ 1 }).text("\n$EndMeshFormat\n");
+    msh.text("$Nodes\n3\n");
+    msh.blob<int>({ 1 }).blob<double>({ 0, 0, 0 });
+    msh.blob<int>({ 2 }).blob<double>({ 1.5, 0, 0 });
+    msh.blob<int>({ 3 }).blob<double>({ 0, 2.5, 0 });
+    msh.text("\n$EndNodes\n");
+    // one group of elements: type, number of elements, number of tags
+    msh.text("$Elements\n1\n").blob<int>({ 2, 1, 2 });
+    msh.blob<int>({ 1, 7, 1, 1, 2, 3 });
+    msh.text("\n$EndElements\n");
+    return msh.data;
+}
+
+/// ASCII v4 file with entity blocks parsed by several jobs in parallel
+///
+/// The first node and element blocks span more than two parse jobs (16384 lines each), the second
+/// ones fit into one.
+///
+/// @param bad_node Index of a node with coordinates that cannot be parsed, -1 for none
+QByteArray
+buildLargeMshV4(int bad_node = -1)
+{
+    const int n_nodes[] = { 40000, 1000 };
+    const int n_total = n_nodes[0] + n_nodes[1];
+
+    std::string msh = "$MeshFormat\n4.1 0 8\n$EndMeshFormat\n";
+    msh += "$Nodes\n2 " + std::to_string(n_total) + " 1 " + std::to_string(n_total) + "\n";
+    for (int b = 0, first = 0; b < 2; first += n_nodes[b], b++) {
+        msh += "1 " + std::to_string(b + 1) + " 0 " + std::to_string(n_nodes[b]) + "\n";
+        for (int i = first; i < first + n_nodes[b]; i++)
+            msh += std::to_string(i + 1) + "\n";
+        for (int i = first; i < first + n_nodes[b]; i++) {
+            if (i == bad_node)
+                msh += "x 0 0\n";
+            else
+                msh += std::to_string(i) + " " + std::to_string(i % 7) + " 0\n";
+        }
+    }
+    msh += "$EndNodes\n";
+
+    // a chain of line segments through all nodes
+    const int n_elems[] = { n_nodes[0], n_nodes[1] - 1 };
+    msh += "$Elements\n2 " + std::to_string(n_total - 1) + " 1 " + std::to_string(n_total - 1);
+    msh += "\n";
+    for (int b = 0, first = 0; b < 2; first += n_elems[b], b++) {
+        msh += "1 " + std::to_string(b + 1) + " 1 " + std::to_string(n_elems[b]) + "\n";
+        for (int i = first; i < first + n_elems[b]; i++)
+            msh += std::to_string(i + 1) + " " + std::to_string(i + 1) + " " +
+                   std::to_string(i + 2) + "\n";
+    }
+    msh += "$EndElements\n";
+    return QByteArray::fromStdString(msh);
+}
+
+/// Compare nodes and element blocks of two parsed files
+void
+compareMeshes(const MshFile & msh, const MshFile & expected)
+{
+    const auto & nodes = msh.get_nodes();
+    QCOMPARE(nodes.size(), expected.get_nodes().size());
+    for (std::size_t i = 0; i < nodes.size(); i++) {
+        const auto & exp = expected.get_nodes()[i];
+        QCOMPARE(nodes[i].dimension, exp.dimension);
+        QCOMPARE(nodes[i].entity_tag, exp.entity_tag);
+        QCOMPARE(nodes[i].tags, exp.tags);
+        QCOMPARE(nodes[i].coordinates, exp.coordinates);
+    }
+    QCOMPARE(msh.get_min_node_tag(), expected.get_min_node_tag());
+    QCOMPARE(msh.get_max_node_tag(), expected.get_max_node_tag());
+
+    const auto & blocks = msh.get_element_blocks();
+    QCOMPARE(blocks.size(), expected.get_element_blocks().size());
+    for (std::size_t i = 0; i < blocks.size(); i++) {
+        const auto & exp = expected.get_element_blocks()[i];
+        QCOMPARE(blocks[i].dimension, exp.dimension);
+        QCOMPARE(blocks[i].tag, exp.tag);
+        QCOMPARE(blocks[i].element_type, exp.element_type);
+        QCOMPARE(blocks[i].element_tags, exp.element_tags);
+        QCOMPARE(blocks[i].connectivity, exp.connectivity);
+    }
+}
+
+QString
+writeFile(const QTemporaryDir & dir, const QString & name, const QByteArray & contents)
+{
+    auto file_name = dir.filePath(name);
+    QFile file(file_name);
+    file.open(QIODevice::WriteOnly);
+    file.write(contents);
+    file.close();
+    return file_name;
+}
+
+} // namespace
+
+class MshFileTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void
+    testV4Ascii()
+    {
+        QTemporaryDir dir;
+        auto file_name = writeFile(dir, "v4.msh", MSH_V4_ASCII);
+
+        MshFile msh(file_name.toStdString());
+        msh.parse();
+        QCOMPARE(msh.get_version(), 4.1);
+        QVERIFY(msh.is_ascii());
+
+        const auto & names = msh.get_physical_names();
+        QCOMPARE(names.size(), std::size_t(1));
+        QCOMPARE(names[0].name, std::string("surface"));
+
+        const auto & nodes = msh.get_nodes();
+        QCOMPARE(nodes.size(), std::size_t(1));
+        QCOMPARE(nodes[0].size(), std::size_t(4));
+        QCOMPARE(nodes[0].get_coordinates(2).x, 1.);
+        QCOMPARE(nodes[0].get_coordinates(2).y, 1.);
+
+        const auto & blocks = msh.get_element_blocks();
+        QCOMPARE(blocks.size(), std::size_t(1));
+        QCOMPARE(blocks[0].element_type, TRI3);
+        QCOMPARE(blocks[0].size(), std::size_t(2));
+        QCOMPARE(blocks[0].nodes_per_element, 3);
+        QCOMPARE(blocks[0].connectivity, std::vector<int>({ 1, 2, 3, 1, 3, 4 }));
+        auto el = blocks[0].get_element(1);
+        QCOMPARE(el.tag, 2);
+        QCOMPARE(el.node_tags, std::vector<int>({ 1, 3, 4 }));
+    }
+
+    void
+    testV4AsciiParallel()
+    {
+        QTemporaryDir dir;
+        auto file_name = writeFile(dir, "large.msh", buildLargeMshV4());
+
+        MshFile serial(file_name.toStdString());
+        serial.parse();
+        QCOMPARE(serial.get_nodes().size(), std::size_t(2));
+        QCOMPARE(serial.get_nodes()[0].size(), std::size_t(40000));
+        QCOMPARE(serial.get_nodes()[1].get_coordinates(999).x, 40999.);
+        QCOMPARE(serial.get_element_blocks().size(), std::size_t(2));
+        QCOMPARE(serial.get_element_blocks()[1].get_element(998).node_tags,
+                 std::vector<int>({ 40999, 41000 }));
+
+        MshFile msh(file_name.toStdString());
+        msh.set_num_threads(8);
+        msh.parse();
+        compareMeshes(msh, serial);
+    }
+
+    void
+    testV4AsciiParallelError()
+    {
+        QTemporaryDir dir;
+        // in the last job of the first node block
+        auto file_name = writeFile(dir, "bad.msh", buildLargeMshV4(39000));
+
+        MshFile msh(file_name.toStdString());
+        msh.set_num_threads(8);
+        QVERIFY_THROWS_EXCEPTION(Exception, msh.parse());
+    }
+
+    void
+    testProgress()
+    {
+        QTemporaryDir dir;
+        auto file_name = writeFile(dir, "v4.msh", MSH_V4_ASCII);
+
+        MshFile msh(file_name.toStdString());
+        std::vector<std::size_t> reported;
+        std::size_t size = 0;
+        msh.set_progress_callback([&](std::size_t bytes_read, std::size_t file_size) {
+            reported.push_back(bytes_read);
+            size = file_size;
+        });
+        msh.parse();
+
+        QVERIFY(!reported.empty());
+        QVERIFY(std::is_sorted(reported.begin(), reported.end()));
+        QCOMPARE(size, std::size_t(QFileInfo(file_name).size()));
+        QCOMPARE(reported.back(), size);
+    }
+
+    void
+    testV2Ascii()
+    {
+        QTemporaryDir dir;
+        auto file_name = writeFile(dir, "v2.msh", MSH_V2_ASCII);
+
+        MshFile msh(file_name.toStdString());
+        msh.parse();
+        QCOMPARE(msh.get_version(), 2.2);
+
+        const auto & nodes = msh.get_nodes();
+        QCOMPARE(nodes.size(), std::size_t(1));
+        QCOMPARE(nodes[0].tags, std::vector<int>({ 1, 2, 3 }));
+        QCOMPARE(nodes[0].get_coordinates(1).x, 1.5);
+        QCOMPARE(nodes[0].get_coordinates(2).y, 2.5);
+
+        const auto & blocks = msh.get_element_blocks();
+        QCOMPARE(blocks.size(), std::size_t(1));
+        QCOMPARE(blocks[0].tag, 7);
+        QCOMPARE(blocks[0].element_type, TRI3);
+        QCOMPARE(blocks[0].connectivity, std::vector<int>({ 1, 2, 3 }));
+    }
+
+    void
+    testV4Binary()
+    {
+        QTemporaryDir dir;
+        MshFile ascii(writeFile(dir, "ascii.msh", MSH_V4_ASCII).toStdString());
+        ascii.parse();
+
+        // native byte order and the opposite one
+        for (auto swap : { false, true }) {
+            auto file_name = writeFile(dir, "binary.msh", buildMshV4Binary(swap));
+            MshFile msh(file_name.toStdString());
+            msh.parse();
+            QCOMPARE(msh.get_version(), 4.1);
+            QVERIFY(!msh.is_ascii());
+
+            QCOMPARE(msh.get_physical_names().size(), std::size_t(1));
+            const auto & surfaces = msh.get_surface_entities();
+            QCOMPARE(surfaces.size(), std::size_t(1));
+            QCOMPARE(surfaces[0].tag, 1);
+            QCOMPARE(surfaces[0].max_x, 1.);
+            QCOMPARE(surfaces[0].max_y, 1.);
+            QCOMPARE(surfaces[0].physical_tags, std::vector<int>({ 1 }));
+            QVERIFY(surfaces[0].bounding_tags.empty());
+
+            compareMeshes(msh, ascii);
+        }
+    }
+
+    void
+    testV2Binary()
+    {
+        QTemporaryDir dir;
+        MshFile ascii(writeFile(dir, "ascii.msh", MSH_V2_ASCII).toStdString());
+        ascii.parse();
+
+        auto file_name = writeFile(dir, "binary.msh", buildMshV2Binary());
+        MshFile msh(file_name.toStdString());
+        msh.parse();
+        QCOMPARE(msh.get_version(), 2.2);
+        QVERIFY(!msh.is_ascii());
+        compareMeshes(msh, ascii);
+    }
+
+    void
+    testNonExistentFile()
+    {
+        QVERIFY_THROWS_EXCEPTION(Exception, MshFile("non-existent.msh"));
+    }
+};
+
+QTEST_MAIN(MshFileTest)
+
+#include "MshFile_test.moc"
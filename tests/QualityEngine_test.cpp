@@ -0,0 +1,178 @@
+#include <QtTest/QtTest>
+#include "qualityengine.h"
+#include "meshqualitywidget.h"
+#include "vtkUnstructuredGrid.h"
+#include "vtkPoints.h"
+#include "vtkCellData.h"
+#include "vtkDoubleArray.h"
+#include "vtkFloatArray.h"
+#include "vtkCellType.h"
+#include "vtkCellQuality.h"
+#include "vtkDataArray.h"
+#include "vtkSmartPointer.h"
+
+namespace {
+
+const std::vector<int> METRICS = { MESH_METRIC_JACOBIAN,
+                                   MESH_METRIC_AREA,
+                                   MESH_METRIC_ASPECT_RATIO,
+                                   MESH_METRIC_CONDITION,
+                                   MESH_METRIC_VOLUME };
+
+vtkSmartPointer<vtkDataArray>
+computeWithCellQuality(vtkUnstructuredGrid * grid, int metric)
+{
+    auto cell_quality = vtkSmartPointer<vtkCellQuality>::New();
+    switch (metric) {
+    case MESH_METRIC_JACOBIAN:
+        cell_quality->SetQualityMeasureToJacobian();
+        break;
+    case MESH_METRIC_AREA:
+        cell_quality->SetQualityMeasureToArea();
+        break;
+    case MESH_METRIC_ASPECT_RATIO:
+        cell_quality->SetQualityMeasureToAspectRatio();
+        break;
+    case MESH_METRIC_CONDITION:
+        cell_quality->SetQualityMeasureToCondition();
+        break;
+    case MESH_METRIC_VOLUME:
+        cell_quality->SetQualityMeasureToVolume();
+        break;
+    }
+    cell_quality->SetInputData(grid);
+    cell_quality->Update();
+    return cell_quality->GetOutput()->GetCellData()->GetArray("CellQuality");
+}
+
+void
+compareWithCellQuality(QualityEngine & engine,
+                       int block_id,
+                       vtkUnstructuredGrid * grid,
+                       double tolerance = 1e-12)
+{
+    for (auto metric : METRICS) {
+        auto expected = computeWithCellQuality(grid, metric);
+        auto quality = engine.get(block_id, metric);
+        QVERIFY(quality != nullptr);
+        QCOMPARE(quality->GetNumberOfTuples(), grid->GetNumberOfCells());
+        for (vtkIdType i = 0; i < grid->GetNumberOfCells(); i++) {
+            auto value = expected->GetTuple1(i);
+            auto diff = qAbs(quality->GetTuple1(i) - value);
+            QVERIFY(diff <= tolerance * qMax(1., qAbs(value)));
+        }
+    }
+}
+
+/// Grid of n x n x n hexes with perturbed nodes
+vtkSmartPointer<vtkUnstructuredGrid>
+createHexGrid(int n)
+{
+    auto points = vtkSmartPointer<vtkPoints>::New();
+    for (int k = 0; k <= n; k++)
+        for (int j = 0; j <= n; j++)
+            for (int i = 0; i <= n; i++) {
+                double d = 0.1 * ((i * 7 + j * 3 + k * 5) % 4) / 4.;
+                points->InsertNextPoint(i + d, j - d, k + 0.5 * d);
+            }
+
+    auto node = [n](int i, int j, int k) -> vtkIdType {
+        return i + (n + 1) * (j + (n + 1) * k);
+    };
+    auto grid = vtkSmartPointer<vtkUnstructuredGrid>::New();
+    grid->SetPoints(points);
+    for (int k = 0; k < n; k++)
+        for (int j = 0; j < n; j++)
+            for (int i = 0; i < n; i++) {
+                vtkIdType hex[] = { node(i, j, k),         node(i + 1, j, k),
+                                    node(i + 1, j + 1, k), node(i, j + 1, k),
+                                    node(i, j, k + 1),     node(i + 1, j, k + 1),
+                                    node(i + 1, j + 1, k + 1), node(i, j + 1, k + 1) };
+                grid->InsertNextCell(VTK_HEXAHEDRON, 8, hex);
+            }
+    return grid;
+}
+
+} // namespace
+
+class QualityEngineTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void
+    testMatchesCellQuality()
+    {
+        // a distorted hex, a tet, a quad and a triangle
+        auto points = vtkSmartPointer<vtkPoints>::New();
+        double coords[][3] = { { 0, 0, 0 }, { 1.2, 0, 0 }, { 1, 1, 0 },   { 0, 0.9, 0 },
+                               { 0, 0, 1 }, { 1, 0, 1.1 }, { 1, 1, 1 },   { 0.1, 1, 1 },
+                               { 2, 0, 0 }, { 3, 0, 0 },   { 2, 1.5, 0 }, { 2, 0, 0.7 } };
+        for (auto & x : coords)
+            points->InsertNextPoint(x);
+
+        auto grid = vtkSmartPointer<vtkUnstructuredGrid>::New();
+        grid->SetPoints(points);
+        vtkIdType hex[] = { 0, 1, 2, 3, 4, 5, 6, 7 };
+        grid->InsertNextCell(VTK_HEXAHEDRON, 8, hex);
+        vtkIdType tet[] = { 8, 9, 10, 11 };
+        grid->InsertNextCell(VTK_TETRA, 4, tet);
+        vtkIdType quad[] = { 0, 1, 2, 3 };
+        grid->InsertNextCell(VTK_QUAD, 4, quad);
+        vtkIdType tri[] = { 8, 9, 10 };
+        grid->InsertNextCell(VTK_TRIANGLE, 3, tri);
+
+        QualityEngine engine;
+        engine.compute({ { 1, grid } }, METRICS);
+        compareWithCellQuality(engine, 1, grid);
+
+        QVERIFY(engine.get(2, MESH_METRIC_JACOBIAN) == nullptr);
+        engine.clear();
+        QVERIFY(engine.get(1, MESH_METRIC_JACOBIAN) == nullptr);
+    }
+
+    void
+    testHomogeneousBlocks()
+    {
+        // 27 cells, so that the last batch of cells is not full
+        auto hexes = createHexGrid(3);
+
+        // each hex split into 5 tets
+        auto tets = vtkSmartPointer<vtkUnstructuredGrid>::New();
+        tets->SetPoints(hexes->GetPoints());
+        for (vtkIdType c = 0; c < hexes->GetNumberOfCells(); c++) {
+            vtkIdType npts;
+            const vtkIdType * p;
+            hexes->GetCellPoints(c, npts, p);
+            vtkIdType split[5][4] = { { p[0], p[1], p[3], p[4] },
+                                      { p[1], p[2], p[3], p[6] },
+                                      { p[1], p[4], p[5], p[6] },
+                                      { p[3], p[4], p[6], p[7] },
+                                      { p[1], p[3], p[4], p[6] } };
+            for (auto & tet : split)
+                tets->InsertNextCell(VTK_TETRA, 4, tet);
+        }
+
+        QualityEngine engine;
+        engine.compute({ { 1, hexes }, { 2, tets } }, METRICS);
+        compareWithCellQuality(engine, 1, hexes);
+        compareWithCellQuality(engine, 2, tets);
+    }
+
+    void
+    testSinglePrecision()
+    {
+        auto hexes = createHexGrid(3);
+
+        QualityEngine engine;
+        engine.setSinglePrecision(true);
+        QVERIFY(engine.getSinglePrecision());
+        engine.compute({ { 1, hexes } }, METRICS);
+        for (auto metric : METRICS)
+            QVERIFY(vtkFloatArray::SafeDownCast(engine.get(1, metric)) != nullptr);
+        compareWithCellQuality(engine, 1, hexes, 1e-6);
+    }
+};
+
+QTEST_MAIN(QualityEngineTest)
+
+#include "QualityEngine_test.moc"
@@ -0,0 +1,60 @@
+#include <QtTest/QtTest>
+#include <algorithm>
+#include <cmath>
+#include "qualityindex.h"
+#include "qualityengine.h"
+#include "vtkDoubleArray.h"
+#include "vtkSmartPointer.h"
+
+class QualityIndexTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void
+    init()
+    {
+        this->quality = vtkSmartPointer<vtkDoubleArray>::New();
+        this->quality->SetNumberOfTuples(1000);
+        for (vtkIdType i = 0; i < 1000; i++) {
+            if (i % 13 == 0)
+                this->quality->SetValue(i, QualityEngine::UNSUPPORTED);
+            else
+                this->quality->SetValue(i, std::floor(9. * std::sin(0.1 * i)) / 10.);
+        }
+    }
+
+    void
+    testQuery()
+    {
+        QualityIndex index(this->quality);
+        QCOMPARE(index.getNumberOfCells(), (vtkIdType) (1000 - 77));
+
+        for (auto [lo, hi] : std::vector<std::pair<double, double>> {
+                 { -0.5, 0.5 }, { 0.3, 0.3 }, { -2., -0.8 }, { 0.75, 2. }, { -2., 2. } }) {
+            std::vector<vtkIdType> expected;
+            for (vtkIdType i = 0; i < 1000; i++) {
+                auto v = this->quality->GetValue(i);
+                if (v != QualityEngine::UNSUPPORTED && v >= lo && v <= hi)
+                    expected.push_back(i);
+            }
+            QVERIFY(index.query(lo, hi) == expected);
+            QCOMPARE(index.count(lo, hi), (vtkIdType) expected.size());
+        }
+    }
+
+    void
+    testEmptyRange()
+    {
+        QualityIndex index(this->quality);
+        QVERIFY(index.query(0.5, -0.5).empty());
+        QVERIFY(index.query(5., 6.).empty());
+        QCOMPARE(index.count(0.5, -0.5), (vtkIdType) 0);
+    }
+
+private:
+    vtkSmartPointer<vtkDoubleArray> quality;
+};
+
+QTEST_MAIN(QualityIndexTest)
+
+#include "QualityIndex_test.moc"
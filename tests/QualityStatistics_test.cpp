@@ -0,0 +1,123 @@
+#include <QtTest/QtTest>
+#include <algorithm>
+#include <cmath>
+#include "qualitystatistics.h"
+#include "qualityengine.h"
+#include "vtkDoubleArray.h"
+#include "vtkSmartPointer.h"
+
+namespace {
+
+vtkSmartPointer<vtkDoubleArray>
+createQuality(vtkIdType n, int seed)
+{
+    auto quality = vtkSmartPointer<vtkDoubleArray>::New();
+    quality->SetNumberOfTuples(n);
+    for (vtkIdType i = 0; i < n; i++) {
+        if (i % 11 == 0)
+            quality->SetValue(i, QualityEngine::UNSUPPORTED);
+        else
+            quality->SetValue(i, std::sin(0.37 * i + seed) * (1 + (i * seed) % 97));
+    }
+    return quality;
+}
+
+/// Sorted defined values of arrays
+std::vector<double>
+sortedValues(const std::vector<vtkDoubleArray *> & arrays)
+{
+    std::vector<double> values;
+    for (auto * arr : arrays)
+        for (vtkIdType i = 0; i < arr->GetNumberOfTuples(); i++)
+            if (arr->GetValue(i) != QualityEngine::UNSUPPORTED)
+                values.push_back(arr->GetValue(i));
+    std::sort(values.begin(), values.end());
+    return values;
+}
+
+void
+checkSummary(const QualityStatistics::Summary & s,
+             const std::vector<double> & values,
+             bool higher_is_worse)
+{
+    QCOMPARE(s.n_cells, (vtkIdType) values.size());
+    QCOMPARE(s.range[0], values.front());
+    QCOMPARE(s.range[1], values.back());
+
+    vtkIdType total = 0;
+    for (auto count : s.histogram)
+        total += count;
+    QCOMPARE(total, s.n_cells);
+
+    QCOMPARE(s.percentiles.size(), QualityStatistics::PERCENTILES.size());
+    for (std::size_t i = 0; i < s.percentiles.size(); i++) {
+        auto pos = QualityStatistics::PERCENTILES[i] / 100. * (values.size() - 1);
+        auto lo = std::floor(pos);
+        auto v_lo = values[(std::size_t) lo];
+        auto v_hi = values[(std::size_t) std::ceil(pos)];
+        QCOMPARE(s.percentiles[i], v_lo + (pos - lo) * (v_hi - v_lo));
+    }
+
+    QCOMPARE(s.worst.size(), (std::size_t) 10);
+    for (std::size_t i = 0; i < s.worst.size(); i++) {
+        auto expected = higher_is_worse ? values[values.size() - 1 - i] : values[i];
+        QCOMPARE(s.worst[i].value, expected);
+    }
+}
+
+} // namespace
+
+class QualityStatisticsTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void
+    testSmall()
+    {
+        auto q1 = createQuality(1000, 1);
+        auto q2 = createQuality(500, 2);
+
+        QualityStatistics stats(20, 10);
+        stats.compute({ { 1, q1 }, { 2, q2 } }, false);
+        checkSummary(stats.getSummary(), sortedValues({ q1, q2 }), false);
+        checkSummary(*stats.getBlockSummary(1), sortedValues({ q1 }), false);
+        checkSummary(*stats.getBlockSummary(2), sortedValues({ q2 }), false);
+        QVERIFY(stats.getBlockSummary(3) == nullptr);
+
+        auto & worst = stats.getSummary().worst[0];
+        QCOMPARE(worst.value, (worst.block_id == 1 ? q1 : q2)->GetValue(worst.cell_id));
+    }
+
+    void
+    testLarge()
+    {
+        // enough values to find the percentiles by the radix select
+        auto q1 = createQuality(300000, 3);
+        auto q2 = createQuality(100000, 4);
+
+        QualityStatistics stats(20, 10);
+        stats.compute({ { 1, q1 }, { 2, q2 } }, true);
+        checkSummary(stats.getSummary(), sortedValues({ q1, q2 }), true);
+        checkSummary(*stats.getBlockSummary(1), sortedValues({ q1 }), true);
+        checkSummary(*stats.getBlockSummary(2), sortedValues({ q2 }), true);
+    }
+
+    void
+    testEmpty()
+    {
+        auto q = vtkSmartPointer<vtkDoubleArray>::New();
+        q->SetNumberOfTuples(3);
+        q->FillValue(QualityEngine::UNSUPPORTED);
+
+        QualityStatistics stats(20, 10);
+        stats.compute({ { 1, q } }, false);
+        auto & s = stats.getSummary();
+        QCOMPARE(s.n_cells, (vtkIdType) 0);
+        QVERIFY(s.percentiles.empty());
+        QVERIFY(s.worst.empty());
+    }
+};
+
+QTEST_MAIN(QualityStatisticsTest)
+
+#include "QualityStatistics_test.moc"
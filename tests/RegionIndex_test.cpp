@@ -0,0 +1,72 @@
+#include <QtTest/QtTest>
+#include <algorithm>
+#include "regionindex.h"
+#include "vtkMatrix4x4.h"
+#include "vtkSmartPointer.h"
+
+class RegionIndexTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void
+    init()
+    {
+        // 21 x 21 x 21 points spanning [-1.25, 1.25]^3
+        this->coords.clear();
+        for (int k = 0; k <= 20; k++)
+            for (int j = 0; j <= 20; j++)
+                for (int i = 0; i <= 20; i++) {
+                    this->coords.push_back(-1.25 + 0.125 * i);
+                    this->coords.push_back(-1.25 + 0.125 * j);
+                    this->coords.push_back(-1.25 + 0.125 * k);
+                }
+    }
+
+    void
+    testBox()
+    {
+        RegionIndex index(this->coords);
+        QCOMPARE(index.getNumberOfPoints(), (vtkIdType) (21 * 21 * 21));
+
+        RegionIndex::Region region;
+        region.box = true;
+        region.polygon = { { -0.3, -0.1 }, { 0.6, -0.1 }, { 0.6, 0.2 }, { -0.3, 0.2 } };
+        auto identity = vtkSmartPointer<vtkMatrix4x4>::New();
+        auto ids = index.query(identity, region);
+        // x: -0.25 .. 0.5 (7 points), y: 0 .. 0.125 (2 points), z: -1 .. 1 (17 points)
+        QCOMPARE(ids.size(), (std::size_t) 7 * 2 * 17);
+        QVERIFY(std::is_sorted(ids.begin(), ids.end()));
+        for (auto id : ids) {
+            auto * x = &this->coords[3 * id];
+            QVERIFY(x[0] >= -0.3 && x[0] <= 0.6);
+            QVERIFY(x[1] >= -0.1 && x[1] <= 0.2);
+            QVERIFY(x[2] >= -1. && x[2] <= 1.);
+        }
+    }
+
+    void
+    testLasso()
+    {
+        RegionIndex index(this->coords);
+
+        // triangle with vertices at (0, 0), (1, 0) and (0, 1)
+        RegionIndex::Region region;
+        region.box = false;
+        region.polygon = { { -0.01, -0.01 }, { 1.02, -0.01 }, { -0.01, 1.02 } };
+        auto identity = vtkSmartPointer<vtkMatrix4x4>::New();
+        auto ids = index.query(identity, region);
+        // 9 + 8 + ... + 1 points in each of the 17 layers
+        QCOMPARE(ids.size(), (std::size_t) 45 * 17);
+        for (auto id : ids) {
+            auto * x = &this->coords[3 * id];
+            QVERIFY(x[0] >= 0. && x[1] >= 0. && x[0] + x[1] <= 1.);
+        }
+    }
+
+private:
+    std::vector<float> coords;
+};
+
+QTEST_MAIN(RegionIndexTest)
+
+#include "RegionIndex_test.moc"
@@ -0,0 +1,102 @@
+#include <QtTest/QtTest>
+#include <algorithm>
+#include "sliceindex.h"
+#include "vtkUnstructuredGrid.h"
+#include "vtkPoints.h"
+#include "vtkCellType.h"
+#include "vtkSmartPointer.h"
+
+namespace {
+
+/// Cells of an interval index cut by the plane at `offset`, found by testing all cells
+std::vector<vtkIdType>
+findCutCells(const std::vector<double> & intervals, double offset)
+{
+    std::vector<vtkIdType> ids;
+    for (std::size_t i = 0; i < intervals.size() / 2; i++)
+        if (intervals[2 * i] <= offset && offset <= intervals[2 * i + 1])
+            ids.push_back(i);
+    return ids;
+}
+
+} // namespace
+
+class SliceIndexTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void
+    testIntervals()
+    {
+        // cells of various widths, one much wider than the others and one never cut
+        std::vector<double> intervals;
+        for (int i = 0; i < 1000; i++) {
+            double lo = 0.01 * ((i * 37) % 1000);
+            double width = (i % 97 == 0) ? 5. : 0.001 * (i % 30);
+            intervals.push_back(lo);
+            intervals.push_back(lo + width);
+        }
+        intervals[2 * 500] = 1.;
+        intervals[2 * 500 + 1] = 0.;
+
+        double normal[3] = { 0., 0., 1. };
+        SliceIndex index(normal, intervals);
+        QCOMPARE(index.getNumberOfCells(), (vtkIdType) 1000);
+
+        std::vector<double> offsets = { -1., 0., 2.5, 9.99, 10., 14.95, 20. };
+        for (int i = 0; i < 1000; i += 7) {
+            offsets.push_back(intervals[2 * i]);
+            offsets.push_back(intervals[2 * i + 1]);
+        }
+        for (auto offset : offsets) {
+            double origin[3] = { 1., -2., offset };
+            auto ids = index.query(origin);
+            QVERIFY(std::is_sorted(ids.begin(), ids.end()));
+            QCOMPARE(ids, findCutCells(intervals, offset));
+        }
+    }
+
+    void
+    testGrid()
+    {
+        // 10 x 10 unit quads in the xy plane
+        auto points = vtkSmartPointer<vtkPoints>::New();
+        for (int j = 0; j <= 10; j++)
+            for (int i = 0; i <= 10; i++)
+                points->InsertNextPoint(i, j, 0);
+        auto grid = vtkSmartPointer<vtkUnstructuredGrid>::New();
+        grid->SetPoints(points);
+        for (int j = 0; j < 10; j++)
+            for (int i = 0; i < 10; i++) {
+                vtkIdType p = 11 * j + i;
+                vtkIdType quad[] = { p, p + 1, p + 12, p + 11 };
+                grid->InsertNextCell(VTK_QUAD, 4, quad);
+            }
+
+        double normal[3] = { 2., 0., 0. };
+        auto index = SliceIndex::fromCells(grid, normal);
+        QCOMPARE(index->getNumberOfCells(), (vtkIdType) 100);
+        double flipped[3] = { -1., 0., 0. };
+        QVERIFY(index->hasNormal(flipped));
+        double other[3] = { 0., 1., 0. };
+        QVERIFY(!index->hasNormal(other));
+
+        // a plane inside a column of cells
+        double inside[3] = { 3.5, 0., 0. };
+        auto ids = index->query(inside);
+        QCOMPARE(ids.size(), (std::size_t) 10);
+        for (auto id : ids)
+            QCOMPARE(id % 10, (vtkIdType) 3);
+
+        // a plane between two columns cuts both
+        double between[3] = { 3., 7., 0. };
+        QCOMPARE(index->query(between).size(), (std::size_t) 20);
+
+        double outside[3] = { 10.5, 0., 0. };
+        QVERIFY(index->query(outside).empty());
+    }
+};
+
+QTEST_MAIN(SliceIndexTest)
+
+#include "SliceIndex_test.moc"